@@ -270,6 +270,7 @@ lid_switch_sync_initial_state(struct evdev_device *device,
 
 struct evdev_dispatch_interface lid_switch_interface = {
 	lid_switch_process,
+	NULL, /* process_frame */
 	NULL, /* suspend */
 	NULL, /* remove */
 	lid_switch_destroy,
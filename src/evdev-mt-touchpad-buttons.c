@@ -146,15 +146,15 @@ is_inside_top_middle_area(const struct tp_dispatch *tp,
 static void
 tp_button_set_enter_timer(struct tp_dispatch *tp, struct tp_touch *t)
 {
-	libinput_timer_set(&t->button.timer,
-			   t->millis + DEFAULT_BUTTON_ENTER_TIMEOUT);
+	tp_deadline_set(&t->cold->button.timer,
+			t->millis + DEFAULT_BUTTON_ENTER_TIMEOUT);
 }
 
 static void
 tp_button_set_leave_timer(struct tp_dispatch *tp, struct tp_touch *t)
 {
-	libinput_timer_set(&t->button.timer,
-			   t->millis + DEFAULT_BUTTON_LEAVE_TIMEOUT);
+	tp_deadline_set(&t->cold->button.timer,
+			t->millis + DEFAULT_BUTTON_LEAVE_TIMEOUT);
 }
 
 /*
@@ -167,7 +167,7 @@ tp_button_set_state(struct tp_dispatch *tp,
 		    enum button_state new_state,
 		    enum button_event event)
 {
-	libinput_timer_cancel(&t->button.timer);
+	tp_deadline_cancel(&t->cold->button.timer);
 
 	t->button.state = new_state;
 
@@ -457,10 +457,7 @@ tp_button_handle_state(struct tp_dispatch *tp, uint64_t time)
 {
 	struct tp_touch *t;
 
-	tp_for_each_touch(tp, t) {
-		if (t->state == TOUCH_NONE)
-			continue;
-
+	tp_for_each_active_touch(tp, t) {
 		if (t->state == TOUCH_END) {
 			tp_button_handle_event(tp, t, BUTTON_EVENT_UP, time);
 		} else if (t->dirty) {
@@ -877,9 +874,9 @@ tp_init_buttons(struct tp_dispatch *tp,
 
 	tp_for_each_touch(tp, t) {
 		t->button.state = BUTTON_STATE_NONE;
-		libinput_timer_init(&t->button.timer,
-				    tp_libinput_context(tp),
-				    tp_button_handle_timeout, t);
+		tp_deadline_init(tp,
+				 &t->cold->button.timer,
+				 tp_button_handle_timeout, t);
 	}
 }
 
@@ -889,7 +886,7 @@ tp_remove_buttons(struct tp_dispatch *tp)
 	struct tp_touch *t;
 
 	tp_for_each_touch(tp, t)
-		libinput_timer_cancel(&t->button.timer);
+		tp_deadline_cancel(&t->cold->button.timer);
 }
 
 static int
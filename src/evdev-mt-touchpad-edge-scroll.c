@@ -102,8 +102,8 @@ tp_edge_scroll_set_timer(struct tp_dispatch *tp,
 	    LIBINPUT_CONFIG_CLICK_METHOD_BUTTON_AREAS)
 		return;
 
-	libinput_timer_set(&t->scroll.timer,
-			   t->millis + DEFAULT_SCROLL_LOCK_TIMEOUT);
+	tp_deadline_set(&t->cold->scroll.timer,
+			t->millis + DEFAULT_SCROLL_LOCK_TIMEOUT);
 }
 
 static void
@@ -111,7 +111,7 @@ tp_edge_scroll_set_state(struct tp_dispatch *tp,
 			 struct tp_touch *t,
 			 enum tp_edge_scroll_touch_state state)
 {
-	libinput_timer_cancel(&t->scroll.timer);
+	tp_deadline_cancel(&t->cold->scroll.timer);
 
 	t->scroll.edge_state = state;
 
@@ -121,7 +121,7 @@ tp_edge_scroll_set_state(struct tp_dispatch *tp,
 		break;
 	case EDGE_SCROLL_TOUCH_STATE_EDGE_NEW:
 		t->scroll.edge = tp_touch_get_edge(tp, t);
-		t->scroll.initial = t->point;
+		t->cold->scroll.initial = t->point;
 		tp_edge_scroll_set_timer(tp, t);
 		break;
 	case EDGE_SCROLL_TOUCH_STATE_EDGE:
@@ -313,9 +313,9 @@ tp_edge_scroll_init(struct tp_dispatch *tp, struct evdev_device *device)
 
 	tp_for_each_touch(tp, t) {
 		t->scroll.direction = -1;
-		libinput_timer_init(&t->scroll.timer,
-				    tp_libinput_context(tp),
-				    tp_edge_scroll_handle_timeout, t);
+		tp_deadline_init(tp,
+				 &t->cold->scroll.timer,
+				 tp_edge_scroll_handle_timeout, t);
 	}
 }
 
@@ -325,7 +325,7 @@ tp_remove_edge_scroll(struct tp_dispatch *tp)
 	struct tp_touch *t;
 
 	tp_for_each_touch(tp, t)
-		libinput_timer_cancel(&t->scroll.timer);
+		tp_deadline_cancel(&t->cold->scroll.timer);
 }
 
 void
@@ -334,7 +334,8 @@ tp_edge_scroll_handle_state(struct tp_dispatch *tp, uint64_t time)
 	struct tp_touch *t;
 
 	if (tp->scroll.method != LIBINPUT_CONFIG_SCROLL_EDGE) {
-		tp_for_each_touch(tp, t) {
+		/* touches only begin or end while dirty */
+		tp_for_each_dirty_touch(tp, t) {
 			if (t->state == TOUCH_BEGIN)
 				t->scroll.edge_state =
 					EDGE_SCROLL_TOUCH_STATE_AREA;
@@ -345,10 +346,7 @@ tp_edge_scroll_handle_state(struct tp_dispatch *tp, uint64_t time)
 		return;
 	}
 
-	tp_for_each_touch(tp, t) {
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_dirty_touch(tp, t) {
 		switch (t->state) {
 		case TOUCH_NONE:
 		case TOUCH_HOVERING:
@@ -377,10 +375,7 @@ tp_edge_scroll_post_events(struct tp_dispatch *tp, uint64_t time)
 	const struct normalized_coords zero = { 0.0, 0.0 };
 	const struct discrete_coords zero_discrete = { 0.0, 0.0 };
 
-	tp_for_each_touch(tp, t) {
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_dirty_touch(tp, t) {
 		if (t->palm.state != PALM_NONE)
 			continue;
 
@@ -428,7 +423,7 @@ tp_edge_scroll_post_events(struct tp_dispatch *tp, uint64_t time)
 			tmp = normalized;
 			normalized = tp_normalize_delta(tp,
 					device_delta(t->point,
-						     t->scroll.initial));
+						     t->cold->scroll.initial));
 			if (fabs(*delta) < DEFAULT_SCROLL_THRESHOLD)
 				normalized = zero;
 			else
@@ -130,7 +130,7 @@ static void
 tp_gesture_post_pointer_motion(struct tp_dispatch *tp, uint64_t time)
 {
 	struct normalized_coords delta, unaccel;
-	struct device_float_coords raw;
+	struct device_float_coords raw, predicted;
 
 	/* When a clickpad is clicked, combine motion of all active touches */
 	if (tp->buttons.is_clickpad && tp->buttons.state)
@@ -142,10 +142,15 @@ tp_gesture_post_pointer_motion(struct tp_dispatch *tp, uint64_t time)
 
 	if (!normalized_is_zero(delta) || !normalized_is_zero(unaccel)) {
 		raw = tp_unnormalize_for_xaxis(tp, unaccel);
+		evdev_predict_pointer_motion(tp->device,
+					     time,
+					     &raw,
+					     &predicted);
 		pointer_notify_motion(&tp->device->base,
 				      time,
 				      &delta,
-				      &raw);
+				      &raw,
+				      &predicted);
 	}
 }
 
@@ -191,7 +196,7 @@ tp_gesture_get_direction(struct tp_dispatch *tp, struct tp_touch *touch,
 
 	move_threshold *= (nfingers - 1);
 
-	delta = device_delta(touch->point, touch->gesture.initial);
+	delta = device_delta(touch->point, touch->cold->gesture.initial);
 	mm = tp_phys_delta(tp, delta);
 
 	if (length_in_mm(mm) < move_threshold)
@@ -227,8 +232,8 @@ tp_gesture_set_scroll_buildup(struct tp_dispatch *tp)
 	struct tp_touch *first = tp->gesture.touches[0],
 			*second = tp->gesture.touches[1];
 
-	d0 = device_delta(first->point, first->gesture.initial);
-	d1 = device_delta(second->point, second->gesture.initial);
+	d0 = device_delta(first->point, first->cold->gesture.initial);
+	d1 = device_delta(second->point, second->cold->gesture.initial);
 
 	average = device_float_average(d0, d1);
 	tp->device->scroll.buildup = tp_normalize_delta(tp, average);
@@ -287,8 +292,8 @@ tp_gesture_handle_state_none(struct tp_dispatch *tp, uint64_t time)
 	}
 
 	tp->gesture.initial_time = time;
-	first->gesture.initial = first->point;
-	second->gesture.initial = second->point;
+	first->cold->gesture.initial = first->point;
+	second->cold->gesture.initial = second->point;
 	tp->gesture.touches[0] = first;
 	tp->gesture.touches[1] = second;
 
@@ -614,7 +619,7 @@ tp_gesture_handle_state(struct tp_dispatch *tp, uint64_t time)
 		/* Else debounce finger changes */
 		} else if (active_touches != tp->gesture.finger_count_pending) {
 			tp->gesture.finger_count_pending = active_touches;
-			libinput_timer_set(&tp->gesture.finger_count_switch_timer,
+			tp_deadline_set(&tp->gesture.finger_count_switch_timer,
 				time + DEFAULT_GESTURE_SWITCH_TIMEOUT);
 		}
 	} else {
@@ -632,13 +637,13 @@ tp_init_gesture(struct tp_dispatch *tp)
 
 	tp->gesture.state = GESTURE_STATE_NONE;
 
-	libinput_timer_init(&tp->gesture.finger_count_switch_timer,
-			    tp_libinput_context(tp),
-			    tp_gesture_finger_count_switch_timeout, tp);
+	tp_deadline_init(tp,
+			 &tp->gesture.finger_count_switch_timer,
+			 tp_gesture_finger_count_switch_timeout, tp);
 }
 
 void
 tp_remove_gesture(struct tp_dispatch *tp)
 {
-	libinput_timer_cancel(&tp->gesture.finger_count_switch_timer);
+	tp_deadline_cancel(&tp->gesture.finger_count_switch_timer);
 }
@@ -129,19 +129,19 @@ tp_tap_notify(struct tp_dispatch *tp,
 static void
 tp_tap_set_timer(struct tp_dispatch *tp, uint64_t time)
 {
-	libinput_timer_set(&tp->tap.timer, time + DEFAULT_TAP_TIMEOUT_PERIOD);
+	tp_deadline_set(&tp->tap.timer, time + DEFAULT_TAP_TIMEOUT_PERIOD);
 }
 
 static void
 tp_tap_set_drag_timer(struct tp_dispatch *tp, uint64_t time)
 {
-	libinput_timer_set(&tp->tap.timer, time + DEFAULT_DRAG_TIMEOUT_PERIOD);
+	tp_deadline_set(&tp->tap.timer, time + DEFAULT_DRAG_TIMEOUT_PERIOD);
 }
 
 static void
 tp_tap_clear_timer(struct tp_dispatch *tp)
 {
-	libinput_timer_cancel(&tp->tap.timer);
+	tp_deadline_cancel(&tp->tap.timer);
 }
 
 static void
@@ -727,7 +727,7 @@ tp_tap_exceeds_motion_threshold(struct tp_dispatch *tp,
 				struct tp_touch *t)
 {
 	struct phys_coords mm =
-		tp_phys_delta(tp, device_delta(t->point, t->tap.initial));
+		tp_phys_delta(tp, device_delta(t->point, t->cold->tap.initial));
 
 	return length_in_mm(mm) > DEFAULT_TAP_MOVE_THRESHOLD;
 }
@@ -753,8 +753,8 @@ tp_tap_handle_state(struct tp_dispatch *tp, uint64_t time)
 	if (tp->buttons.is_clickpad && tp->queued & TOUCHPAD_EVENT_BUTTON_PRESS)
 		tp_tap_handle_event(tp, NULL, TAP_EVENT_BUTTON, time);
 
-	tp_for_each_touch(tp, t) {
-		if (!t->dirty || t->state == TOUCH_NONE)
+	tp_for_each_dirty_touch(tp, t) {
+		if (t->state == TOUCH_NONE)
 			continue;
 
 		if (tp->buttons.is_clickpad &&
@@ -779,7 +779,7 @@ tp_tap_handle_state(struct tp_dispatch *tp, uint64_t time)
 			}
 
 			t->tap.state = TAP_TOUCH_STATE_TOUCH;
-			t->tap.initial = t->point;
+			t->cold->tap.initial = t->point;
 			tp_tap_handle_event(tp, t, TAP_EVENT_TOUCH, time);
 
 			/* If we think this is a palm, pretend there's a
@@ -861,9 +861,8 @@ tp_tap_handle_timeout(uint64_t time, void *data)
 
 	tp_tap_handle_event(tp, NULL, TAP_EVENT_TIMEOUT, time);
 
-	tp_for_each_touch(tp, t) {
-		if (t->state == TOUCH_NONE ||
-		    t->tap.state == TAP_TOUCH_STATE_IDLE)
+	tp_for_each_active_touch(tp, t) {
+		if (t->tap.state == TAP_TOUCH_STATE_IDLE)
 			continue;
 
 		t->tap.state = TAP_TOUCH_STATE_DEAD;
@@ -1077,15 +1076,15 @@ tp_init_tap(struct tp_dispatch *tp)
 	tp->tap.drag_enabled = tp_drag_default(tp->device);
 	tp->tap.drag_lock_enabled = tp_drag_lock_default(tp->device);
 
-	libinput_timer_init(&tp->tap.timer,
-			    tp_libinput_context(tp),
-			    tp_tap_handle_timeout, tp);
+	tp_deadline_init(tp,
+			 &tp->tap.timer,
+			 tp_tap_handle_timeout, tp);
 }
 
 void
 tp_remove_tap(struct tp_dispatch *tp)
 {
-	libinput_timer_cancel(&tp->tap.timer);
+	tp_deadline_cancel(&tp->tap.timer);
 }
 
 void
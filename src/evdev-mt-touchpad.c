@@ -36,6 +36,125 @@
 #define THUMB_MOVE_TIMEOUT ms2us(300)
 #define FAKE_FINGER_OVERFLOW (1 << 7)
 
+/* The touchpad has up to two timeouts per touch plus a handful of
+ * per-device ones, and most finger events cancel or move one of them.
+ * Rather than updating the context-wide timer heap for each of those,
+ * the deadlines are kept in a small sorted list here and only the
+ * earliest one is registered as a libinput_timer.
+ */
+static void
+tp_deadlines_arm(struct tp_dispatch *tp)
+{
+	struct tp_deadline *first;
+
+	if (list_empty(&tp->deadlines.queue)) {
+		libinput_timer_cancel(&tp->deadlines.timer);
+		return;
+	}
+
+	first = container_of(tp->deadlines.queue.next, first, link);
+	if (first->expire != tp->deadlines.timer.expire)
+		libinput_timer_set(&tp->deadlines.timer, first->expire);
+}
+
+static void
+tp_deadlines_handle_timeout(uint64_t now, void *data)
+{
+	struct tp_dispatch *tp = data;
+	struct tp_deadline *deadline;
+
+	/* Like the timer handler: collect the expired deadlines first so
+	 * one re-set by a func doesn't fire again in this pass, and clear
+	 * each one before its func runs */
+	while (!list_empty(&tp->deadlines.queue)) {
+		deadline = container_of(tp->deadlines.queue.next,
+					deadline,
+					link);
+		if (deadline->expire > now)
+			break;
+
+		list_remove(&deadline->link);
+		deadline->expire = 0;
+		list_insert(tp->deadlines.expired.prev, &deadline->link);
+	}
+
+	tp_deadlines_arm(tp);
+
+	while (!list_empty(&tp->deadlines.expired)) {
+		deadline = container_of(tp->deadlines.expired.next,
+					deadline,
+					link);
+		list_remove(&deadline->link);
+		deadline->func(now, deadline->data);
+	}
+}
+
+static void
+tp_init_deadlines(struct tp_dispatch *tp)
+{
+	list_init(&tp->deadlines.queue);
+	list_init(&tp->deadlines.expired);
+	libinput_timer_init(&tp->deadlines.timer,
+			    tp_libinput_context(tp),
+			    tp_deadlines_handle_timeout, tp);
+}
+
+void
+tp_deadline_init(struct tp_dispatch *tp,
+		 struct tp_deadline *deadline,
+		 void (*func)(uint64_t now, void *data),
+		 void *data)
+{
+	deadline->tp = tp;
+	deadline->link.prev = NULL;
+	deadline->link.next = NULL;
+	deadline->expire = 0;
+	deadline->func = func;
+	deadline->data = data;
+}
+
+void
+tp_deadline_set(struct tp_deadline *deadline, uint64_t expire)
+{
+	struct tp_dispatch *tp = deadline->tp;
+	struct list *pos;
+
+	assert(expire);
+
+	if (deadline->link.next)
+		list_remove(&deadline->link);
+
+	deadline->expire = expire;
+
+	/* insert after the last deadline that expires no later, so equal
+	 * deadlines fire in the order they were set */
+	for (pos = tp->deadlines.queue.prev;
+	     pos != &tp->deadlines.queue;
+	     pos = pos->prev) {
+		struct tp_deadline *d = container_of(pos, d, link);
+
+		if (d->expire <= expire)
+			break;
+	}
+	list_insert(pos, &deadline->link);
+
+	tp_deadlines_arm(tp);
+}
+
+void
+tp_deadline_cancel(struct tp_deadline *deadline)
+{
+	bool queued = deadline->expire != 0;
+
+	if (deadline->link.next)
+		list_remove(&deadline->link);
+
+	deadline->expire = 0;
+
+	if (queued)
+		tp_deadlines_arm(deadline->tp);
+}
+
 static inline struct device_coords *
 tp_motion_history_offset(struct tp_touch *t, int offset)
 {
@@ -94,6 +213,81 @@ tp_motion_history_push(struct tp_touch *t)
 	t->history.index = motion_index;
 }
 
+static inline unsigned int
+tp_motion_smoothing_window(struct tp_touch *t)
+{
+	struct device_coords *last, *prev;
+	struct device_coords delta;
+	struct phys_coords mm;
+	uint64_t tdelta = t->millis - t->smoothing.time;
+	double speed, f;
+
+	if (tdelta == 0)
+		return 1;
+
+	last = tp_motion_history_offset(t, 0);
+	prev = tp_motion_history_offset(t, 1);
+	delta.x = abs(last->x - prev->x);
+	delta.y = abs(last->y - prev->y);
+	mm = evdev_device_unit_delta_to_mm(t->tp->device, &delta);
+	speed = hypot(mm.x, mm.y) / tdelta * ms2us(1000); /* mm/s */
+
+	if (speed <= TOUCHPAD_SMOOTHING_SLOW_SPEED)
+		return TOUCHPAD_HISTORY_LENGTH;
+	if (speed >= TOUCHPAD_SMOOTHING_FAST_SPEED)
+		return 1;
+
+	f = (TOUCHPAD_SMOOTHING_FAST_SPEED - speed) /
+	    (TOUCHPAD_SMOOTHING_FAST_SPEED - TOUCHPAD_SMOOTHING_SLOW_SPEED);
+
+	return 1 + round(f * (TOUCHPAD_HISTORY_LENGTH - 1));
+}
+
+/**
+ * Update the smoothed position of the touch after a history push. The
+ * smoothed position is the mean of the most recent history samples, the
+ * number of samples depends on the touch's speed: slow movements are
+ * averaged over the whole history to filter jitter, fast movements use
+ * fewer samples down to just the last one so they don't lag behind.
+ * Because tp_get_delta() returns the change of the smoothed position, a
+ * shrinking window catches up with the finger rather than dropping
+ * motion.
+ */
+static inline void
+tp_motion_smoothing_update(struct tp_touch *t)
+{
+	struct device_float_coords center = { 0.0, 0.0 };
+	unsigned int window, i;
+
+	if (!t->smoothing.enabled)
+		return;
+
+	if (t->history.count <= 1) {
+		window = 1;
+	} else {
+		window = tp_motion_smoothing_window(t);
+		window = min(window, t->history.count);
+	}
+
+	for (i = 0; i < window; i++) {
+		center.x += tp_motion_history_offset(t, i)->x;
+		center.y += tp_motion_history_offset(t, i)->y;
+	}
+	center.x /= window;
+	center.y /= window;
+
+	if (t->history.count <= 1) {
+		t->smoothing.delta.x = 0.0;
+		t->smoothing.delta.y = 0.0;
+	} else {
+		t->smoothing.delta.x = center.x - t->smoothing.center.x;
+		t->smoothing.delta.y = center.y - t->smoothing.center.y;
+	}
+
+	t->smoothing.center = center;
+	t->smoothing.time = t->millis;
+}
+
 static inline void
 tp_motion_hysteresis(struct tp_dispatch *tp,
 		     struct tp_touch *t)
@@ -212,26 +406,28 @@ tp_new_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 	 * don't know if it's a touch down or not. And BTN_TOUCH may happen
 	 * after ABS_MT_TRACKING_ID */
 	tp_motion_history_reset(t);
-	t->dirty = true;
+	tp_touch_set_dirty(tp, t);
 	t->has_ended = false;
 	t->was_down = false;
 	t->state = TOUCH_HOVERING;
+	tp_touch_set_active(tp, t, true);
 	t->pinned.is_pinned = false;
 	t->millis = time;
+	t->smoothing.enabled = tp->smoothing.enabled;
 	tp->queued |= TOUCHPAD_EVENT_MOTION;
 }
 
 static inline void
 tp_begin_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 {
-	t->dirty = true;
+	tp_touch_set_dirty(tp, t);
 	t->state = TOUCH_BEGIN;
 	t->millis = time;
 	t->was_down = true;
 	tp->nfingers_down++;
-	t->palm.time = time;
+	t->cold->palm.time = time;
 	t->thumb.state = THUMB_STATE_MAYBE;
-	t->thumb.first_touch_time = time;
+	t->cold->thumb.first_touch_time = time;
 	t->tap.is_thumb = false;
 	assert(tp->nfingers_down >= 1);
 }
@@ -245,6 +441,7 @@ tp_end_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 	switch (t->state) {
 	case TOUCH_HOVERING:
 		t->state = TOUCH_NONE;
+		tp_touch_set_active(tp, t, false);
 		/* fallthough */
 	case TOUCH_NONE:
 	case TOUCH_END:
@@ -255,12 +452,12 @@ tp_end_touch(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 
 	}
 
-	t->dirty = true;
+	tp_touch_set_dirty(tp, t);
 	t->palm.state = PALM_NONE;
 	t->state = TOUCH_END;
 	t->pinned.is_pinned = false;
 	t->millis = time;
-	t->palm.time = 0;
+	t->cold->palm.time = 0;
 	assert(tp->nfingers_down >= 1);
 	tp->nfingers_down--;
 	tp->queued |= TOUCHPAD_EVENT_MOTION;
@@ -285,6 +482,9 @@ tp_get_delta(struct tp_touch *t)
 	if (t->history.count <= 1)
 		return zero;
 
+	if (t->smoothing.enabled)
+		return tp_normalize_delta(t->tp, t->smoothing.delta);
+
 	delta.x = tp_motion_history_offset(t, 0)->x -
 		  tp_motion_history_offset(t, 1)->x;
 	delta.y = tp_motion_history_offset(t, 0)->y -
@@ -307,7 +507,7 @@ tp_process_absolute(struct tp_dispatch *tp,
 						  e->value);
 		t->point.x = e->value;
 		t->millis = time;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case ABS_MT_POSITION_Y:
@@ -316,7 +516,7 @@ tp_process_absolute(struct tp_dispatch *tp,
 						  e->value);
 		t->point.y = e->value;
 		t->millis = time;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case ABS_MT_SLOT:
@@ -330,7 +530,7 @@ tp_process_absolute(struct tp_dispatch *tp,
 		break;
 	case ABS_MT_PRESSURE:
 		t->pressure = e->value;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_OTHERAXIS;
 		break;
 	}
@@ -350,7 +550,7 @@ tp_process_absolute_st(struct tp_dispatch *tp,
 						  e->value);
 		t->point.x = e->value;
 		t->millis = time;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case ABS_Y:
@@ -359,12 +559,12 @@ tp_process_absolute_st(struct tp_dispatch *tp,
 						  e->value);
 		t->point.y = e->value;
 		t->millis = time;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_MOTION;
 		break;
 	case ABS_PRESSURE:
 		t->pressure = e->value;
-		t->dirty = true;
+		tp_touch_set_dirty(tp, t);
 		tp->queued |= TOUCHPAD_EVENT_OTHERAXIS;
 		break;
 	}
@@ -564,7 +764,7 @@ tp_palm_detect_dwt_triggered(struct tp_dispatch *tp,
 	    tp->dwt.keyboard_active &&
 	    t->state == TOUCH_BEGIN) {
 		t->palm.state = PALM_TYPING;
-		t->palm.first = t->point;
+		t->cold->palm.first = t->point;
 		return true;
 	} else if (!tp->dwt.keyboard_active &&
 		   t->state == TOUCH_UPDATE &&
@@ -575,8 +775,8 @@ tp_palm_detect_dwt_triggered(struct tp_dispatch *tp,
 		   started once we stop typing will be able to control the
 		   pointer (alas not tap, etc.).
 		   */
-		if (t->palm.time == 0 ||
-		    t->palm.time > tp->dwt.keyboard_last_press_time) {
+		if (t->cold->palm.time == 0 ||
+		    t->cold->palm.time > tp->dwt.keyboard_last_press_time) {
 			t->palm.state = PALM_NONE;
 			log_debug(tp_libinput_context(tp),
 				  "palm: touch released, timeout after typing\n");
@@ -603,8 +803,8 @@ tp_palm_detect_trackpoint_triggered(struct tp_dispatch *tp,
 		   t->state == TOUCH_UPDATE &&
 		   !tp->palm.trackpoint_active) {
 
-		if (t->palm.time == 0 ||
-		    t->palm.time > tp->palm.trackpoint_last_event_time) {
+		if (t->cold->palm.time == 0 ||
+		    t->cold->palm.time > tp->palm.trackpoint_last_event_time) {
 			t->palm.state = PALM_NONE;
 			log_debug(tp_libinput_context(tp),
 				  "palm: touch released, timeout after trackpoint\n");
@@ -624,9 +824,9 @@ tp_palm_detect_move_out_of_edge(struct tp_dispatch *tp,
 	struct device_float_coords delta;
 	int dirs;
 
-	if (time < t->palm.time + PALM_TIMEOUT &&
+	if (time < t->cold->palm.time + PALM_TIMEOUT &&
 	    (t->point.x > tp->palm.left_edge && t->point.x < tp->palm.right_edge)) {
-		delta = device_delta(t->point, t->palm.first);
+		delta = device_delta(t->point, t->cold->palm.first);
 		dirs = phys_get_direction(tp_phys_delta(tp, delta));
 		if ((dirs & DIRECTIONS) && !(dirs & ~DIRECTIONS))
 			return true;
@@ -711,8 +911,8 @@ tp_palm_detect(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 		return;
 
 	t->palm.state = PALM_EDGE;
-	t->palm.time = time;
-	t->palm.first = t->point;
+	t->cold->palm.time = time;
+	t->cold->palm.first = t->point;
 
 out:
 	log_debug(tp_libinput_context(tp),
@@ -752,12 +952,12 @@ tp_thumb_detect(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 
 	/* If the thumb moves by more than 7mm, it's not a resting thumb */
 	if (t->state == TOUCH_BEGIN)
-		t->thumb.initial = t->point;
+		t->cold->thumb.initial = t->point;
 	else if (t->state == TOUCH_UPDATE) {
 		struct device_float_coords delta;
 		struct phys_coords mm;
 
-		delta = device_delta(t->point, t->thumb.initial);
+		delta = device_delta(t->point, t->cold->thumb.initial);
 		mm = tp_phys_delta(tp, delta);
 		if (length_in_mm(mm) > 7) {
 			t->thumb.state = THUMB_STATE_NO;
@@ -775,7 +975,7 @@ tp_thumb_detect(struct tp_dispatch *tp, struct tp_touch *t, uint64_t time)
 		t->thumb.state = THUMB_STATE_YES;
 	else if (t->point.y > tp->thumb.lower_thumb_line &&
 		 tp->scroll.method != LIBINPUT_CONFIG_SCROLL_EDGE &&
-		 t->thumb.first_touch_time + THUMB_MOVE_TIMEOUT < time)
+		 t->cold->thumb.first_touch_time + THUMB_MOVE_TIMEOUT < time)
 		t->thumb.state = THUMB_STATE_YES;
 
 	/* now what? we marked it as thumb, so:
@@ -808,8 +1008,10 @@ tp_unhover_pressure(struct tp_dispatch *tp, uint64_t time)
 	if (nfake_touches == FAKE_FINGER_OVERFLOW)
 		nfake_touches = 0;
 
-	for (i = 0; i < (int)tp->num_slots; i++) {
-		t = tp_get_touch(tp, i);
+	/* touches in TOUCH_NONE have nothing to unhover */
+	tp_for_each_active_touch(tp, t) {
+		if (t - tp->touches >= (int)tp->num_slots)
+			break;
 
 		if (t->dirty) {
 			if (t->state == TOUCH_HOVERING) {
@@ -975,8 +1177,8 @@ tp_position_fake_touches(struct tp_dispatch *tp)
 
 		t->point = topmost->point;
 		t->pressure = topmost->pressure;
-		if (!t->dirty)
-			t->dirty = topmost->dirty;
+		if (topmost->dirty)
+			tp_touch_set_dirty(tp, t);
 	}
 }
 
@@ -1052,7 +1254,6 @@ static void
 tp_process_state(struct tp_dispatch *tp, uint64_t time)
 {
 	struct tp_touch *t;
-	unsigned int i;
 	bool restart_filter = false;
 	bool want_motion_reset;
 
@@ -1062,20 +1263,22 @@ tp_process_state(struct tp_dispatch *tp, uint64_t time)
 
 	want_motion_reset = tp_need_motion_history_reset(tp);
 
-	for (i = 0; i < tp->ntouches; i++) {
-		t = tp_get_touch(tp, i);
-
-		if (want_motion_reset) {
-			tp_motion_history_reset(t);
-			t->quirks.reset_motion_history = true;
-		} else if (t->quirks.reset_motion_history) {
-			tp_motion_history_reset(t);
-			t->quirks.reset_motion_history = false;
+	/* the history of every touch is reset on the frame that wants it
+	 * and on the one after, see tp->quirks.reset_motion_history */
+	if (want_motion_reset || tp->quirks.reset_motion_history) {
+		tp_for_each_touch(tp, t) {
+			if (want_motion_reset) {
+				tp_motion_history_reset(t);
+				t->quirks.reset_motion_history = true;
+			} else if (t->quirks.reset_motion_history) {
+				tp_motion_history_reset(t);
+				t->quirks.reset_motion_history = false;
+			}
 		}
+		tp->quirks.reset_motion_history = want_motion_reset;
+	}
 
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_dirty_touch(tp, t) {
 		if (tp_detect_jumps(tp, t)) {
 			if (!tp->semi_mt)
 				log_bug_kernel(tp_libinput_context(tp),
@@ -1090,6 +1293,7 @@ tp_process_state(struct tp_dispatch *tp, uint64_t time)
 
 		tp_motion_hysteresis(tp, t);
 		tp_motion_history_push(t);
+		tp_motion_smoothing_update(t);
 
 		tp_unpin_finger(tp, t);
 
@@ -1121,21 +1325,19 @@ tp_post_process_state(struct tp_dispatch *tp, uint64_t time)
 {
 	struct tp_touch *t;
 
-	tp_for_each_touch(tp, t) {
-
-		if (!t->dirty)
-			continue;
-
+	tp_for_each_dirty_touch(tp, t) {
 		if (t->state == TOUCH_END) {
-			if (t->has_ended)
+			if (t->has_ended) {
 				t->state = TOUCH_NONE;
-			else
+				tp_touch_set_active(tp, t, false);
+			} else {
 				t->state = TOUCH_HOVERING;
+			}
 		} else if (t->state == TOUCH_BEGIN) {
 			t->state = TOUCH_UPDATE;
 		}
 
-		t->dirty = false;
+		tp_touch_clear_dirty(tp, t);
 	}
 
 	tp->old_nfingers_down = tp->nfingers_down;
@@ -1212,11 +1414,49 @@ tp_interface_process(struct evdev_dispatch *dispatch,
 	}
 }
 
+static void
+tp_interface_process_frame(struct evdev_dispatch *dispatch,
+			   struct evdev_device *device,
+			   struct input_event *events,
+			   size_t nevents,
+			   uint64_t time)
+{
+	struct tp_dispatch *tp = tp_dispatch(dispatch);
+	struct input_event *e = events,
+			   *end = events + nevents;
+
+	if (tp->ignore_events)
+		return;
+
+	while (e < end) {
+		switch (e->type) {
+		case EV_ABS:
+			/* The slot and axis updates make up most of a
+			   frame, apply the whole run in one go */
+			if (tp->has_mt) {
+				for (; e < end && e->type == EV_ABS; e++)
+					tp_process_absolute(tp, e, time);
+			} else {
+				for (; e < end && e->type == EV_ABS; e++)
+					tp_process_absolute_st(tp, e, time);
+			}
+			continue;
+		case EV_KEY:
+			tp_process_key(tp, e, time);
+			break;
+		case EV_SYN:
+			tp_handle_state(tp, time);
+			break;
+		}
+		e++;
+	}
+}
+
 static void
 tp_remove_sendevents(struct tp_dispatch *tp)
 {
-	libinput_timer_cancel(&tp->palm.trackpoint_timer);
-	libinput_timer_cancel(&tp->dwt.keyboard_timer);
+	tp_deadline_cancel(&tp->palm.trackpoint_timer);
+	tp_deadline_cancel(&tp->dwt.keyboard_timer);
 
 	if (tp->buttons.trackpoint &&
 	    tp->palm.monitor_trackpoint)
@@ -1242,6 +1482,10 @@ tp_interface_remove(struct evdev_dispatch *dispatch)
 	tp_remove_sendevents(tp);
 	tp_remove_edge_scroll(tp);
 	tp_remove_gesture(tp);
+
+	/* all deadlines are cancelled by now, this is a no-op unless one
+	 * of them was missed */
+	libinput_timer_cancel(&tp->deadlines.timer);
 }
 
 static void
@@ -1250,6 +1494,9 @@ tp_interface_destroy(struct evdev_dispatch *dispatch)
 	struct tp_dispatch *tp = tp_dispatch(dispatch);
 
 	free(tp->touches);
+	free(tp->touches_cold);
+	free(tp->touches_active);
+	free(tp->touches_dirty);
 	free(tp);
 }
 
@@ -1362,8 +1609,8 @@ tp_trackpoint_event(uint64_t time, struct libinput_event *event, void *data)
 		tp->palm.trackpoint_active = true;
 	}
 
-	libinput_timer_set(&tp->palm.trackpoint_timer,
-			   time + DEFAULT_TRACKPOINT_ACTIVITY_TIMEOUT);
+	tp_deadline_set(&tp->palm.trackpoint_timer,
+			time + DEFAULT_TRACKPOINT_ACTIVITY_TIMEOUT);
 }
 
 static void
@@ -1374,8 +1621,8 @@ tp_keyboard_timeout(uint64_t now, void *data)
 	if (tp->dwt.dwt_enabled &&
 	    long_any_bit_set(tp->dwt.key_mask,
 			     ARRAY_LENGTH(tp->dwt.key_mask))) {
-		libinput_timer_set(&tp->dwt.keyboard_timer,
-				   now + DEFAULT_KEYBOARD_ACTIVITY_TIMEOUT_2);
+		tp_deadline_set(&tp->dwt.keyboard_timer,
+				now + DEFAULT_KEYBOARD_ACTIVITY_TIMEOUT_2);
 		tp->dwt.keyboard_last_press_time = now;
 		log_debug(tp_libinput_context(tp), "palm: keyboard timeout refresh\n");
 		return;
@@ -1482,8 +1729,8 @@ tp_keyboard_event(uint64_t time, struct libinput_event *event, void *data)
 
 	tp->dwt.keyboard_last_press_time = time;
 	long_set_bit(tp->dwt.key_mask, key);
-	libinput_timer_set(&tp->dwt.keyboard_timer,
-			   time + timeout);
+	tp_deadline_set(&tp->dwt.keyboard_timer,
+			time + timeout);
 }
 
 static bool
@@ -1783,6 +2030,7 @@ tp_interface_toggle_touch(struct evdev_dispatch *dispatch,
 
 static struct evdev_dispatch_interface tp_interface = {
 	tp_interface_process,
+	tp_interface_process_frame,
 	tp_interface_suspend,
 	tp_interface_remove,
 	tp_interface_destroy,
@@ -1799,6 +2047,7 @@ tp_init_touch(struct tp_dispatch *tp,
 	      struct tp_touch *t)
 {
 	t->tp = tp;
+	t->cold = &tp->touches_cold[t - tp->touches];
 	t->has_ended = true;
 }
 
@@ -1912,6 +2161,17 @@ tp_init_slots(struct tp_dispatch *tp,
 	if (!tp->touches)
 		return false;
 
+	tp->touches_cold = calloc(tp->ntouches, sizeof(struct tp_touch_cold));
+	if (!tp->touches_cold)
+		return false;
+
+	tp->touches_active = calloc(NLONGS(tp->ntouches),
+				    sizeof(unsigned long));
+	tp->touches_dirty = calloc(NLONGS(tp->ntouches),
+				   sizeof(unsigned long));
+	if (!tp->touches_active || !tp->touches_dirty)
+		return false;
+
 	for (i = 0; i < tp->ntouches; i++)
 		tp_init_touch(tp, &tp->touches[i]);
 
@@ -2154,6 +2414,64 @@ tp_dwt_config_get_default(struct libinput_device *device)
 		LIBINPUT_CONFIG_DWT_DISABLED;
 }
 
+static int
+tp_motion_smoothing_config_is_available(struct libinput_device *device)
+{
+	return 1;
+}
+
+static enum libinput_config_status
+tp_motion_smoothing_config_set(struct libinput_device *device,
+			       enum libinput_config_motion_smoothing_state enable)
+{
+	struct evdev_device *evdev = evdev_device(device);
+	struct tp_dispatch *tp = (struct tp_dispatch*)evdev->dispatch;
+
+	switch(enable) {
+	case LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED:
+	case LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED:
+		break;
+	default:
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+	}
+
+	tp->smoothing.enabled =
+		(enable == LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED);
+
+	return LIBINPUT_CONFIG_STATUS_SUCCESS;
+}
+
+static enum libinput_config_motion_smoothing_state
+tp_motion_smoothing_config_get(struct libinput_device *device)
+{
+	struct evdev_device *evdev = evdev_device(device);
+	struct tp_dispatch *tp = (struct tp_dispatch*)evdev->dispatch;
+
+	return tp->smoothing.enabled ?
+		LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED :
+		LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED;
+}
+
+static enum libinput_config_motion_smoothing_state
+tp_motion_smoothing_config_get_default(struct libinput_device *device)
+{
+	return LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED;
+}
+
+static void
+tp_init_motion_smoothing(struct tp_dispatch *tp,
+			 struct evdev_device *device)
+{
+	tp->smoothing.config.is_available =
+		tp_motion_smoothing_config_is_available;
+	tp->smoothing.config.set_enabled = tp_motion_smoothing_config_set;
+	tp->smoothing.config.get_enabled = tp_motion_smoothing_config_get;
+	tp->smoothing.config.get_default_enabled =
+		tp_motion_smoothing_config_get_default;
+	tp->smoothing.enabled = false;
+	device->base.config.motion_smoothing = &tp->smoothing.config;
+}
+
 static inline bool
 tp_is_tpkb_combo_below(struct evdev_device *device)
 {
@@ -2225,13 +2543,13 @@ static void
 tp_init_sendevents(struct tp_dispatch *tp,
 		   struct evdev_device *device)
 {
-	libinput_timer_init(&tp->palm.trackpoint_timer,
-			    tp_libinput_context(tp),
-			    tp_trackpoint_timeout, tp);
+	tp_deadline_init(tp,
+			 &tp->palm.trackpoint_timer,
+			 tp_trackpoint_timeout, tp);
 
-	libinput_timer_init(&tp->dwt.keyboard_timer,
-			    tp_libinput_context(tp),
-			    tp_keyboard_timeout, tp);
+	tp_deadline_init(tp,
+			 &tp->dwt.keyboard_timer,
+			 tp_keyboard_timeout, tp);
 }
 
 static void
@@ -2422,10 +2740,12 @@ tp_init(struct tp_dispatch *tp,
 	device->dpi = device->abs.absinfo_x->resolution * 25.4;
 
 	tp_init_hysteresis(tp);
+	tp_init_motion_smoothing(tp, device);
 
 	if (!tp_init_accel(tp))
 		return false;
 
+	tp_init_deadlines(tp);
 	tp_init_tap(tp);
 	tp_init_buttons(tp, device);
 	tp_init_dwt(tp, device);
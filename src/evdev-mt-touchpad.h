@@ -33,6 +33,11 @@
 #define TOUCHPAD_HISTORY_LENGTH 4
 #define TOUCHPAD_MIN_SAMPLES 4
 
+/* Motion smoothing averages over the whole history at or below the slow
+ * speed and not at all at or above the fast speed, in mm/s */
+#define TOUCHPAD_SMOOTHING_SLOW_SPEED 30.0
+#define TOUCHPAD_SMOOTHING_FAST_SPEED 150.0
+
 /* Convert mm to a distance normalized to DEFAULT_MOUSE_DPI */
 #define TP_MM_TO_DPI_NORMALIZED(mm) (DEFAULT_MOUSE_DPI/25.4 * mm)
 
@@ -146,6 +151,51 @@ enum tp_thumb_state {
 	THUMB_STATE_MAYBE,
 };
 
+/* A timeout in the touchpad's private deadline queue. All deadlines of a
+ * touchpad share one libinput_timer that is armed for the earliest of
+ * them, see tp_deadline_set() */
+struct tp_deadline {
+	struct tp_dispatch *tp;
+	struct list link; /* queued or expired, NULL otherwise */
+	uint64_t expire; /* in absolute us CLOCK_MONOTONIC, 0 if unset */
+	void (*func)(uint64_t now, void *data);
+	void *data;
+};
+
+/* Per-touch state that is only written when a touch changes state and
+ * read by the feature that owns it. Kept apart from struct tp_touch so
+ * the loops over all touches in every frame only touch the hot data,
+ * see tp_dispatch.touches_cold */
+struct tp_touch_cold {
+	/* Software-button timeout if applicable */
+	struct {
+		struct tp_deadline timer;
+	} button;
+
+	struct {
+		struct device_coords initial;
+	} tap;
+
+	struct {
+		struct tp_deadline timer;
+		struct device_coords initial;
+	} scroll;
+
+	struct {
+		struct device_coords first; /* first coordinates if is_palm == true */
+		uint64_t time; /* first timestamp if is_palm == true */
+	} palm;
+
+	struct {
+		struct device_coords initial;
+	} gesture;
+
+	struct {
+		uint64_t first_touch_time;
+		struct device_coords initial;
+	} thumb;
+};
+
 struct tp_touch {
 	struct tp_dispatch *tp;
 	enum touch_state state;
@@ -175,6 +225,14 @@ struct tp_touch {
 
 	struct device_coords hysteresis_center;
 
+	/* Velocity-adaptive smoothing, see tp_motion_smoothing_update() */
+	struct {
+		bool enabled; /* latched when the touch starts */
+		struct device_float_coords center; /* mean of the window */
+		struct device_float_coords delta; /* change of center */
+		uint64_t time; /* of the previous history sample */
+	} smoothing;
+
 	/* A pinned touchpoint is the one that pressed the physical button
 	 * on a clickpad. After the release, it won't move until the center
 	 * moves more than a threshold away from the original coordinates
@@ -184,17 +242,15 @@ struct tp_touch {
 		struct device_coords center;
 	} pinned;
 
-	/* Software-button state and timeout if applicable */
+	/* Software-button state, the timer is in tp_touch_cold */
 	struct {
 		enum button_state state;
 		/* We use button_event here so we can use == on events */
 		enum button_event curr;
-		struct libinput_timer timer;
 	} button;
 
 	struct {
 		enum tp_tap_touch_state state;
-		struct device_coords initial;
 		bool is_thumb;
 	} tap;
 
@@ -202,25 +258,17 @@ struct tp_touch {
 		enum tp_edge_scroll_touch_state edge_state;
 		uint32_t edge;
 		int direction;
-		struct libinput_timer timer;
-		struct device_coords initial;
 	} scroll;
 
 	struct {
 		enum touch_palm_state state;
-		struct device_coords first; /* first coordinates if is_palm == true */
-		uint64_t time; /* first timestamp if is_palm == true */
 	} palm;
 
-	struct {
-		struct device_coords initial;
-	} gesture;
-
 	struct {
 		enum tp_thumb_state state;
-		uint64_t first_touch_time;
-		struct device_coords initial;
 	} thumb;
+
+	struct tp_touch_cold *cold;
 };
 
 struct tp_dispatch {
@@ -239,6 +287,23 @@ struct tp_dispatch {
 	unsigned int num_slots;			/* number of slots */
 	unsigned int ntouches;			/* no slots inc. fakes */
 	struct tp_touch *touches;		/* len == ntouches */
+	struct tp_touch_cold *touches_cold;	/* len == ntouches */
+
+	/* Bitmasks indexed like touches, len == NLONGS(ntouches). A touch
+	 * is in touches_active while its state is not TOUCH_NONE and in
+	 * touches_dirty while touch->dirty is set, so the per-frame
+	 * passes only visit the touches that need it */
+	unsigned long *touches_active;
+	unsigned long *touches_dirty;
+
+	/* The deadline queue multiplexing all touchpad timeouts onto
+	 * one libinput_timer */
+	struct {
+		struct libinput_timer timer;
+		struct list queue; /* sorted by expiry */
+		struct list expired; /* waiting for their func */
+	} deadlines;
+
 	/* bit 0: BTN_TOUCH
 	 * bit 1: BTN_TOOL_FINGER
 	 * bit 2: BTN_TOOL_DOUBLETAP
@@ -266,7 +331,7 @@ struct tp_dispatch {
 		bool started;
 		unsigned int finger_count;
 		unsigned int finger_count_pending;
-		struct libinput_timer finger_count_switch_timer;
+		struct tp_deadline finger_count_switch_timer;
 		enum tp_gesture_state state;
 		struct tp_touch *touches[2];
 		uint64_t initial_time;
@@ -325,7 +390,7 @@ struct tp_dispatch {
 		struct libinput_device_config_tap config;
 		bool enabled;
 		bool suspended;
-		struct libinput_timer timer;
+		struct tp_deadline timer;
 		enum tp_tap_state state;
 		uint32_t buttons_pressed;
 		uint64_t first_press_time;
@@ -343,7 +408,7 @@ struct tp_dispatch {
 
 		bool trackpoint_active;
 		struct libinput_event_listener trackpoint_listener;
-		struct libinput_timer trackpoint_timer;
+		struct tp_deadline trackpoint_timer;
 		uint64_t trackpoint_last_event_time;
 		uint32_t trackpoint_event_count;
 		bool monitor_trackpoint;
@@ -360,7 +425,7 @@ struct tp_dispatch {
 
 		bool keyboard_active;
 		struct libinput_event_listener keyboard_listener;
-		struct libinput_timer keyboard_timer;
+		struct tp_deadline keyboard_timer;
 		struct evdev_device *keyboard;
 		unsigned long key_mask[NLONGS(KEY_CNT)];
 		unsigned long mod_mask[NLONGS(KEY_CNT)];
@@ -368,6 +433,11 @@ struct tp_dispatch {
 		uint64_t keyboard_last_press_time;
 	} dwt;
 
+	struct {
+		struct libinput_device_config_motion_smoothing config;
+		bool enabled;
+	} smoothing;
+
 	struct {
 		bool detect_thumbs;
 		int threshold;
@@ -384,6 +454,11 @@ struct tp_dispatch {
 		 * event with the jump.
 		 */
 		unsigned int nonmotion_event_count;
+
+		/* The motion history of all touches was reset in the last
+		 * frame and needs to be reset once more, see
+		 * tp_touch.quirks.reset_motion_history */
+		bool reset_motion_history;
 	} quirks;
 
 	struct {
@@ -405,6 +480,62 @@ tp_dispatch(struct evdev_dispatch *dispatch)
 #define tp_for_each_touch(_tp, _t) \
 	for (unsigned int _i = 0; _i < (_tp)->ntouches && (_t = &(_tp)->touches[_i]); _i++)
 
+/**
+ * @return the first touch after t (or the first touch if t is NULL)
+ * whose bit is set in mask, or NULL if there is none
+ */
+static inline struct tp_touch *
+tp_next_touch_in_mask(const struct tp_dispatch *tp,
+		      const unsigned long *mask,
+		      const struct tp_touch *t)
+{
+	unsigned int i = t ? t - tp->touches + 1 : 0;
+	unsigned long bits;
+
+	while (i < tp->ntouches) {
+		bits = mask[i / LONG_BITS] >> (i % LONG_BITS);
+		if (bits) {
+			i += __builtin_ctzl(bits);
+			return i < tp->ntouches ? &tp->touches[i] : NULL;
+		}
+		i = (i / LONG_BITS + 1) * LONG_BITS;
+	}
+
+	return NULL;
+}
+
+#define tp_for_each_touch_in_mask(_tp, _mask, _t) \
+	for (_t = tp_next_touch_in_mask(_tp, _mask, NULL); \
+	     _t; \
+	     _t = tp_next_touch_in_mask(_tp, _mask, _t))
+
+/* Note: active here means state != TOUCH_NONE, unlike tp_touch_active() */
+#define tp_for_each_active_touch(_tp, _t) \
+	tp_for_each_touch_in_mask(_tp, (_tp)->touches_active, _t)
+
+#define tp_for_each_dirty_touch(_tp, _t) \
+	tp_for_each_touch_in_mask(_tp, (_tp)->touches_dirty, _t)
+
+static inline void
+tp_touch_set_dirty(struct tp_dispatch *tp, struct tp_touch *t)
+{
+	t->dirty = true;
+	long_set_bit(tp->touches_dirty, t - tp->touches);
+}
+
+static inline void
+tp_touch_clear_dirty(struct tp_dispatch *tp, struct tp_touch *t)
+{
+	t->dirty = false;
+	long_clear_bit(tp->touches_dirty, t - tp->touches);
+}
+
+static inline void
+tp_touch_set_active(struct tp_dispatch *tp, struct tp_touch *t, bool active)
+{
+	long_set_bit_state(tp->touches_active, t - tp->touches, active);
+}
+
 static inline struct libinput*
 tp_libinput_context(const struct tp_dispatch *tp)
 {
@@ -467,6 +598,19 @@ tp_filter_motion_unaccelerated(struct tp_dispatch *tp,
 bool
 tp_touch_active(const struct tp_dispatch *tp, const struct tp_touch *t);
 
+void
+tp_deadline_init(struct tp_dispatch *tp,
+		 struct tp_deadline *deadline,
+		 void (*func)(uint64_t now, void *data),
+		 void *data);
+
+/* Set the deadline expiry, in absolute us CLOCK_MONOTONIC */
+void
+tp_deadline_set(struct tp_deadline *deadline, uint64_t expire);
+
+void
+tp_deadline_cancel(struct tp_deadline *deadline);
+
 int
 tp_tap_handle_state(struct tp_dispatch *tp, uint64_t time);
 
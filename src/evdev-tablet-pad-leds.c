@@ -503,22 +503,13 @@ static int
 pad_init_leds_from_libwacom(struct pad_dispatch *pad,
 			    struct evdev_device *device)
 {
-	struct libinput *libinput = device->base.seat->libinput;
-	WacomDeviceDatabase *db = NULL;
-	WacomDevice *wacom = NULL;
+	WacomDevice *wacom;
 	int rc = 1;
 
-	db = libwacom_database_new();
-	if (!db) {
-		log_info(libinput,
-			 "Failed to initialize libwacom context.\n");
+	if (!pad->libwacom)
 		goto out;
-	}
 
-	wacom = libwacom_new_from_path(db,
-				       udev_device_get_devnode(device->udev_device),
-				       WFALLBACK_NONE,
-				       NULL);
+	wacom = libinput_libwacom_get_device(device);
 	if (!wacom)
 		goto out;
 
@@ -533,11 +524,6 @@ pad_init_leds_from_libwacom(struct pad_dispatch *pad,
 	pad_init_mode_strips(pad, wacom);
 
 out:
-	if (wacom)
-		libwacom_destroy(wacom);
-	if (db)
-		libwacom_database_destroy(db);
-
 	if (rc != 0)
 		pad_destroy_leds(pad);
 
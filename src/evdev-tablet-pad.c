@@ -499,11 +499,18 @@ pad_destroy(struct evdev_dispatch *dispatch)
 	struct pad_dispatch *pad = pad_dispatch(dispatch);
 
 	pad_destroy_leds(pad);
+
+#if HAVE_LIBWACOM
+	if (pad->libwacom)
+		libinput_libwacom_unref(pad_libinput_context(pad));
+#endif
+
 	free(pad);
 }
 
 static struct evdev_dispatch_interface pad_interface = {
 	pad_process,
+	NULL, /* process_frame */
 	pad_suspend, /* suspend */
 	NULL, /* remove */
 	pad_destroy,
@@ -562,6 +569,10 @@ pad_init(struct pad_dispatch *pad, struct evdev_device *device)
 	pad->status = PAD_NONE;
 	pad->changed_axes = PAD_AXIS_NONE;
 
+#if HAVE_LIBWACOM
+	pad->libwacom = libinput_libwacom_ref(evdev_libinput_context(device));
+#endif
+
 	pad_init_buttons(pad, device);
 	pad_init_left_handed(device);
 	if (pad_init_leds(pad, device) != 0)
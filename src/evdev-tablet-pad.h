@@ -68,6 +68,11 @@ struct pad_dispatch {
 	struct {
 		struct list mode_group_list;
 	} modes;
+
+#if HAVE_LIBWACOM
+	/* Shared per-context, referenced for the lifetime of the device */
+	WacomDeviceDatabase *libwacom;
+#endif
 };
 
 static inline struct pad_dispatch*
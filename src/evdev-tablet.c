@@ -761,20 +761,15 @@ tool_set_bits_from_libwacom(const struct tablet_dispatch *tablet,
 	int rc = 1;
 
 #if HAVE_LIBWACOM
-	struct libinput *libinput = tablet_libinput_context(tablet);
-	WacomDeviceDatabase *db;
 	const WacomStylus *s = NULL;
 	int code;
 	WacomStylusType type;
 	WacomAxisTypeFlags axes;
 
-	db = libwacom_database_new();
-	if (!db) {
-		log_info(libinput,
-			 "Failed to initialize libwacom context.\n");
+	if (!tablet->libwacom)
 		goto out;
-	}
-	s = libwacom_stylus_get_for_id(db, tool->tool_id);
+
+	s = libwacom_stylus_get_for_id(tablet->libwacom, tool->tool_id);
 	if (!s)
 		goto out;
 
@@ -821,8 +816,6 @@ tool_set_bits_from_libwacom(const struct tablet_dispatch *tablet,
 
 	rc = 0;
 out:
-	if (db)
-		libwacom_database_destroy(db);
 #endif
 	return rc;
 }
@@ -1531,6 +1524,11 @@ tablet_destroy(struct evdev_dispatch *dispatch)
 		libinput_tablet_tool_unref(tool);
 	}
 
+#if HAVE_LIBWACOM
+	if (tablet->libwacom)
+		libinput_libwacom_unref(tablet_libinput_context(tablet));
+#endif
+
 	free(tablet);
 }
 
@@ -1602,6 +1600,7 @@ tablet_check_initial_proximity(struct evdev_device *device,
 
 static struct evdev_dispatch_interface tablet_interface = {
 	tablet_process,
+	NULL, /* process_frame */
 	tablet_suspend,
 	NULL, /* remove */
 	tablet_destroy,
@@ -1750,6 +1749,10 @@ tablet_init(struct tablet_dispatch *tablet,
 	if (tablet_reject_device(device))
 		return -1;
 
+#if HAVE_LIBWACOM
+	tablet->libwacom = libinput_libwacom_ref(evdev_libinput_context(device));
+#endif
+
 	tablet_init_calibration(tablet, device);
 	tablet_init_proximity_threshold(tablet, device);
 	rc = tablet_init_accel(tablet, device);
@@ -74,6 +74,11 @@ struct tablet_dispatch {
 
 	/* The paired touch device on devices with both pen & touch */
 	struct evdev_device *touch_device;
+
+#if HAVE_LIBWACOM
+	/* Shared per-context, referenced for the lifetime of the device */
+	WacomDeviceDatabase *libwacom;
+#endif
 };
 
 static inline struct tablet_dispatch*
@@ -49,6 +49,7 @@
 
 #define DEFAULT_WHEEL_CLICK_ANGLE 15
 #define DEFAULT_MIDDLE_BUTTON_SCROLL_TIMEOUT ms2us(200)
+#define PREDICTION_MAX_LOOKAHEAD 50 /* ms */
 
 enum evdev_key_type {
 	EVDEV_KEY_TYPE_NONE,
@@ -132,7 +133,7 @@ hw_is_key_down(struct fallback_dispatch *dispatch, int code)
 static int
 get_key_down_count(struct evdev_device *device, int code)
 {
-	return device->key_count[code];
+	return key_counts_get(&device->key_count, code);
 }
 
 static int
@@ -142,10 +143,20 @@ update_key_down_count(struct evdev_device *device, int code, int pressed)
 	assert(code >= 0 && code < KEY_CNT);
 
 	if (pressed) {
-		key_count = ++device->key_count[code];
+		key_count = key_counts_inc(&device->key_count, code);
+		if (key_count == 0) {
+			log_error(evdev_libinput_context(device),
+				  "%s: failed to track %s, ignoring it\n",
+				  evdev_device_get_sysname(device),
+				  libevdev_event_code_get_name(EV_KEY, code));
+			return -1;
+		}
 	} else {
-		assert(device->key_count[code] > 0);
-		key_count = --device->key_count[code];
+		/* A press we failed to count is ignored, so is its
+		 * release */
+		if (get_key_down_count(device, code) == 0)
+			return -1;
+		key_count = key_counts_dec(&device->key_count, code);
 	}
 
 	if (key_count > 32) {
@@ -309,6 +320,64 @@ evdev_transform_absolute(struct evdev_device *device,
 	matrix_mult_vec(&device->abs.calibration, &point->x, &point->y);
 }
 
+/* Feed the untransformed point of a touch to its predictor, then transform
+ * the point. Returns where the touch is expected to be after the
+ * look-ahead, transformed like the point itself. Without a look-ahead that
+ * is the transformed point */
+static void
+evdev_predict_touch(struct evdev_device *device,
+		    struct motion_predictor *predictor,
+		    uint64_t time,
+		    struct device_coords *point,
+		    struct device_coords *predicted)
+{
+	double x, y;
+
+	if (device->prediction.lookahead == 0) {
+		evdev_transform_absolute(device, point);
+		*predicted = *point;
+		return;
+	}
+
+	motion_predictor_update(predictor, time, point->x, point->y);
+	motion_predictor_predict(predictor,
+				 ms2us(device->prediction.lookahead),
+				 &x, &y);
+	predicted->x = round(x);
+	predicted->y = round(y);
+
+	evdev_transform_absolute(device, predicted);
+	evdev_transform_absolute(device, point);
+}
+
+void
+evdev_predict_pointer_motion(struct evdev_device *device,
+			     uint64_t time,
+			     const struct device_float_coords *raw,
+			     struct device_float_coords *predicted)
+{
+	struct device_float_coords *position = &device->prediction.position;
+	double x, y;
+
+	predicted->x = 0.0;
+	predicted->y = 0.0;
+
+	if (device->prediction.lookahead == 0)
+		return;
+
+	position->x += raw->x;
+	position->y += raw->y;
+	motion_predictor_update(&device->prediction.pointer,
+				time,
+				position->x,
+				position->y);
+	motion_predictor_predict(&device->prediction.pointer,
+				 ms2us(device->prediction.lookahead),
+				 &x, &y);
+	predicted->x = x - position->x;
+	predicted->y = y - position->y;
+}
+
 void
 evdev_transform_relative(struct evdev_device *device,
 			 struct device_coords *point)
@@ -423,7 +492,7 @@ fallback_flush_relative_motion(struct fallback_dispatch *dispatch,
 	struct libinput *libinput = evdev_libinput_context(device);
 	struct libinput_device *base = &device->base;
 	struct normalized_coords accel, unaccel;
-	struct device_float_coords raw;
+	struct device_float_coords raw, predicted;
 
 	if (!(device->seat_caps & EVDEV_DEVICE_POINTER))
 		return;
@@ -456,7 +525,8 @@ fallback_flush_relative_motion(struct fallback_dispatch *dispatch,
 	if (normalized_is_zero(accel) && normalized_is_zero(unaccel))
 		return;
 
-	pointer_notify_motion(base, time, &accel, &raw);
+	evdev_predict_pointer_motion(device, time, &raw, &predicted);
+	pointer_notify_motion(base, time, &accel, &raw, &predicted);
 }
 
 static void
@@ -484,7 +554,7 @@ fallback_flush_mt_down(struct fallback_dispatch *dispatch,
 {
 	struct libinput_device *base = &device->base;
 	struct libinput_seat *seat = base->seat;
-	struct device_coords point;
+	struct device_coords point, predicted;
 	struct mt_slot *slot;
 	int seat_slot;
 
@@ -511,10 +581,11 @@ fallback_flush_mt_down(struct fallback_dispatch *dispatch,
 	seat->slot_map |= 1 << seat_slot;
 	point = slot->point;
 	slot->hysteresis_center = point;
-	evdev_transform_absolute(device, &point);
+	motion_predictor_reset(&slot->predictor);
+	evdev_predict_touch(device, &slot->predictor, time, &point, &predicted);
 
 	touch_notify_touch_down(base, time, slot_idx, seat_slot,
-				&point);
+				&point, &predicted);
 
 	return true;
 }
@@ -526,7 +597,7 @@ fallback_flush_mt_motion(struct fallback_dispatch *dispatch,
 			 uint64_t time)
 {
 	struct libinput_device *base = &device->base;
-	struct device_coords point;
+	struct device_coords point, predicted;
 	struct mt_slot *slot;
 	int seat_slot;
 
@@ -543,9 +614,9 @@ fallback_flush_mt_motion(struct fallback_dispatch *dispatch,
 	if (fallback_filter_defuzz_touch(dispatch, device, slot))
 		return false;
 
-	evdev_transform_absolute(device, &point);
+	evdev_predict_touch(device, &slot->predictor, time, &point, &predicted);
 	touch_notify_touch_motion(base, time, slot_idx, seat_slot,
-				  &point);
+				  &point, &predicted);
 
 	return true;
 }
@@ -585,7 +656,7 @@ fallback_flush_st_down(struct fallback_dispatch *dispatch,
 {
 	struct libinput_device *base = &device->base;
 	struct libinput_seat *seat = base->seat;
-	struct device_coords point;
+	struct device_coords point, predicted;
 	int seat_slot;
 
 	if (!(device->seat_caps & EVDEV_DEVICE_TOUCH))
@@ -610,9 +681,15 @@ fallback_flush_st_down(struct fallback_dispatch *dispatch,
 	seat->slot_map |= 1 << seat_slot;
 
 	point = dispatch->abs.point;
-	evdev_transform_absolute(device, &point);
+	motion_predictor_reset(&dispatch->abs.predictor);
+	evdev_predict_touch(device,
+			    &dispatch->abs.predictor,
+			    time,
+			    &point,
+			    &predicted);
 
-	touch_notify_touch_down(base, time, -1, seat_slot, &point);
+	touch_notify_touch_down(base, time, -1, seat_slot,
+				&point, &predicted);
 
 	return true;
 }
@@ -623,18 +700,23 @@ fallback_flush_st_motion(struct fallback_dispatch *dispatch,
 			 uint64_t time)
 {
 	struct libinput_device *base = &device->base;
-	struct device_coords point;
+	struct device_coords point, predicted;
 	int seat_slot;
 
-	point = dispatch->abs.point;
-	evdev_transform_absolute(device, &point);
-
 	seat_slot = dispatch->abs.seat_slot;
 
 	if (seat_slot == -1)
 		return false;
 
-	touch_notify_touch_motion(base, time, -1, seat_slot, &point);
+	point = dispatch->abs.point;
+	evdev_predict_touch(device,
+			    &dispatch->abs.predictor,
+			    time,
+			    &point,
+			    &predicted);
+
+	touch_notify_touch_motion(base, time, -1, seat_slot,
+				  &point, &predicted);
 
 	return true;
 }
@@ -1091,6 +1173,29 @@ evdev_tag_lid_switch(struct evdev_device *device,
 	device->tags |= EVDEV_TAG_LID_SWITCH;
 }
 
+static void
+fallback_handle_state(struct fallback_dispatch *dispatch,
+		      struct evdev_device *device,
+		      uint64_t time)
+{
+	enum evdev_event_type sent;
+
+	sent = fallback_flush_pending_event(dispatch, device, time);
+	switch (sent) {
+	case EVDEV_ABSOLUTE_TOUCH_DOWN:
+	case EVDEV_ABSOLUTE_TOUCH_UP:
+	case EVDEV_ABSOLUTE_MT_DOWN:
+	case EVDEV_ABSOLUTE_MT_MOTION:
+	case EVDEV_ABSOLUTE_MT_UP:
+		touch_notify_frame(&device->base, time);
+		break;
+	case EVDEV_ABSOLUTE_MOTION:
+	case EVDEV_RELATIVE_MOTION:
+	case EVDEV_NONE:
+		break;
+	}
+}
+
 static void
 fallback_process(struct evdev_dispatch *evdev_dispatch,
 		 struct evdev_device *device,
@@ -1098,7 +1203,6 @@ fallback_process(struct evdev_dispatch *evdev_dispatch,
 		 uint64_t time)
 {
 	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
-	enum evdev_event_type sent;
 
 	if (dispatch->ignore_events)
 		return;
@@ -1114,21 +1218,49 @@ fallback_process(struct evdev_dispatch *evdev_dispatch,
 		fallback_process_key(dispatch, device, event, time);
 		break;
 	case EV_SYN:
-		sent = fallback_flush_pending_event(dispatch, device, time);
-		switch (sent) {
-		case EVDEV_ABSOLUTE_TOUCH_DOWN:
-		case EVDEV_ABSOLUTE_TOUCH_UP:
-		case EVDEV_ABSOLUTE_MT_DOWN:
-		case EVDEV_ABSOLUTE_MT_MOTION:
-		case EVDEV_ABSOLUTE_MT_UP:
-			touch_notify_frame(&device->base, time);
+		fallback_handle_state(dispatch, device, time);
+		break;
+	}
+}
+
+static void
+fallback_process_frame(struct evdev_dispatch *evdev_dispatch,
+		       struct evdev_device *device,
+		       struct input_event *events,
+		       size_t nevents,
+		       uint64_t time)
+{
+	struct fallback_dispatch *dispatch = fallback_dispatch(evdev_dispatch);
+	struct input_event *e = events,
+			   *end = events + nevents;
+
+	if (dispatch->ignore_events)
+		return;
+
+	while (e < end) {
+		switch (e->type) {
+		case EV_REL:
+			for (; e < end && e->type == EV_REL; e++)
+				fallback_process_relative(dispatch,
+							  device,
+							  e,
+							  time);
+			continue;
+		case EV_ABS:
+			for (; e < end && e->type == EV_ABS; e++)
+				fallback_process_absolute(dispatch,
+							  device,
+							  e,
+							  time);
+			continue;
+		case EV_KEY:
+			fallback_process_key(dispatch, device, e, time);
 			break;
-		case EVDEV_ABSOLUTE_MOTION:
-		case EVDEV_RELATIVE_MOTION:
-		case EVDEV_NONE:
+		case EV_SYN:
+			fallback_handle_state(dispatch, device, time);
 			break;
 		}
-		break;
+		e++;
 	}
 }
 
@@ -1300,6 +1432,7 @@ evdev_calibration_get_default_matrix(struct libinput_device *libinput_device,
 
 struct evdev_dispatch_interface fallback_interface = {
 	fallback_process,
+	fallback_process_frame,
 	fallback_suspend,
 	NULL, /* remove */
 	fallback_destroy,
@@ -1659,6 +1792,62 @@ evdev_init_rotation(struct evdev_device *device,
 	device->base.config.rotation = &dispatch->rotation.config;
 }
 
+static int
+evdev_prediction_config_is_available(struct libinput_device *device)
+{
+	/* This function only gets called when we support prediction */
+	return 1;
+}
+
+static enum libinput_config_status
+evdev_prediction_config_set_lookahead(struct libinput_device *libinput_device,
+				      unsigned int lookahead)
+{
+	struct evdev_device *device = evdev_device(libinput_device);
+
+	if (lookahead > PREDICTION_MAX_LOOKAHEAD)
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
+	/* Touch predictors are reset on the next touch down, the pointer
+	 * has no such boundary */
+	device->prediction.lookahead = lookahead;
+	device->prediction.position.x = 0.0;
+	device->prediction.position.y = 0.0;
+	motion_predictor_reset(&device->prediction.pointer);
+
+	return LIBINPUT_CONFIG_STATUS_SUCCESS;
+}
+
+static unsigned int
+evdev_prediction_config_get_lookahead(struct libinput_device *libinput_device)
+{
+	struct evdev_device *device = evdev_device(libinput_device);
+
+	return device->prediction.lookahead;
+}
+
+static unsigned int
+evdev_prediction_config_get_default_lookahead(struct libinput_device *device)
+{
+	return 0;
+}
+
+static void
+evdev_init_prediction(struct evdev_device *device)
+{
+	if (!(device->seat_caps & EVDEV_DEVICE_POINTER) &&
+	    !(device->seat_caps & EVDEV_DEVICE_TOUCH))
+		return;
+
+	device->prediction.config.is_available = evdev_prediction_config_is_available;
+	device->prediction.config.set_lookahead = evdev_prediction_config_set_lookahead;
+	device->prediction.config.get_lookahead = evdev_prediction_config_get_lookahead;
+	device->prediction.config.get_default_lookahead = evdev_prediction_config_get_default_lookahead;
+	device->prediction.lookahead = 0;
+	motion_predictor_reset(&device->prediction.pointer);
+	device->base.config.prediction = &device->prediction.config;
+}
+
 static inline int
 evdev_need_mtdev(struct evdev_device *device)
 {
@@ -1821,6 +2010,18 @@ fallback_dispatch_create(struct libinput_device *libinput_device)
 	return &dispatch->base;
 }
 
+static inline void
+evdev_note_read_latency(struct evdev_device *device, uint64_t time)
+{
+	struct latency_histograms *latency = device->base.latency;
+
+	if (latency->read_time)
+		latency_record(&device->base,
+			       LIBINPUT_LATENCY_KERNEL_TO_READ,
+			       time,
+			       latency->read_time);
+}
+
 static inline void
 evdev_process_event(struct evdev_device *device, struct input_event *e)
 {
@@ -1840,6 +2041,10 @@ evdev_process_event(struct evdev_device *device, struct input_event *e)
 			  e->value);
 #endif
 
+	if (device->base.latency &&
+	    e->type == EV_SYN && e->code == SYN_REPORT)
+		evdev_note_read_latency(device, time);
+
 	dispatch->interface->process(dispatch, device, e, time);
 }
 
@@ -1878,46 +2083,248 @@ evdev_sync_device(struct evdev_device *device)
 	return rc == -EAGAIN ? 0 : rc;
 }
 
-static void
-evdev_device_dispatch(void *data)
+static int
+evdev_device_handle_syn_dropped(struct evdev_device *device,
+				struct input_event *ev)
 {
-	struct evdev_device *device = data;
 	struct libinput *libinput = evdev_libinput_context(device);
+
+	log_info_ratelimit(libinput,
+			   &device->syn_drop_limit,
+			   "SYN_DROPPED event from \"%s\" - some input events have been lost.\n",
+			   device->devname);
+
+	/* send one more sync event so we handle all
+	   currently pending events before we sync up
+	   to the current state */
+	ev->code = SYN_REPORT;
+	evdev_device_dispatch_one(device, ev);
+
+	return evdev_sync_device(device);
+}
+
+/* Returns 0 if the device used up its budget with events left to
+ * process, a negative errno otherwise */
+static int
+evdev_device_dispatch_events(struct evdev_device *device)
+{
 	struct input_event ev;
+	size_t nevents = 0;
+	bool end_of_frame;
 	int rc;
 
-	/* If the compositor is repainting, this function is called only once
-	 * per frame and we have to process all the events available on the
-	 * fd, otherwise there will be input lag. */
 	do {
 		rc = libevdev_next_event(device->evdev,
 					 LIBEVDEV_READ_FLAG_NORMAL, &ev);
 		if (rc == LIBEVDEV_READ_STATUS_SYNC) {
-			log_info_ratelimit(libinput,
-					   &device->syn_drop_limit,
-					   "SYN_DROPPED event from \"%s\" - some input events have been lost.\n",
-					   device->devname);
-
-			/* send one more sync event so we handle all
-			   currently pending events before we sync up
-			   to the current state */
-			ev.code = SYN_REPORT;
-			evdev_device_dispatch_one(device, &ev);
-
-			rc = evdev_sync_device(device);
+			rc = evdev_device_handle_syn_dropped(device, &ev);
 			if (rc == 0)
 				rc = LIBEVDEV_READ_STATUS_SUCCESS;
 		} else if (rc == LIBEVDEV_READ_STATUS_SUCCESS) {
+			end_of_frame = ev.type == EV_SYN &&
+				       ev.code == SYN_REPORT;
 			evdev_device_dispatch_one(device, &ev);
+
+			/* only stop between frames */
+			if (++nevents >= EVDEV_DISPATCH_BUDGET && end_of_frame)
+				return 0;
 		}
 	} while (rc == LIBEVDEV_READ_STATUS_SUCCESS);
 
-	if (rc != -EAGAIN && rc != -EINTR) {
+	return rc;
+}
+
+/* Update libevdev's view of the device with an event read directly off
+ * the fd. Returns false for events libevdev_next_event() would have
+ * discarded, e.g. for disabled event codes */
+static inline bool
+evdev_frame_update_state(struct evdev_device *device,
+			 const struct input_event *e)
+{
+	switch (e->type) {
+	case EV_SYN:
+		return true;
+	case EV_ABS:
+	case EV_KEY:
+	case EV_LED:
+	case EV_SW:
+		return libevdev_set_event_value(device->evdev,
+						e->type,
+						e->code,
+						e->value) == 0;
+	default:
+		return libevdev_has_event_code(device->evdev,
+					       e->type,
+					       e->code);
+	}
+}
+
+static void
+evdev_device_dispatch_frame(struct evdev_device *device,
+			    struct input_event *events,
+			    size_t nevents)
+{
+	struct evdev_dispatch *dispatch = device->dispatch;
+	struct input_event *last;
+	uint64_t time;
+	size_t i;
+
+	if (nevents == 0)
+		return;
+
+	/* Frame reading is never enabled with mtdev, see
+	   evdev_init_frame_reading() */
+	if (!dispatch->interface->process_frame) {
+		for (i = 0; i < nevents; i++)
+			evdev_process_event(device, &events[i]);
+		return;
+	}
+
+	/* A frame cut short by a SYN_DROPPED or a full buffer isn't a
+	   complete kernel frame, don't count it towards the latency */
+	last = &events[nevents - 1];
+	time = s2us(last->time.tv_sec) + last->time.tv_usec;
+	if (device->base.latency &&
+	    last->type == EV_SYN && last->code == SYN_REPORT)
+		evdev_note_read_latency(device, time);
+
+	dispatch->interface->process_frame(dispatch,
+					   device,
+					   events,
+					   nevents,
+					   time);
+}
+
+/* Returns 0 if the device used up its budget with events left to
+ * process, a negative errno otherwise */
+static int
+evdev_device_dispatch_frames(struct evdev_device *device)
+{
+	struct input_event *buffer = device->frame.events;
+	struct input_event *e;
+	size_t count = device->frame.count;
+	size_t nevents, start, kept, i;
+	size_t nread = 0;
+	ssize_t len;
+	int rc = 0;
+
+	do {
+		len = read(device->fd,
+			   buffer + count,
+			   (EVDEV_FRAME_BUFFER_SIZE - count) * sizeof *buffer);
+		if (len < 0) {
+			rc = -errno;
+			break;
+		} else if (len == 0) {
+			rc = -EAGAIN;
+			break;
+		} else if (len % sizeof *buffer != 0) {
+			rc = -EINVAL;
+			break;
+		}
+
+		nevents = count + len/sizeof *buffer;
+		nread += len/sizeof *buffer;
+		start = 0;
+		kept = count;
+
+		for (i = count; i < nevents; i++) {
+			e = &buffer[i];
+
+			if (e->type == EV_SYN && e->code == SYN_DROPPED) {
+				evdev_device_dispatch_frame(device,
+							    buffer + start,
+							    kept - start);
+
+				/* libevdev drains the fd when syncing, the
+				   rest of our buffer is stale */
+				libevdev_next_event(device->evdev,
+						    LIBEVDEV_READ_FLAG_FORCE_SYNC,
+						    e);
+				rc = evdev_device_handle_syn_dropped(device, e);
+				start = kept = 0;
+				break;
+			}
+
+			if (!evdev_frame_update_state(device, e))
+				continue;
+
+			if (kept != i)
+				buffer[kept] = *e;
+			e = &buffer[kept++];
+
+			if (e->type == EV_SYN && e->code == SYN_REPORT) {
+				evdev_device_dispatch_frame(device,
+							    buffer + start,
+							    kept - start);
+				start = kept;
+			}
+		}
+
+		/* Keep an incomplete frame for the next read. If it
+		   doesn't fit into the buffer, process what we have */
+		count = kept - start;
+		if (count == EVDEV_FRAME_BUFFER_SIZE) {
+			evdev_device_dispatch_frame(device, buffer, count);
+			count = 0;
+		} else if (count > 0 && start > 0) {
+			memmove(buffer, buffer + start, count * sizeof *buffer);
+		}
+	} while (rc == 0 && nread < EVDEV_DISPATCH_BUDGET);
+
+	device->frame.count = count;
+
+	return rc;
+}
+
+static void
+evdev_device_dispatch(void *data)
+{
+	struct evdev_device *device = data;
+	struct libinput *libinput = evdev_libinput_context(device);
+	int rc;
+
+	/* If the compositor is repainting, libinput_dispatch() is called
+	 * only once per frame and we have to process all the events
+	 * available on the fd, otherwise there will be input lag. We get
+	 * called again within the same libinput_dispatch() when we stop
+	 * after EVDEV_DISPATCH_BUDGET events. */
+	if (device->base.latency)
+		device->base.latency->read_time = libinput_now(libinput);
+
+	if (device->frame.events)
+		rc = evdev_device_dispatch_frames(device);
+	else
+		rc = evdev_device_dispatch_events(device);
+
+	if (device->base.latency)
+		device->base.latency->read_time = 0;
+
+	if (rc == 0) {
+		/* Out of budget, the remaining events may be buffered by
+		 * libevdev where epoll can't see them */
+		libinput_source_set_pending(libinput, device->source);
+	} else if (rc != -EAGAIN && rc != -EINTR) {
 		libinput_remove_source(libinput, device->source);
 		device->source = NULL;
 	}
 }
 
+static enum libinput_source_priority
+evdev_source_priority(struct evdev_device *device)
+{
+	if (device->seat_caps & (EVDEV_DEVICE_KEYBOARD|EVDEV_DEVICE_SWITCH))
+		return SOURCE_PRIORITY_HIGH;
+
+	if (device->seat_caps & (EVDEV_DEVICE_POINTER|
+				 EVDEV_DEVICE_TOUCH|
+				 EVDEV_DEVICE_TABLET|
+				 EVDEV_DEVICE_GESTURE))
+		return SOURCE_PRIORITY_LOW;
+
+	return SOURCE_PRIORITY_NORMAL;
+}
+
 static inline bool
 evdev_init_accel(struct evdev_device *device,
 		 enum libinput_config_accel_profile which)
@@ -2844,6 +3251,23 @@ evdev_pre_configure_model_quirks(struct evdev_device *device)
 		libevdev_set_abs_maximum(device->evdev, ABS_MT_SLOT, 1);
 }
 
+static void
+evdev_init_frame_reading(struct evdev_device *device)
+{
+	if (!parse_udev_flag(device,
+			     device->udev_device,
+			     "LIBINPUT_ATTR_READ_FRAMES"))
+		return;
+
+	/* mtdev needs to see every event, use the normal path */
+	if (device->mtdev)
+		return;
+
+	device->frame.events = zalloc(EVDEV_FRAME_BUFFER_SIZE *
+				      sizeof *device->frame.events);
+	device->frame.count = 0;
+}
+
 struct evdev_device *
 evdev_device_create(struct libinput_seat *seat,
 		    struct udev_device *udev_device)
@@ -2919,10 +3343,15 @@ evdev_device_create(struct libinput_seat *seat,
 		goto err;
 	}
 
+	evdev_init_frame_reading(device);
+	evdev_init_prediction(device);
+
 	device->source =
 		libinput_add_fd(libinput, fd, evdev_device_dispatch, device);
 	if (!device->source)
 		goto err;
+	libinput_source_set_priority(device->source,
+				     evdev_source_priority(device));
 
 	if (!evdev_set_device_group(device, udev_device))
 		goto err;
@@ -3323,6 +3752,8 @@ evdev_device_suspend(struct evdev_device *device)
 		close_restricted(libinput, device->fd);
 		device->fd = -1;
 	}
+
+	device->frame.count = 0;
 }
 
 int
@@ -3382,6 +3813,8 @@ evdev_device_resume(struct evdev_device *device)
 		mtdev_close_delete(device->mtdev);
 		return -ENOMEM;
 	}
+	libinput_source_set_priority(device->source,
+				     evdev_source_priority(device));
 
 	evdev_notify_resumed_device(device);
 
@@ -3430,6 +3863,8 @@ evdev_device_destroy(struct evdev_device *device)
 		libinput_device_group_unref(device->base.group);
 
 	free(device->output_name);
+	free(device->frame.events);
+	key_counts_release(&device->key_count);
 	filter_destroy(device->pointer.filter);
 	libinput_seat_unref(device->base.seat);
 	libevdev_free(device->evdev);
@@ -3437,50 +3872,158 @@ evdev_device_destroy(struct evdev_device *device)
 	free(device);
 }
 
-bool
-evdev_tablet_has_left_handed(struct evdev_device *device)
-{
-	bool has_left_handed = false;
 #if HAVE_LIBWACOM
-	struct libinput *libinput = evdev_libinput_context(device);
+struct libwacom_device_entry {
+	struct list link;
+	int bustype;
+	int vendor;
+	int product;
+	WacomDevice *wacom; /* NULL if libwacom doesn't know the device */
+};
+
+struct libwacom_cache {
 	WacomDeviceDatabase *db;
-	WacomDevice *d = NULL;
+	int refcount;
+	struct list devices; /* struct libwacom_device_entry */
+};
+
+/**
+ * Take a reference to the libwacom database shared by all devices in
+ * this context. The database is loaded on the first reference, loading
+ * it is expensive enough that we don't want to do it once per device
+ * node. Returns NULL if libwacom failed to initialize, in which case no
+ * reference is taken.
+ */
+WacomDeviceDatabase *
+libinput_libwacom_ref(struct libinput *libinput)
+{
+	struct libwacom_cache *cache = libinput->libwacom;
+
+	if (!cache) {
+		cache = zalloc(sizeof *cache);
+		if (!cache)
+			return NULL;
+
+		cache->db = libwacom_database_new();
+		if (!cache->db) {
+			log_info(libinput,
+				 "Failed to initialize libwacom context.\n");
+			free(cache);
+			return NULL;
+		}
+
+		list_init(&cache->devices);
+		libinput->libwacom = cache;
+	}
+
+	cache->refcount++;
+
+	return cache->db;
+}
+
+void
+libinput_libwacom_unref(struct libinput *libinput)
+{
+	struct libwacom_cache *cache = libinput->libwacom;
+	struct libwacom_device_entry *entry, *tmp;
+
+	assert(cache);
+	assert(cache->refcount > 0);
+
+	if (--cache->refcount > 0)
+		return;
+
+	list_for_each_safe(entry, tmp, &cache->devices, link) {
+		if (entry->wacom)
+			libwacom_destroy(entry->wacom);
+		list_remove(&entry->link);
+		free(entry);
+	}
+
+	libwacom_database_destroy(cache->db);
+	free(cache);
+	libinput->libwacom = NULL;
+}
+
+/**
+ * Look up the libwacom device for this evdev device. Lookups are cached
+ * per bus/vid/pid so the various event nodes of one tablet only parse
+ * the database once. The caller must hold a reference to the database,
+ * the returned device is owned by the cache and must not be destroyed.
+ */
+WacomDevice *
+libinput_libwacom_get_device(struct evdev_device *device)
+{
+	struct libinput *libinput = evdev_libinput_context(device);
+	struct libwacom_cache *cache = libinput->libwacom;
+	struct libwacom_device_entry *entry;
 	WacomError *error;
 	const char *devnode;
+	int bustype, vendor, product;
 
-	db = libwacom_database_new();
-	if (!db) {
-		log_info(libinput,
-			 "Failed to initialize libwacom context.\n");
-		goto out;
+	assert(cache);
+
+	bustype = libevdev_get_id_bustype(device->evdev);
+	vendor = libevdev_get_id_vendor(device->evdev);
+	product = libevdev_get_id_product(device->evdev);
+
+	list_for_each(entry, &cache->devices, link) {
+		if (entry->bustype == bustype &&
+		    entry->vendor == vendor &&
+		    entry->product == product)
+			return entry->wacom;
 	}
 
-	error = libwacom_error_new();
-	devnode = udev_device_get_devnode(device->udev_device);
+	entry = zalloc(sizeof *entry);
+	if (!entry)
+		return NULL;
 
-	d = libwacom_new_from_path(db,
-				   devnode,
-				   WFALLBACK_NONE,
-				   error);
+	entry->bustype = bustype;
+	entry->vendor = vendor;
+	entry->product = product;
 
-	if (d) {
-		if (libwacom_is_reversible(d))
-			has_left_handed = true;
-	} else if (libwacom_error_get_code(error) == WERROR_UNKNOWN_MODEL) {
-		log_info(libinput,
-			 "%s: tablet unknown to libwacom\n",
-			 device->devname);
-	} else {
-		log_error(libinput,
-			  "libwacom error: %s\n",
-			  libwacom_error_get_message(error));
+	error = libwacom_error_new();
+	devnode = udev_device_get_devnode(device->udev_device);
+	entry->wacom = libwacom_new_from_path(cache->db,
+					      devnode,
+					      WFALLBACK_NONE,
+					      error);
+	if (!entry->wacom) {
+		if (libwacom_error_get_code(error) == WERROR_UNKNOWN_MODEL) {
+			log_info(libinput,
+				 "%s: tablet unknown to libwacom\n",
+				 device->devname);
+		} else {
+			log_error(libinput,
+				  "libwacom error: %s\n",
+				  libwacom_error_get_message(error));
+		}
 	}
-
 	if (error)
 		libwacom_error_free(&error);
-	if (d)
-		libwacom_destroy(d);
-	libwacom_database_destroy(db);
+
+	list_insert(&cache->devices, &entry->link);
+
+	return entry->wacom;
+}
+#endif
+
+bool
+evdev_tablet_has_left_handed(struct evdev_device *device)
+{
+	bool has_left_handed = false;
+#if HAVE_LIBWACOM
+	struct libinput *libinput = evdev_libinput_context(device);
+	WacomDevice *d;
+
+	if (!libinput_libwacom_ref(libinput))
+		goto out;
+
+	d = libinput_libwacom_get_device(device);
+	if (d && libwacom_is_reversible(d))
+		has_left_handed = true;
+
+	libinput_libwacom_unref(libinput);
 
 out:
 #endif
@@ -31,6 +31,9 @@
 #include <stdbool.h>
 #include "linux/input.h"
 #include <libevdev/libevdev.h>
+#if HAVE_LIBWACOM
+#include <libwacom/libwacom.h>
+#endif
 
 #include "libinput-private.h"
 #include "timer.h"
@@ -45,6 +48,13 @@
 /* The fake resolution value for abs devices without resolution */
 #define EVDEV_FAKE_RESOLUTION 1
 
+/* Size of the per-device buffer for reading whole frames off the fd */
+#define EVDEV_FRAME_BUFFER_SIZE 256
+
+/* Events a device processes per libinput_dispatch() round before other
+ * devices get their turn */
+#define EVDEV_DISPATCH_BUDGET 64
+
 enum evdev_event_type {
 	EVDEV_NONE,
 	EVDEV_ABSOLUTE_TOUCH_DOWN,
@@ -132,6 +142,7 @@ struct mt_slot {
 	int32_t seat_slot;
 	struct device_coords point;
 	struct device_coords hysteresis_center;
+	struct motion_predictor predictor;
 };
 
 struct evdev_device {
@@ -156,6 +167,13 @@ struct evdev_device {
 	uint32_t model_flags;
 	struct mtdev *mtdev;
 
+	/* Only allocated if events are read off the fd in whole frames,
+	 * bypassing libevdev_next_event() */
+	struct {
+		struct input_event *events;
+		size_t count; /* events of an incomplete frame */
+	} frame;
+
 	struct {
 		const struct input_absinfo *absinfo_x, *absinfo_y;
 		bool is_fake_resolution;
@@ -212,7 +230,7 @@ struct evdev_device {
 
 	/* Key counter used for multiplexing button events internally in
 	 * libinput. */
-	uint8_t key_count[KEY_CNT];
+	struct key_counts key_count;
 
 	struct {
 		struct libinput_device_config_left_handed config;
@@ -236,6 +254,15 @@ struct evdev_device {
 		uint32_t button_mask;
 		uint64_t first_event_time;
 	} middlebutton;
+
+	struct {
+		struct libinput_device_config_prediction config;
+		unsigned int lookahead; /* ms, 0 is disabled */
+		/* relative motion is predicted on the sum of its
+		 * unaccelerated deltas */
+		struct device_float_coords position;
+		struct motion_predictor pointer;
+	} prediction;
 };
 
 static inline struct evdev_device *
@@ -257,6 +284,16 @@ struct evdev_dispatch_interface {
 			struct input_event *event,
 			uint64_t time);
 
+	/* Process a frame of evdev input events, usually terminated by
+	 * the EV_SYN/SYN_REPORT. All events carry the frame's timestamp.
+	 * May be NULL, the events are then passed to process() one by
+	 * one. */
+	void (*process_frame)(struct evdev_dispatch *dispatch,
+			      struct evdev_device *device,
+			      struct input_event *events,
+			      size_t nevents,
+			      uint64_t time);
+
 	/* Device is being suspended */
 	void (*suspend)(struct evdev_dispatch *dispatch,
 			struct evdev_device *device);
@@ -334,6 +371,7 @@ struct fallback_dispatch {
 	struct {
 		struct device_coords point;
 		int32_t seat_slot;
+		struct motion_predictor predictor;
 
 		struct {
 			struct device_coords min, max;
@@ -384,6 +422,12 @@ void
 evdev_transform_relative(struct evdev_device *device,
 			 struct device_coords *point);
 
+void
+evdev_predict_pointer_motion(struct evdev_device *device,
+			     uint64_t time,
+			     const struct device_float_coords *raw,
+			     struct device_float_coords *predicted);
+
 void
 evdev_init_calibration(struct evdev_device *device,
 		        struct libinput_device_config_calibration *calibration);
@@ -578,6 +622,17 @@ evdev_init_left_handed(struct evdev_device *device,
 bool
 evdev_tablet_has_left_handed(struct evdev_device *device);
 
+#if HAVE_LIBWACOM
+WacomDeviceDatabase *
+libinput_libwacom_ref(struct libinput *libinput);
+
+void
+libinput_libwacom_unref(struct libinput *libinput);
+
+WacomDevice *
+libinput_libwacom_get_device(struct evdev_device *device);
+#endif
+
 static inline uint32_t
 evdev_to_left_handed(struct evdev_device *device,
 		     uint32_t button)
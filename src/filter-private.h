@@ -38,6 +38,14 @@ struct motion_filter_interface {
 			   struct motion_filter *filter,
 			   const struct device_float_coords *unaccelerated,
 			   void *data, uint64_t time);
+	/* optional, filter_dispatch_batch() falls back to calling
+	 * filter() for each delta */
+	void (*filter_batch)(struct motion_filter *filter,
+			     const struct device_float_coords *unaccelerated,
+			     const uint64_t *time,
+			     struct normalized_coords *accelerated,
+			     size_t count,
+			     void *data);
 	void (*restart)(struct motion_filter *filter,
 			void *data,
 			uint64_t time);
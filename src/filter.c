@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include <limits.h>
 #include <math.h>
 
@@ -89,6 +90,33 @@ filter_dispatch_constant(struct motion_filter *filter,
 	return filter->interface->filter_constant(filter, unaccelerated, data, time);
 }
 
+void
+filter_dispatch_batch(struct motion_filter *filter,
+		      const struct device_float_coords *unaccelerated,
+		      const uint64_t *time,
+		      struct normalized_coords *accelerated,
+		      size_t count,
+		      void *data)
+{
+	size_t i;
+
+	if (filter->interface->filter_batch) {
+		filter->interface->filter_batch(filter,
+						unaccelerated,
+						time,
+						accelerated,
+						count,
+						data);
+		return;
+	}
+
+	for (i = 0; i < count; i++)
+		accelerated[i] = filter->interface->filter(filter,
+							   &unaccelerated[i],
+							   data,
+							   time[i]);
+}
+
 void
 filter_restart(struct motion_filter *filter,
 	       void *data, uint64_t time)
@@ -154,9 +182,11 @@ filter_get_type(struct motion_filter *filter)
 #define MAX_VELOCITY_DIFF	v_ms2us(1) /* units/us */
 #define MOTION_TIMEOUT		ms2us(1000)
 #define NUM_POINTER_TRACKERS	16
+#define ACCEL_LUT_SIZE		256
+#define ACCEL_LUT_MAX_VELOCITY	v_ms2us(1000) /* units/us */
 
 struct pointer_tracker {
-	struct device_float_coords delta; /* delta to most recent event */
+	struct device_float_coords pos; /* accumulated position */
 	uint64_t time;  /* us */
 	uint32_t dir;
 };
@@ -177,6 +207,16 @@ struct pointer_accelerator {
 	double incline;		/* incline of the function */
 
 	int dpi;
+
+	/* The profile sampled at evenly spaced velocities, rebuilt
+	 * whenever the profile parameters change. See
+	 * accelerator_build_lut() */
+	struct {
+		double factors[ACCEL_LUT_SIZE + 1];
+		/* cells that contain a kink in the profile */
+		unsigned char kinks[NCHARS(ACCEL_LUT_SIZE)];
+		double scale; /* cells per units/us */
+	} lut;
 };
 
 struct pointer_accelerator_flat {
@@ -195,6 +235,69 @@ struct tablet_accelerator_flat {
 	       yres_scale; /* 1000dpi : tablet res */
 };
 
+static inline double
+accelerator_lut_interpolate(struct pointer_accelerator *accel,
+			    unsigned int cell,
+			    double pos)
+{
+	double f0 = accel->lut.factors[cell],
+	       f1 = accel->lut.factors[cell + 1];
+
+	return f0 + (f1 - f0) * (pos - cell);
+}
+
+/**
+ * Sample the acceleration profile into the lookup table. All our profiles
+ * are piecewise linear and capped at a maximum factor, so the table only
+ * needs to cover the velocities up to that cap and linear interpolation
+ * between two samples is exact unless the cell contains a kink. Those
+ * cells are marked and fall back to the profile function.
+ *
+ * Must be called whenever a parameter of the profile changes.
+ */
+static void
+accelerator_build_lut(struct pointer_accelerator *accel)
+{
+	struct motion_filter *filter = &accel->base;
+	double max_factor, lo, hi, mid, step;
+	double pos, expected;
+	unsigned int i, j;
+
+	/* Find the velocity at which the profile reaches its maximum */
+	max_factor = accel->profile(filter, NULL, ACCEL_LUT_MAX_VELOCITY, 0);
+	lo = 0.0;
+	hi = ACCEL_LUT_MAX_VELOCITY;
+	for (i = 0; i < 64; i++) {
+		mid = (lo + hi) / 2;
+		if (accel->profile(filter, NULL, mid, 0) >= max_factor)
+			hi = mid;
+		else
+			lo = mid;
+	}
+
+	step = hi / ACCEL_LUT_SIZE;
+	accel->lut.scale = 1.0 / step;
+
+	for (i = 0; i <= ACCEL_LUT_SIZE; i++)
+		accel->lut.factors[i] = accel->profile(filter,
+						       NULL,
+						       i * step,
+						       0);
+
+	memset(accel->lut.kinks, 0, sizeof(accel->lut.kinks));
+	for (i = 0; i < ACCEL_LUT_SIZE; i++) {
+		for (j = 1; j < 4; j++) {
+			pos = i + j/4.0;
+			expected = accel->profile(filter, NULL, pos * step, 0);
+			if (fabs(accelerator_lut_interpolate(accel, i, pos) -
+				 expected) > 1e-9) {
+				set_bit(accel->lut.kinks, i);
+				break;
+			}
+		}
+	}
+}
+
 static void
 feed_trackers(struct pointer_accelerator *accel,
 	      const struct device_float_coords *delta,
@@ -202,17 +305,33 @@ feed_trackers(struct pointer_accelerator *accel,
 {
 	int i, current;
 	struct pointer_tracker *trackers = accel->trackers;
+	struct device_float_coords pos;
 
-	for (i = 0; i < NUM_POINTER_TRACKERS; i++) {
-		trackers[i].delta.x += delta->x;
-		trackers[i].delta.y += delta->y;
-	}
+	/* Each tracker stores the accumulated position at the time of its
+	 * event, the delta from a tracker to the most recent event is the
+	 * difference between the two positions. */
+	pos = trackers[accel->cur_tracker].pos;
+	pos.x += delta->x;
+	pos.y += delta->y;
 
 	current = (accel->cur_tracker + 1) % NUM_POINTER_TRACKERS;
 	accel->cur_tracker = current;
 
-	trackers[current].delta.x = 0.0;
-	trackers[current].delta.y = 0.0;
+	/* Re-base all positions once per wraparound so the accumulated
+	 * values stay small. The differences are only exact for integer
+	 * normalized deltas (i.e. mice at 1000dpi), otherwise they may be
+	 * off by a rounding error compared to summing up the deltas per
+	 * tracker. */
+	if (current == 0) {
+		for (i = 0; i < NUM_POINTER_TRACKERS; i++) {
+			trackers[i].pos.x -= pos.x;
+			trackers[i].pos.y -= pos.y;
+		}
+		pos.x = 0.0;
+		pos.y = 0.0;
+	}
+
+	trackers[current].pos = pos;
 	trackers[current].time = time;
 	trackers[current].dir = device_float_get_direction(*delta);
 }
@@ -227,14 +346,21 @@ tracker_by_offset(struct pointer_accelerator *accel, unsigned int offset)
 }
 
 static double
-calculate_tracker_velocity(struct pointer_tracker *tracker, uint64_t time)
+calculate_tracker_velocity(struct pointer_accelerator *accel,
+			   struct pointer_tracker *tracker,
+			   uint64_t time)
 {
+	struct pointer_tracker *current = tracker_by_offset(accel, 0);
 	double tdelta = time - tracker->time + 1;
-	return hypot(tracker->delta.x, tracker->delta.y) / tdelta; /* units/us */
+	double dx = current->pos.x - tracker->pos.x;
+	double dy = current->pos.y - tracker->pos.y;
+
+	return hypot(dx, dy) / tdelta; /* units/us */
 }
 
 static inline double
-calculate_velocity_after_timeout(struct pointer_tracker *tracker)
+calculate_velocity_after_timeout(struct pointer_accelerator *accel,
+				 struct pointer_tracker *tracker)
 {
 	/* First movement after timeout needs special handling.
 	 *
@@ -247,7 +373,8 @@ calculate_velocity_after_timeout(struct pointer_tracker *tracker)
 	 * for really slow movements but provides much more useful initial
 	 * movement in normal use-cases (pause, move, pause, move)
 	 */
-	return calculate_tracker_velocity(tracker,
+	return calculate_tracker_velocity(accel,
+					  tracker,
 					  tracker->time + MOTION_TIMEOUT);
 }
 
@@ -282,22 +409,25 @@ calculate_velocity(struct pointer_accelerator *accel, uint64_t time)
 		/* Stop if too far away in time */
 		if (time - tracker->time > MOTION_TIMEOUT) {
 			if (offset == 1)
-				result = calculate_velocity_after_timeout(tracker);
+				result = calculate_velocity_after_timeout(accel,
+									  tracker);
 			break;
 		}
 
-		velocity = calculate_tracker_velocity(tracker, time);
-
 		/* Stop if direction changed */
 		dir &= tracker->dir;
 		if (dir == 0) {
 			/* First movement after dirchange - velocity is that
 			 * of the last movement */
 			if (offset == 1)
-				result = velocity;
+				result = calculate_tracker_velocity(accel,
+								    tracker,
+								    time);
 			break;
 		}
 
+		velocity = calculate_tracker_velocity(accel, tracker, time);
+
 		if (initial_velocity == 0.0) {
 			result = initial_velocity = velocity;
 		} else {
@@ -327,7 +457,7 @@ static double
 acceleration_profile(struct pointer_accelerator *accel,
 		     void *data, double velocity, uint64_t time)
 {
-	return accel->profile(&accel->base, data, velocity, time);
+	return pointer_accel_profile_lut(&accel->base, data, velocity, time);
 }
 
 /**
@@ -471,6 +601,41 @@ accelerator_filter_pre_normalized(struct motion_filter *filter,
 	return normalized;
 }
 
+static void
+accelerator_filter_pre_normalized_batch(struct motion_filter *filter,
+					const struct device_float_coords *unaccelerated,
+					const uint64_t *time,
+					struct normalized_coords *accelerated,
+					size_t count,
+					void *data)
+{
+	struct pointer_accelerator *accel =
+		(struct pointer_accelerator *) filter;
+	const int dpi = accel->dpi;
+	struct device_float_coords normalized;
+	double accel_value; /* unitless factor */
+	size_t i;
+
+	/* Normalize all deltas first, that loop has no dependencies
+	 * between elements. The velocity depends on the previous events,
+	 * so the acceleration itself has to go in order. */
+	for (i = 0; i < count; i++) {
+		accelerated[i].x = unaccelerated[i].x * DEFAULT_MOUSE_DPI/dpi;
+		accelerated[i].y = unaccelerated[i].y * DEFAULT_MOUSE_DPI/dpi;
+	}
+
+	for (i = 0; i < count; i++) {
+		normalized.x = accelerated[i].x;
+		normalized.y = accelerated[i].y;
+		accel_value = calculate_acceleration_factor(accel,
+							    &normalized,
+							    data,
+							    time[i]);
+		accelerated[i].x = accel_value * normalized.x;
+		accelerated[i].y = accel_value * normalized.y;
+	}
+}
+
 static struct normalized_coords
 accelerator_filter_unnormalized(struct motion_filter *filter,
 				const struct device_float_coords *unaccelerated,
@@ -588,6 +753,8 @@ touchpad_accelerator_set_speed(struct motion_filter *filter,
 	accel_filter->incline = TOUCHPAD_INCLINE;
 	filter->speed_adjustment = speed_adjustment;
 
+	accelerator_build_lut(accel_filter);
+
 	return true;
 }
 
@@ -616,13 +783,13 @@ accelerator_restart(struct motion_filter *filter,
 		(struct pointer_accelerator *) filter;
 	unsigned int offset;
 	struct pointer_tracker *tracker;
+	struct device_float_coords pos = tracker_by_offset(accel, 0)->pos;
 
 	for (offset = 1; offset < NUM_POINTER_TRACKERS; offset++) {
 		tracker = tracker_by_offset(accel, offset);
 		tracker->time = 0;
 		tracker->dir = 0;
-		tracker->delta.x = 0;
-		tracker->delta.y = 0;
+		tracker->pos = pos;
 	}
 
 	tracker = tracker_by_offset(accel, 0);
@@ -665,6 +832,9 @@ accelerator_set_speed(struct motion_filter *filter,
 	accel_filter->incline = DEFAULT_INCLINE + speed_adjustment * 0.75;
 
 	filter->speed_adjustment = speed_adjustment;
+
+	accelerator_build_lut(accel_filter);
+
 	return true;
 }
 
@@ -936,10 +1106,37 @@ trackpoint_accel_profile(struct motion_filter *filter,
 	return factor;
 }
 
+/**
+ * Look up the acceleration factor for the given velocity in the table
+ * built from the filter's profile. Only valid for the adaptive pointer
+ * accelerators.
+ */
+double
+pointer_accel_profile_lut(struct motion_filter *filter,
+			  void *data,
+			  double speed_in, /* device units/µs */
+			  uint64_t time)
+{
+	struct pointer_accelerator *accel =
+		(struct pointer_accelerator *)filter;
+	double pos = speed_in * accel->lut.scale;
+	unsigned int cell;
+
+	if (pos >= ACCEL_LUT_SIZE)
+		return accel->lut.factors[ACCEL_LUT_SIZE];
+
+	cell = (unsigned int)pos;
+	if (bit_is_set(accel->lut.kinks, cell))
+		return accel->profile(filter, data, speed_in, time);
+
+	return accelerator_lut_interpolate(accel, cell, pos);
+}
+
 struct motion_filter_interface accelerator_interface = {
 	.type = LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE,
 	.filter = accelerator_filter_pre_normalized,
 	.filter_constant = accelerator_filter_noop,
+	.filter_batch = accelerator_filter_pre_normalized_batch,
 	.restart = accelerator_restart,
 	.destroy = accelerator_destroy,
 	.set_speed = accelerator_set_speed,
@@ -980,6 +1177,8 @@ create_pointer_accelerator_filter_linear(int dpi)
 	filter->base.interface = &accelerator_interface;
 	filter->profile = pointer_accel_profile_linear;
 
+	accelerator_build_lut(filter);
+
 	return &filter->base;
 }
 
@@ -1004,6 +1203,8 @@ create_pointer_accelerator_filter_linear_low_dpi(int dpi)
 	filter->base.interface = &accelerator_interface_low_dpi;
 	filter->profile = pointer_accel_profile_linear_low_dpi;
 
+	accelerator_build_lut(filter);
+
 	return &filter->base;
 }
 
@@ -1028,6 +1229,8 @@ create_pointer_accelerator_filter_touchpad(int dpi)
 	filter->base.interface = &accelerator_interface_touchpad;
 	filter->profile = touchpad_accel_profile_linear;
 
+	accelerator_build_lut(filter);
+
 	return &filter->base;
 }
 
@@ -1066,6 +1269,8 @@ create_pointer_accelerator_filter_lenovo_x230(int dpi)
 	filter->incline = X230_INCLINE; /* incline of the acceleration function */
 	filter->dpi = dpi;
 
+	accelerator_build_lut(filter);
+
 	return &filter->base;
 }
 
@@ -1094,6 +1299,8 @@ create_pointer_accelerator_filter_trackpoint(int dpi)
 	filter->incline = DEFAULT_INCLINE;
 	filter->dpi = dpi;
 
+	accelerator_build_lut(filter);
+
 	return &filter->base;
 }
 
@@ -1116,6 +1323,25 @@ accelerator_filter_flat(struct motion_filter *filter,
 	return accelerated;
 }
 
+static void
+accelerator_filter_flat_batch(struct motion_filter *filter,
+			      const struct device_float_coords *unaccelerated,
+			      const uint64_t *time,
+			      struct normalized_coords *accelerated,
+			      size_t count,
+			      void *data)
+{
+	struct pointer_accelerator_flat *accel_filter =
+		(struct pointer_accelerator_flat *)filter;
+	const double factor = accel_filter->factor; /* unitless factor */
+	size_t i;
+
+	for (i = 0; i < count; i++) {
+		accelerated[i].x = factor * unaccelerated[i].x;
+		accelerated[i].y = factor * unaccelerated[i].y;
+	}
+}
+
 static bool
 accelerator_set_speed_flat(struct motion_filter *filter,
 			   double speed_adjustment)
@@ -1149,6 +1375,7 @@ struct motion_filter_interface accelerator_interface_flat = {
 	.type = LIBINPUT_CONFIG_ACCEL_PROFILE_FLAT,
 	.filter = accelerator_filter_flat,
 	.filter_constant = accelerator_filter_noop,
+	.filter_batch = accelerator_filter_flat_batch,
 	.restart = NULL,
 	.destroy = accelerator_destroy_flat,
 	.set_speed = accelerator_set_speed_flat,
@@ -82,6 +82,30 @@ filter_dispatch_constant(struct motion_filter *filter,
 			 const struct device_float_coords *unaccelerated,
 			 void *data, uint64_t time);
 
+/**
+ * Accelerate a sequence of deltas. This is equivalent to calling
+ * filter_dispatch() for each element in turn but avoids the per-call
+ * overhead and lets the flat and linear filters process the arrays in
+ * tight loops.
+ *
+ * @param filter The device's motion filter
+ * @param unaccelerated The unaccelerated deltas in the device's dpi
+ * @param time The time of each delta, in µs
+ * @param accelerated Filled with the accelerated deltas, must have
+ * room for count elements
+ * @param count The number of elements in each array
+ * @param data Custom data
+ *
+ * @see filter_dispatch
+ */
+void
+filter_dispatch_batch(struct motion_filter *filter,
+		      const struct device_float_coords *unaccelerated,
+		      const uint64_t *time,
+		      struct normalized_coords *accelerated,
+		      size_t count,
+		      void *data);
+
 void
 filter_restart(struct motion_filter *filter,
 	       void *data, uint64_t time);
@@ -154,4 +178,9 @@ trackpoint_accel_profile(struct motion_filter *filter,
 			 void *data,
 			 double speed_in,
 			 uint64_t time);
+double
+pointer_accel_profile_lut(struct motion_filter *filter,
+			  void *data,
+			  double speed_in,
+			  uint64_t time);
 #endif /* FILTER_H */
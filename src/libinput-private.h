@@ -29,12 +29,14 @@
 
 #include <errno.h>
 #include <math.h>
+#include <pthread.h>
 
 #include "linux/input.h"
 
 #include "libinput.h"
 #include "libinput-util.h"
 #include "libinput-version.h"
+#include "timer.h"
 
 #if LIBINPUT_VERSION_MICRO >= 90
 #define HTTP_DOC_LINK "https://wayland.freedesktop.org/libinput/doc/latest/"
@@ -43,6 +45,7 @@
 #endif
 
 struct libinput_source;
+struct libinput_timer;
 
 /* A coordinate pair in device coordinates */
 struct device_coords {
@@ -119,14 +122,60 @@ struct libinput_interface_backend {
 				  const char *seat_name);
 };
 
+/* Event pools, one per libinput_event subtype struct */
+enum event_pool_class {
+	EVENT_POOL_DEVICE_NOTIFY,
+	EVENT_POOL_KEYBOARD,
+	EVENT_POOL_POINTER,
+	EVENT_POOL_TOUCH,
+	EVENT_POOL_GESTURE,
+	EVENT_POOL_TABLET_TOOL,
+	EVENT_POOL_TABLET_PAD,
+	EVENT_POOL_SWITCH,
+
+	EVENT_POOL_NCLASSES,
+};
+
+struct event_pool_entry;
+
+/* Single-producer single-consumer ring of events, used to hand events
+ * between the input thread and the caller's thread without locking.
+ * head is only written by the producer, tail only by the consumer. */
+struct event_ring {
+	struct libinput_event **slots;
+	size_t size; /* power of two */
+	size_t head;
+	char padding[64]; /* keep head and tail on separate cache lines */
+	size_t tail;
+};
+
+/* Event types are grouped by hundreds (300 keyboard, 400 pointer, ...)
+ * with fewer than EVENT_TYPE_GROUP_SIZE types per group. This maps them
+ * onto a dense array for per-type counters. */
+#define EVENT_TYPE_GROUP_SIZE 8
+#define EVENT_TYPE_NSLOTS (10 * EVENT_TYPE_GROUP_SIZE)
+
+struct libwacom_cache;
+
 struct libinput {
 	int epoll_fd;
 	struct list source_destroy_list;
+	/* sources that ran out of budget, see libinput_source_set_pending() */
+	struct list source_pending_list;
+	/* eventfd that wakes up the caller while sources are pending */
+	struct {
+		int fd;
+		struct libinput_source *source;
+	} pending_wake;
 
 	struct list seat_list;
 
 	struct {
-		struct list list;
+		struct libinput_timer **heap; /* min-heap of armed timers */
+		size_t heap_count;
+		size_t heap_size;
+		uint64_t next_expire; /* currently programmed into the fd */
+		bool deferred; /* fd is re-armed at the end of dispatch */
 		struct libinput_source *source;
 		int fd;
 	} timer;
@@ -137,8 +186,59 @@ struct libinput {
 	size_t events_in;
 	size_t events_out;
 
+	/* merge consecutive pointer motion events in the queue, see
+	 * libinput_set_motion_coalescing() */
+	bool coalesce_motion;
+	uint64_t motion_events_coalesced;
+
+	/* only set during libinput_dispatch_with_handler() */
+	struct {
+		libinput_event_handler func;
+		void *data;
+		bool running; /* the handler is being called */
+	} event_handler;
+
+	/* indexed by event_type_slot(), see
+	 * libinput_set_event_type_enabled() */
+	unsigned long event_types_disabled[NLONGS(EVENT_TYPE_NSLOTS)];
+
+	/* see libinput_set_event_queue_limit(), 0 is unlimited */
+	struct {
+		size_t max_events;
+		enum libinput_event_queue_overflow overflow;
+		uint64_t dropped[EVENT_TYPE_NSLOTS];
+		uint64_t dropped_total;
+	} event_queue;
+
+	struct {
+		struct event_pool_entry *free_list[EVENT_POOL_NCLASSES];
+		struct list slabs;
+		uint64_t hits;
+		uint64_t misses;
+		uint64_t in_use;
+		uint64_t high_water_mark;
+	} event_pool;
+
 	struct list tool_list;
 
+	/* libwacom database shared by all tablet devices, see
+	 * libinput_libwacom_ref() */
+	struct libwacom_cache *libwacom;
+
+	/* Only used while libinput_input_thread_start() is in effect */
+	struct {
+		bool running;
+		bool quit; /* accessed atomically */
+		bool backlog; /* accessed atomically */
+		pthread_t thread;
+		pthread_mutex_t lock; /* held while the input thread dispatches */
+		int event_fd; /* signalled when events are published */
+		int wake_fd; /* wakes up the input thread */
+		struct libinput_source *wake_source;
+		struct event_ring events; /* input thread to caller */
+		struct event_ring released; /* caller to input thread */
+	} thread;
+
 	const struct libinput_interface *interface;
 	const struct libinput_interface_backend *interface_backend;
 
@@ -165,7 +265,7 @@ struct libinput_seat {
 
 	uint32_t slot_map;
 
-	uint32_t button_count[KEY_CNT];
+	struct key_counts button_count;
 };
 
 struct libinput_device_config_tap {
@@ -289,6 +389,26 @@ struct libinput_device_config_rotation {
 	unsigned int (*get_default_angle)(struct libinput_device *device);
 };
 
+struct libinput_device_config_motion_smoothing {
+	int (*is_available)(struct libinput_device *device);
+	enum libinput_config_status (*set_enabled)(
+			 struct libinput_device *device,
+			 enum libinput_config_motion_smoothing_state enable);
+	enum libinput_config_motion_smoothing_state (*get_enabled)(
+			 struct libinput_device *device);
+	enum libinput_config_motion_smoothing_state (*get_default_enabled)(
+			 struct libinput_device *device);
+};
+
+struct libinput_device_config_prediction {
+	int (*is_available)(struct libinput_device *device);
+	enum libinput_config_status (*set_lookahead)(
+			 struct libinput_device *device,
+			 unsigned int lookahead);
+	unsigned int (*get_lookahead)(struct libinput_device *device);
+	unsigned int (*get_default_lookahead)(struct libinput_device *device);
+};
+
 struct libinput_device_config {
 	struct libinput_device_config_tap *tap;
 	struct libinput_device_config_calibration *calibration;
@@ -301,6 +421,8 @@ struct libinput_device_config {
 	struct libinput_device_config_middle_emulation *middle_emulation;
 	struct libinput_device_config_dwt *dwt;
 	struct libinput_device_config_rotation *rotation;
+	struct libinput_device_config_motion_smoothing *motion_smoothing;
+	struct libinput_device_config_prediction *prediction;
 };
 
 struct libinput_device_group {
@@ -311,6 +433,15 @@ struct libinput_device_group {
 	struct list link;
 };
 
+#define LATENCY_HISTOGRAM_BUCKETS 24
+
+/* Only allocated while latency tracking is enabled for a device */
+struct latency_histograms {
+	uint64_t read_time; /* while processing the data of a read */
+	uint64_t buckets[LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED]
+			[LATENCY_HISTOGRAM_BUCKETS];
+};
+
 struct libinput_device {
 	struct libinput_seat *seat;
 	struct libinput_device_group *group;
@@ -319,6 +450,7 @@ struct libinput_device {
 	void *user_data;
 	int refcount;
 	struct libinput_device_config config;
+	struct latency_histograms *latency;
 };
 
 enum libinput_tablet_tool_axis {
@@ -372,7 +504,9 @@ struct libinput_tablet_pad_mode_group {
 
 struct libinput_event {
 	enum libinput_event_type type;
+	bool transient; /* only valid inside an event handler */
 	struct libinput_device *device;
+	uint64_t queued_time; /* only set with latency tracking */
 };
 
 struct libinput_event_listener {
@@ -433,6 +567,24 @@ void
 libinput_remove_source(struct libinput *libinput,
 		       struct libinput_source *source);
 
+/* Sources are dispatched in order of priority whenever more than one
+ * source is ready */
+enum libinput_source_priority {
+	SOURCE_PRIORITY_HIGH, /* keyboards, switches */
+	SOURCE_PRIORITY_NORMAL,
+	SOURCE_PRIORITY_LOW, /* pointers, touch and tablet devices */
+};
+
+void
+libinput_source_set_priority(struct libinput_source *source,
+			     enum libinput_source_priority priority);
+
+/* Dispatch the source again even if its fd isn't readable, for sources
+ * that stopped early with data left in a userspace buffer */
+void
+libinput_source_set_pending(struct libinput *libinput,
+			    struct libinput_source *source);
+
 int
 open_restricted(struct libinput *libinput,
 		const char *path, int flags);
@@ -443,6 +595,9 @@ close_restricted(struct libinput *libinput, int fd);
 bool
 ignore_litest_test_suite_device(struct udev_device *device);
 
+bool
+libinput_called_from_handler(struct libinput *libinput, const char *func);
+
 void
 libinput_seat_init(struct libinput_seat *seat,
 		   struct libinput *libinput,
@@ -497,7 +652,8 @@ void
 pointer_notify_motion(struct libinput_device *device,
 		      uint64_t time,
 		      const struct normalized_coords *delta,
-		      const struct device_float_coords *raw);
+		      const struct device_float_coords *raw,
+		      const struct device_float_coords *predicted);
 
 void
 pointer_notify_motion_absolute(struct libinput_device *device,
@@ -523,14 +679,16 @@ touch_notify_touch_down(struct libinput_device *device,
 			uint64_t time,
 			int32_t slot,
 			int32_t seat_slot,
-			const struct device_coords *point);
+			const struct device_coords *point,
+			const struct device_coords *predicted);
 
 void
 touch_notify_touch_motion(struct libinput_device *device,
 			  uint64_t time,
 			  int32_t slot,
 			  int32_t seat_slot,
-			  const struct device_coords *point);
+			  const struct device_coords *point,
+			  const struct device_coords *predicted);
 
 void
 touch_notify_touch_up(struct libinput_device *device,
@@ -632,6 +790,12 @@ switch_notify_toggle(struct libinput_device *device,
 		     enum libinput_switch sw,
 		     enum libinput_switch_state state);
 
+void
+latency_record(struct libinput_device *device,
+	       enum libinput_latency_stage stage,
+	       uint64_t from,
+	       uint64_t to);
+
 static inline uint64_t
 libinput_now(struct libinput *libinput)
 {
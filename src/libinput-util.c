@@ -80,6 +80,153 @@ ratelimit_init(struct ratelimit *r, uint64_t ival_us, unsigned int burst)
 	r->num = 0;
 }
 
+static struct key_count *
+key_counts_find(const struct key_counts *counts, unsigned int code)
+{
+	struct key_count *k;
+
+	for (k = counts->entries; k < counts->entries + counts->nentries; k++) {
+		if (k->code == code)
+			return k;
+	}
+
+	return NULL;
+}
+
+uint32_t
+key_counts_get(const struct key_counts *counts, unsigned int code)
+{
+	struct key_count *k = key_counts_find(counts, code);
+
+	return k ? k->count : 0;
+}
+
+/*
+ * Increase the press count for the given code and return the new count.
+ * Returns 0 if a new counter could not be allocated, the counters are
+ * unchanged in that case.
+ */
+uint32_t
+key_counts_inc(struct key_counts *counts, unsigned int code)
+{
+	struct key_count *k = key_counts_find(counts, code);
+
+	if (k)
+		return ++k->count;
+
+	if (counts->nentries == counts->size) {
+		size_t size = counts->size ? counts->size * 2 : 8;
+		struct key_count *entries;
+
+		entries = realloc(counts->entries, size * sizeof *entries);
+		if (!entries)
+			return 0;
+
+		counts->entries = entries;
+		counts->size = size;
+	}
+
+	k = &counts->entries[counts->nentries++];
+	k->code = code;
+	k->count = 1;
+
+	return k->count;
+}
+
+/*
+ * Decrease the press count for the given code and return the new count.
+ * Decreasing a count that is already zero is a noop and returns zero.
+ */
+uint32_t
+key_counts_dec(struct key_counts *counts, unsigned int code)
+{
+	struct key_count *k = key_counts_find(counts, code);
+
+	if (!k)
+		return 0;
+
+	if (--k->count > 0)
+		return k->count;
+
+	*k = counts->entries[--counts->nentries];
+
+	return 0;
+}
+
+void
+key_counts_release(struct key_counts *counts)
+{
+	free(counts->entries);
+	counts->entries = NULL;
+	counts->nentries = 0;
+	counts->size = 0;
+}
+
+/* Gains of the alpha-beta filter. A high alpha keeps the estimate close to
+ * the sensor, touch positions are already accurate enough that lagging
+ * behind them costs more than the noise. */
+#define PREDICTOR_ALPHA 0.9
+#define PREDICTOR_BETA 0.5
+/* A gap this long between samples means the motion stopped */
+#define PREDICTOR_MAX_GAP ms2us(50)
+
+void
+motion_predictor_reset(struct motion_predictor *p)
+{
+	memset(p, 0, sizeof(*p));
+}
+
+void
+motion_predictor_update(struct motion_predictor *p,
+			uint64_t time,
+			double x,
+			double y)
+{
+	uint64_t dt = time - p->time;
+	double px, py, rx, ry;
+
+	/* a second sample for the same time only corrects the position */
+	if (p->nsamples > 0 && time == p->time) {
+		p->x = x;
+		p->y = y;
+		return;
+	}
+
+	if (p->nsamples == 0 || time <= p->time || dt > PREDICTOR_MAX_GAP) {
+		p->vx = 0.0;
+		p->vy = 0.0;
+		p->nsamples = 1;
+	} else if (p->nsamples == 1) {
+		/* two samples give the first velocity */
+		p->vx = (x - p->x) / dt;
+		p->vy = (y - p->y) / dt;
+		p->nsamples++;
+	} else {
+		px = p->x + p->vx * dt;
+		py = p->y + p->vy * dt;
+		rx = x - px;
+		ry = y - py;
+		x = px + PREDICTOR_ALPHA * rx;
+		y = py + PREDICTOR_ALPHA * ry;
+		p->vx += PREDICTOR_BETA * rx / dt;
+		p->vy += PREDICTOR_BETA * ry / dt;
+	}
+
+	p->time = time;
+	p->x = x;
+	p->y = y;
+}
+
+void
+motion_predictor_predict(const struct motion_predictor *p,
+			 uint64_t lookahead,
+			 double *x,
+			 double *y)
+{
+	*x = p->x + p->vx * lookahead;
+	*y = p->y + p->vy * lookahead;
+}
+
 /*
  * Perform rate-limit test. Returns RATELIMIT_PASS if the rate-limited action
  * is still allowed, RATELIMIT_THRESHOLD if the limit has been reached with
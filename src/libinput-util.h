@@ -372,6 +372,46 @@ struct ratelimit {
 void ratelimit_init(struct ratelimit *r, uint64_t ival_ms, unsigned int burst);
 enum ratelimit_state ratelimit_test(struct ratelimit *r);
 
+/* Press counters for evdev key codes. Only keys with a nonzero count
+ * are stored, in no particular order, so lookups are a short linear
+ * scan. A zeroed struct is an empty set of counters. */
+struct key_count {
+	uint16_t code;
+	uint32_t count;
+};
+
+struct key_counts {
+	struct key_count *entries;
+	size_t nentries;
+	size_t size;
+};
+
+uint32_t key_counts_get(const struct key_counts *counts, unsigned int code);
+uint32_t key_counts_inc(struct key_counts *counts, unsigned int code);
+uint32_t key_counts_dec(struct key_counts *counts, unsigned int code);
+void key_counts_release(struct key_counts *counts);
+
+/* An alpha-beta filter, the steady-state form of a Kalman filter for a
+ * constant-velocity model, over a stream of 2D positions. Used to
+ * extrapolate where a touch or the pointer will be a few ms ahead.
+ * A zeroed struct is a reset predictor. */
+struct motion_predictor {
+	unsigned int nsamples;
+	uint64_t time; /* of the last sample, us */
+	double x, y; /* estimated position */
+	double vx, vy; /* estimated velocity in units/us */
+};
+
+void motion_predictor_reset(struct motion_predictor *p);
+void motion_predictor_update(struct motion_predictor *p,
+			     uint64_t time,
+			     double x,
+			     double y);
+void motion_predictor_predict(const struct motion_predictor *p,
+			      uint64_t lookahead,
+			      double *x,
+			      double *y);
+
 int parse_mouse_dpi_property(const char *prop);
 int parse_mouse_wheel_click_angle_property(const char *prop);
 int parse_mouse_wheel_click_count_property(const char *prop);
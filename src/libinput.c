@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 #include <assert.h>
 
@@ -77,9 +78,19 @@ struct libinput_source {
 	libinput_source_dispatch_t dispatch;
 	void *user_data;
 	int fd;
+	enum libinput_source_priority priority;
+	bool pending;
+	struct list pending_link;
 	struct list link;
 };
 
+/* libinput_dispatch() polls for ready sources this many times at most.
+ * Each time, every ready source is dispatched once, sources limit the
+ * amount of work they do per dispatch so no single source can
+ * monopolize libinput_dispatch() */
+#define DISPATCH_MAX_ROUNDS 16
+#define DISPATCH_EPOLL_EVENTS 32
+
 struct libinput_event_device_notify {
 	struct libinput_event base;
 };
@@ -97,6 +108,7 @@ struct libinput_event_pointer {
 	uint64_t time;
 	struct normalized_coords delta;
 	struct device_float_coords delta_raw;
+	struct device_float_coords predicted_raw;
 	struct device_coords absolute;
 	struct discrete_coords discrete;
 	uint32_t button;
@@ -112,6 +124,7 @@ struct libinput_event_touch {
 	int32_t slot;
 	int32_t seat_slot;
 	struct device_coords point;
+	struct device_coords predicted;
 };
 
 struct libinput_event_gesture {
@@ -166,6 +179,179 @@ struct libinput_event_switch {
 	enum libinput_switch_state state;
 };
 
+/* Number of events allocated at once when an event pool runs dry */
+#define EVENT_POOL_SLAB_SIZE 32
+
+/* Overlays a free event in the pool */
+struct event_pool_entry {
+	struct event_pool_entry *next;
+};
+
+struct event_pool_slab {
+	struct list link;
+	union {
+		uint64_t u64;
+		double d;
+		void *ptr;
+	} data[];
+};
+
+static const size_t event_pool_sizes[EVENT_POOL_NCLASSES] = {
+	[EVENT_POOL_DEVICE_NOTIFY] = sizeof(struct libinput_event_device_notify),
+	[EVENT_POOL_KEYBOARD] = sizeof(struct libinput_event_keyboard),
+	[EVENT_POOL_POINTER] = sizeof(struct libinput_event_pointer),
+	[EVENT_POOL_TOUCH] = sizeof(struct libinput_event_touch),
+	[EVENT_POOL_GESTURE] = sizeof(struct libinput_event_gesture),
+	[EVENT_POOL_TABLET_TOOL] = sizeof(struct libinput_event_tablet_tool),
+	[EVENT_POOL_TABLET_PAD] = sizeof(struct libinput_event_tablet_pad),
+	[EVENT_POOL_SWITCH] = sizeof(struct libinput_event_switch),
+};
+
+static inline enum event_pool_class
+event_pool_class_from_type(enum libinput_event_type type)
+{
+	switch (type) {
+	case LIBINPUT_EVENT_NONE:
+		abort();
+	case LIBINPUT_EVENT_DEVICE_ADDED:
+	case LIBINPUT_EVENT_DEVICE_REMOVED:
+		return EVENT_POOL_DEVICE_NOTIFY;
+	case LIBINPUT_EVENT_KEYBOARD_KEY:
+		return EVENT_POOL_KEYBOARD;
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_POINTER_BUTTON:
+	case LIBINPUT_EVENT_POINTER_AXIS:
+		return EVENT_POOL_POINTER;
+	case LIBINPUT_EVENT_TOUCH_DOWN:
+	case LIBINPUT_EVENT_TOUCH_UP:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TOUCH_CANCEL:
+	case LIBINPUT_EVENT_TOUCH_FRAME:
+		return EVENT_POOL_TOUCH;
+	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
+	case LIBINPUT_EVENT_TABLET_TOOL_TIP:
+	case LIBINPUT_EVENT_TABLET_TOOL_BUTTON:
+		return EVENT_POOL_TABLET_TOOL;
+	case LIBINPUT_EVENT_TABLET_PAD_BUTTON:
+	case LIBINPUT_EVENT_TABLET_PAD_RING:
+	case LIBINPUT_EVENT_TABLET_PAD_STRIP:
+		return EVENT_POOL_TABLET_PAD;
+	case LIBINPUT_EVENT_GESTURE_SWIPE_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_SWIPE_END:
+	case LIBINPUT_EVENT_GESTURE_PINCH_BEGIN:
+	case LIBINPUT_EVENT_GESTURE_PINCH_UPDATE:
+	case LIBINPUT_EVENT_GESTURE_PINCH_END:
+		return EVENT_POOL_GESTURE;
+	case LIBINPUT_EVENT_SWITCH_TOGGLE:
+		return EVENT_POOL_SWITCH;
+	}
+
+	abort();
+}
+
+static bool
+event_pool_grow(struct libinput *libinput, enum event_pool_class class)
+{
+	struct event_pool_slab *slab;
+	struct event_pool_entry *entry;
+	size_t size = event_pool_sizes[class];
+	char *data;
+	int i;
+
+	slab = zalloc(sizeof *slab + EVENT_POOL_SLAB_SIZE * size);
+	if (!slab)
+		return false;
+
+	list_insert(&libinput->event_pool.slabs, &slab->link);
+
+	data = (char *)slab->data;
+	for (i = EVENT_POOL_SLAB_SIZE - 1; i >= 0; i--) {
+		entry = (struct event_pool_entry *)(data + i * size);
+		entry->next = libinput->event_pool.free_list[class];
+		libinput->event_pool.free_list[class] = entry;
+	}
+
+	return true;
+}
+
+static inline size_t
+event_type_slot(enum libinput_event_type type)
+{
+	return type / 100 * EVENT_TYPE_GROUP_SIZE + type % 100;
+}
+
+static inline bool
+event_type_disabled(struct libinput *libinput,
+		    enum libinput_event_type type)
+{
+	return long_bit_is_set(libinput->event_types_disabled,
+			       event_type_slot(type));
+}
+
+/**
+ * Take a zeroed event of the given type from the context's event pool,
+ * growing the pool by one slab if needed. Events allocated here must be
+ * returned with event_pool_release().
+ */
+static void *
+event_pool_take(struct libinput_device *device,
+		enum libinput_event_type type)
+{
+	struct libinput *libinput = device->seat->libinput;
+	enum event_pool_class class = event_pool_class_from_type(type);
+	struct event_pool_entry *entry;
+
+	/* Internal listeners see all events, otherwise don't bother
+	 * building events the caller isn't interested in */
+	if (event_type_disabled(libinput, type) &&
+	    list_empty(&device->event_listeners))
+		return NULL;
+
+	if (libinput->event_pool.free_list[class]) {
+		libinput->event_pool.hits++;
+	} else {
+		if (!event_pool_grow(libinput, class))
+			return NULL;
+		libinput->event_pool.misses++;
+	}
+
+	entry = libinput->event_pool.free_list[class];
+	libinput->event_pool.free_list[class] = entry->next;
+
+	libinput->event_pool.in_use++;
+	if (libinput->event_pool.in_use > libinput->event_pool.high_water_mark)
+		libinput->event_pool.high_water_mark = libinput->event_pool.in_use;
+
+	memset(entry, 0, event_pool_sizes[class]);
+
+	return entry;
+}
+
+static void
+event_pool_release(struct libinput *libinput,
+		   struct libinput_event *event)
+{
+	enum event_pool_class class = event_pool_class_from_type(event->type);
+	struct event_pool_entry *entry = (struct event_pool_entry *)event;
+
+	entry->next = libinput->event_pool.free_list[class];
+	libinput->event_pool.free_list[class] = entry;
+	libinput->event_pool.in_use--;
+}
+
+static void
+event_pool_destroy(struct libinput *libinput)
+{
+	struct event_pool_slab *slab, *tmp;
+
+	list_for_each_safe(slab, tmp, &libinput->event_pool.slabs, link)
+		free(slab);
+	list_init(&libinput->event_pool.slabs);
+}
+
 LIBINPUT_ATTRIBUTE_PRINTF(3, 0)
 static void
 libinput_default_log_func(struct libinput *libinput,
@@ -513,6 +699,30 @@ libinput_event_pointer_get_dy_unaccelerated(
 	return event->delta_raw.y;
 }
 
+LIBINPUT_EXPORT double
+libinput_event_pointer_get_predicted_dx_unaccelerated(
+	struct libinput_event_pointer *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_POINTER_MOTION);
+
+	return event->predicted_raw.x;
+}
+
+LIBINPUT_EXPORT double
+libinput_event_pointer_get_predicted_dy_unaccelerated(
+	struct libinput_event_pointer *event)
+{
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_POINTER_MOTION);
+
+	return event->predicted_raw.y;
+}
+
 LIBINPUT_EXPORT double
 libinput_event_pointer_get_absolute_x(struct libinput_event_pointer *event)
 {
@@ -803,6 +1013,64 @@ libinput_event_touch_get_y(struct libinput_event_touch *event)
 	return evdev_convert_to_mm(device->abs.absinfo_y, event->point.y);
 }
 
+LIBINPUT_EXPORT double
+libinput_event_touch_get_predicted_x(struct libinput_event_touch *event)
+{
+	struct evdev_device *device = evdev_device(event->base.device);
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_TOUCH_DOWN,
+			   LIBINPUT_EVENT_TOUCH_MOTION);
+
+	return evdev_convert_to_mm(device->abs.absinfo_x, event->predicted.x);
+}
+
+LIBINPUT_EXPORT double
+libinput_event_touch_get_predicted_y(struct libinput_event_touch *event)
+{
+	struct evdev_device *device = evdev_device(event->base.device);
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_TOUCH_DOWN,
+			   LIBINPUT_EVENT_TOUCH_MOTION);
+
+	return evdev_convert_to_mm(device->abs.absinfo_y, event->predicted.y);
+}
+
+LIBINPUT_EXPORT double
+libinput_event_touch_get_predicted_x_transformed(struct libinput_event_touch *event,
+						 uint32_t width)
+{
+	struct evdev_device *device = evdev_device(event->base.device);
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_TOUCH_DOWN,
+			   LIBINPUT_EVENT_TOUCH_MOTION);
+
+	return evdev_device_transform_x(device, event->predicted.x, width);
+}
+
+LIBINPUT_EXPORT double
+libinput_event_touch_get_predicted_y_transformed(struct libinput_event_touch *event,
+						 uint32_t height)
+{
+	struct evdev_device *device = evdev_device(event->base.device);
+
+	require_event_type(libinput_event_get_context(&event->base),
+			   event->base.type,
+			   0,
+			   LIBINPUT_EVENT_TOUCH_DOWN,
+			   LIBINPUT_EVENT_TOUCH_MOTION);
+
+	return evdev_device_transform_y(device, event->predicted.y, height);
+}
+
 LIBINPUT_EXPORT uint32_t
 libinput_event_gesture_get_time(struct libinput_event_gesture *event)
 {
@@ -1585,6 +1853,7 @@ libinput_add_fd(struct libinput *libinput,
 	source->dispatch = dispatch;
 	source->user_data = user_data;
 	source->fd = fd;
+	source->priority = SOURCE_PRIORITY_NORMAL;
 
 	memset(&ep, 0, sizeof ep);
 	ep.events = EPOLLIN;
@@ -1604,9 +1873,54 @@ libinput_remove_source(struct libinput *libinput,
 {
 	epoll_ctl(libinput->epoll_fd, EPOLL_CTL_DEL, source->fd, NULL);
 	source->fd = -1;
+	if (source->pending) {
+		list_remove(&source->pending_link);
+		source->pending = false;
+	}
 	list_insert(&libinput->source_destroy_list, &source->link);
 }
 
+void
+libinput_source_set_priority(struct libinput_source *source,
+			     enum libinput_source_priority priority)
+{
+	source->priority = priority;
+}
+
+void
+libinput_source_set_pending(struct libinput *libinput,
+			    struct libinput_source *source)
+{
+	if (source->pending || source->fd == -1)
+		return;
+
+	source->pending = true;
+	list_insert(libinput->source_pending_list.prev, &source->pending_link);
+}
+
+static void
+eventfd_notify(int fd)
+{
+	uint64_t one = 1;
+
+	/* Can only fail if the counter overflows, in which case the fd is
+	 * readable anyway */
+	if (write(fd, &one, sizeof one) < 0)
+		return;
+}
+
+static void
+libinput_pending_wake_dispatch(void *data)
+{
+	struct libinput *libinput = data;
+	uint64_t discard;
+
+	/* Nothing else to do, the eventfd only makes the epoll fd readable
+	 * so the caller calls libinput_dispatch() for the pending sources */
+	if (read(libinput->pending_wake.fd, &discard, sizeof discard) < 0)
+		return;
+}
+
 int
 libinput_init(struct libinput *libinput,
 	      const struct libinput_interface *interface,
@@ -1634,9 +1948,11 @@ libinput_init(struct libinput *libinput,
 	libinput->user_data = user_data;
 	libinput->refcount = 1;
 	list_init(&libinput->source_destroy_list);
+	list_init(&libinput->source_pending_list);
 	list_init(&libinput->seat_list);
 	list_init(&libinput->device_group_list);
 	list_init(&libinput->tool_list);
+	list_init(&libinput->event_pool.slabs);
 
 	if (libinput_timer_subsys_init(libinput) != 0) {
 		free(libinput->events);
@@ -1644,6 +1960,22 @@ libinput_init(struct libinput *libinput,
 		return -1;
 	}
 
+	libinput->pending_wake.fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+	if (libinput->pending_wake.fd != -1)
+		libinput->pending_wake.source =
+			libinput_add_fd(libinput,
+					libinput->pending_wake.fd,
+					libinput_pending_wake_dispatch,
+					libinput);
+	if (!libinput->pending_wake.source) {
+		if (libinput->pending_wake.fd != -1)
+			close(libinput->pending_wake.fd);
+		libinput_timer_subsys_destroy(libinput);
+		free(libinput->events);
+		close(libinput->epoll_fd);
+		return -1;
+	}
+
 	return 0;
 }
 
@@ -1683,10 +2015,15 @@ libinput_unref(struct libinput *libinput)
 		return NULL;
 
 	assert(libinput->refcount > 0);
+	if (libinput->refcount == 1 &&
+	    libinput_called_from_handler(libinput, __func__))
+		return libinput;
+
 	libinput->refcount--;
 	if (libinput->refcount > 0)
 		return libinput;
 
+	libinput_input_thread_stop(libinput);
 	libinput_suspend(libinput);
 
 	libinput->interface_backend->destroy(libinput);
@@ -1716,8 +2053,11 @@ libinput_unref(struct libinput *libinput)
 		libinput_tablet_tool_unref(tool);
 	}
 
+	libinput_remove_source(libinput, libinput->pending_wake.source);
+	close(libinput->pending_wake.fd);
 	libinput_timer_subsys_destroy(libinput);
 	libinput_drop_destroyed_sources(libinput);
+	event_pool_destroy(libinput);
 	close(libinput->epoll_fd);
 	free(libinput);
 
@@ -1736,12 +2076,82 @@ libinput_event_tablet_pad_destroy(struct libinput_event_tablet_pad *event)
 	libinput_tablet_pad_mode_group_unref(event->mode_group);
 }
 
-LIBINPUT_EXPORT void
-libinput_event_destroy(struct libinput_event *event)
+static bool
+event_ring_init(struct event_ring *ring, size_t size)
 {
-	if (event == NULL)
-		return;
+	ring->slots = zalloc(size * sizeof *ring->slots);
+	if (!ring->slots)
+		return false;
+
+	ring->size = size;
+	ring->head = 0;
+	ring->tail = 0;
+
+	return true;
+}
+
+static void
+event_ring_destroy(struct event_ring *ring)
+{
+	free(ring->slots);
+	ring->slots = NULL;
+	ring->size = 0;
+}
+
+/* Producer side only */
+static bool
+event_ring_push(struct event_ring *ring, struct libinput_event *event)
+{
+	size_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+	size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+	if (head - tail == ring->size)
+		return false;
+
+	ring->slots[head & (ring->size - 1)] = event;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+	return true;
+}
+
+/* Consumer side only */
+static struct libinput_event *
+event_ring_peek(struct event_ring *ring)
+{
+	size_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+	size_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	if (head == tail)
+		return NULL;
+
+	return ring->slots[tail & (ring->size - 1)];
+}
+
+/* Consumer side only */
+static struct libinput_event *
+event_ring_pop(struct event_ring *ring)
+{
+	struct libinput_event *event;
+	size_t tail;
+
+	event = event_ring_peek(ring);
+	if (event) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+		__atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+	}
+
+	return event;
+}
 
+/**
+ * Drop the references an event holds, other than the one to its device,
+ * and return it to the event pool. Events are only holding a device
+ * reference once they have been queued.
+ */
+static void
+libinput_event_discard(struct libinput *libinput,
+		       struct libinput_event *event)
+{
 	switch(event->type) {
 	case LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY:
 	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
@@ -1760,10 +2170,51 @@ libinput_event_destroy(struct libinput_event *event)
 		break;
 	}
 
-	if (event->device)
-		libinput_device_unref(event->device);
+	event_pool_release(libinput, event);
+}
+
+static void
+libinput_event_release(struct libinput *libinput,
+		       struct libinput_event *event)
+{
+	struct libinput_device *device = event->device;
+
+	libinput_event_discard(libinput, event);
+
+	if (device)
+		libinput_device_unref(device);
+}
+
+LIBINPUT_EXPORT void
+libinput_event_destroy(struct libinput_event *event)
+{
+	struct libinput *libinput;
 
-	free(event);
+	if (event == NULL)
+		return;
+
+	libinput = libinput_event_get_context(event);
+
+	if (event->transient) {
+		log_bug_client(libinput,
+			       "Event passed to an event handler must not be destroyed\n");
+		return;
+	}
+
+	if (!libinput->thread.running) {
+		libinput_event_release(libinput, event);
+		return;
+	}
+
+	/* The event pool and the device refcounts belong to the input
+	 * thread, it releases the event during its next pass. If it hasn't
+	 * caught up with us, release it here. */
+	if (event_ring_push(&libinput->thread.released, event))
+		return;
+
+	pthread_mutex_lock(&libinput->thread.lock);
+	libinput_event_release(libinput, event);
+	pthread_mutex_unlock(&libinput->thread.lock);
 }
 
 int
@@ -1818,6 +2269,7 @@ static void
 libinput_seat_destroy(struct libinput_seat *seat)
 {
 	list_remove(&seat->link);
+	key_counts_release(&seat->button_count);
 	free(seat->logical_name);
 	free(seat->physical_name);
 	seat->destroy(seat);
@@ -1886,6 +2338,7 @@ static void
 libinput_device_destroy(struct libinput_device *device)
 {
 	assert(list_empty(&device->event_listeners));
+	free(device->latency);
 	evdev_device_destroy(evdev_device(device));
 }
 
@@ -1905,52 +2358,161 @@ libinput_device_unref(struct libinput_device *device)
 LIBINPUT_EXPORT int
 libinput_get_fd(struct libinput *libinput)
 {
+	if (libinput->thread.running)
+		return libinput->thread.event_fd;
+
 	return libinput->epoll_fd;
 }
 
-LIBINPUT_EXPORT int
-libinput_dispatch(struct libinput *libinput)
+/* Collect the sources to dispatch in this round, pending sources first,
+ * then sorted by priority. Returns the number of sources */
+static size_t
+libinput_collect_sources(struct libinput *libinput,
+			 struct epoll_event *ep,
+			 int count,
+			 struct libinput_source **ready,
+			 size_t max_ready)
 {
-	struct libinput_source *source;
-	struct epoll_event ep[32];
-	int i, count;
+	struct libinput_source *source, *tmp;
+	size_t nready = 0;
+	size_t i, j;
 
-	count = epoll_wait(libinput->epoll_fd, ep, ARRAY_LENGTH(ep), 0);
-	if (count < 0)
-		return -errno;
+	list_for_each_safe(source, tmp,
+			   &libinput->source_pending_list,
+			   pending_link) {
+		if (nready == max_ready)
+			break;
+
+		list_remove(&source->pending_link);
+		source->pending = false;
+		ready[nready++] = source;
+	}
 
-	for (i = 0; i < count; ++i) {
+	for (i = 0; i < (size_t)count && nready < max_ready; i++) {
 		source = ep[i].data.ptr;
 		if (source->fd == -1)
 			continue;
 
-		source->dispatch(source->user_data);
+		for (j = 0; j < nready; j++) {
+			if (ready[j] == source)
+				break;
+		}
+		if (j == nready)
+			ready[nready++] = source;
 	}
 
-	libinput_drop_destroyed_sources(libinput);
+	/* insertion sort, stable so pending sources stay in front of
+	 * sources of the same priority */
+	for (i = 1; i < nready; i++) {
+		source = ready[i];
+		for (j = i;
+		     j > 0 && ready[j - 1]->priority > source->priority;
+		     j--)
+			ready[j] = ready[j - 1];
+		ready[j] = source;
+	}
 
-	return 0;
+	return nready;
 }
 
-void
-libinput_device_init_event_listener(struct libinput_event_listener *listener)
-{
-	list_init(&listener->link);
-}
+static void
+libinput_dispatch_sources(struct libinput *libinput,
+			  struct epoll_event ep[DISPATCH_EPOLL_EVENTS],
+			  int count)
+{
+	struct libinput_source *ready[2 * DISPATCH_EPOLL_EVENTS];
+	size_t nready, i;
+	int round;
+
+	/* Timers are armed and cancelled many times while processing
+	 * events, only program the timerfd once we're done */
+	libinput_timer_defer(libinput);
+
+	for (round = 0; round < DISPATCH_MAX_ROUNDS; round++) {
+		if (round > 0) {
+			count = epoll_wait(libinput->epoll_fd,
+					   ep,
+					   DISPATCH_EPOLL_EVENTS,
+					   0);
+			if (count < 0)
+				break;
+		}
 
-void
-libinput_device_add_event_listener(struct libinput_device *device,
-				   struct libinput_event_listener *listener,
-				   void (*notify_func)(
-						uint64_t time,
-						struct libinput_event *event,
-						void *notify_func_data),
-				   void *notify_func_data)
-{
-	listener->notify_func = notify_func;
-	listener->notify_func_data = notify_func_data;
-	list_insert(&device->event_listeners, &listener->link);
-}
+		nready = libinput_collect_sources(libinput,
+						  ep,
+						  count,
+						  ready,
+						  ARRAY_LENGTH(ready));
+		if (nready == 0)
+			break;
+
+		for (i = 0; i < nready; i++) {
+			/* removed by a previous source in this round */
+			if (ready[i]->fd == -1)
+				continue;
+
+			ready[i]->dispatch(ready[i]->user_data);
+		}
+	}
+
+	/* Sources with data buffered in userspace don't make the epoll fd
+	 * readable, wake up the caller for them */
+	if (!list_empty(&libinput->source_pending_list))
+		eventfd_notify(libinput->pending_wake.fd);
+
+	libinput_timer_flush(libinput);
+	libinput_drop_destroyed_sources(libinput);
+}
+
+LIBINPUT_EXPORT int
+libinput_dispatch(struct libinput *libinput)
+{
+	struct epoll_event ep[DISPATCH_EPOLL_EVENTS];
+	uint64_t discard;
+	int count;
+
+	if (libinput_called_from_handler(libinput, __func__))
+		return -EINVAL;
+
+	/* The input thread does the work, all that's left for us is
+	 * clearing the notification */
+	if (libinput->thread.running) {
+		if (read(libinput->thread.event_fd,
+			 &discard,
+			 sizeof discard) < 0 &&
+		    errno != EAGAIN)
+			return -errno;
+		return 0;
+	}
+
+	count = epoll_wait(libinput->epoll_fd, ep, ARRAY_LENGTH(ep), 0);
+	if (count < 0)
+		return -errno;
+
+	libinput_dispatch_sources(libinput, ep, count);
+
+	return 0;
+}
+
+void
+libinput_device_init_event_listener(struct libinput_event_listener *listener)
+{
+	list_init(&listener->link);
+}
+
+void
+libinput_device_add_event_listener(struct libinput_device *device,
+				   struct libinput_event_listener *listener,
+				   void (*notify_func)(
+						uint64_t time,
+						struct libinput_event *event,
+						void *notify_func_data),
+				   void *notify_func_data)
+{
+	listener->notify_func = notify_func;
+	listener->notify_func_data = notify_func_data;
+	list_insert(&device->event_listeners, &listener->link);
+}
 
 void
 libinput_device_remove_event_listener(struct libinput_event_listener *listener)
@@ -1963,17 +2525,21 @@ update_seat_key_count(struct libinput_seat *seat,
 		      int32_t key,
 		      enum libinput_key_state state)
 {
+	uint32_t count;
+
 	assert(key >= 0 && key <= KEY_MAX);
 
 	switch (state) {
 	case LIBINPUT_KEY_STATE_PRESSED:
-		return ++seat->button_count[key];
+		count = key_counts_inc(&seat->button_count, key);
+		if (count == 0)
+			log_error(seat->libinput,
+				  "Failed to track the seat count of key %d\n",
+				  key);
+		return count;
 	case LIBINPUT_KEY_STATE_RELEASED:
 		/* We might not have received the first PRESSED event. */
-		if (seat->button_count[key] == 0)
-			return 0;
-
-		return --seat->button_count[key];
+		return key_counts_dec(&seat->button_count, key);
 	}
 
 	return 0;
@@ -1984,17 +2550,21 @@ update_seat_button_count(struct libinput_seat *seat,
 			 int32_t button,
 			 enum libinput_button_state state)
 {
+	uint32_t count;
+
 	assert(button >= 0 && button <= KEY_MAX);
 
 	switch (state) {
 	case LIBINPUT_BUTTON_STATE_PRESSED:
-		return ++seat->button_count[button];
+		count = key_counts_inc(&seat->button_count, button);
+		if (count == 0)
+			log_error(seat->libinput,
+				  "Failed to track the seat count of button %d\n",
+				  button);
+		return count;
 	case LIBINPUT_BUTTON_STATE_RELEASED:
 		/* We might not have received the first PRESSED event. */
-		if (seat->button_count[button] == 0)
-			return 0;
-
-		return --seat->button_count[button];
+		return key_counts_dec(&seat->button_count, button);
 	}
 
 	return 0;
@@ -2025,14 +2595,29 @@ post_device_event(struct libinput_device *device,
 		  enum libinput_event_type type,
 		  struct libinput_event *event)
 {
+	struct libinput *libinput = device->seat->libinput;
 	struct libinput_event_listener *listener, *tmp;
 
 	init_event_base(event, device, type);
 
+	if (device->latency) {
+		event->queued_time = libinput_now(libinput);
+		if (device->latency->read_time)
+			latency_record(device,
+				       LIBINPUT_LATENCY_READ_TO_QUEUED,
+				       device->latency->read_time,
+				       event->queued_time);
+	}
+
 	list_for_each_safe(listener, tmp, &device->event_listeners, link)
 		listener->notify_func(time, event, listener->notify_func_data);
 
-	libinput_post_event(device->seat->libinput, event);
+	if (event_type_disabled(libinput, type)) {
+		libinput_event_discard(libinput, event);
+		return;
+	}
+
+	libinput_post_event(libinput, event);
 }
 
 void
@@ -2040,7 +2625,8 @@ notify_added_device(struct libinput_device *device)
 {
 	struct libinput_event_device_notify *added_device_event;
 
-	added_device_event = zalloc(sizeof *added_device_event);
+	added_device_event = event_pool_take(device,
+					     LIBINPUT_EVENT_DEVICE_ADDED);
 	if (!added_device_event)
 		return;
 
@@ -2054,7 +2640,8 @@ notify_removed_device(struct libinput_device *device)
 {
 	struct libinput_event_device_notify *removed_device_event;
 
-	removed_device_event = zalloc(sizeof *removed_device_event);
+	removed_device_event = event_pool_take(device,
+					       LIBINPUT_EVENT_DEVICE_REMOVED);
 	if (!removed_device_event)
 		return;
 
@@ -2116,12 +2703,12 @@ keyboard_notify_key(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_KEYBOARD))
 		return;
 
-	key_event = zalloc(sizeof *key_event);
+	seat_key_count = update_seat_key_count(device->seat, key, state);
+
+	key_event = event_pool_take(device, LIBINPUT_EVENT_KEYBOARD_KEY);
 	if (!key_event)
 		return;
 
-	seat_key_count = update_seat_key_count(device->seat, key, state);
-
 	*key_event = (struct libinput_event_keyboard) {
 		.time = time,
 		.key = key,
@@ -2138,14 +2725,15 @@ void
 pointer_notify_motion(struct libinput_device *device,
 		      uint64_t time,
 		      const struct normalized_coords *delta,
-		      const struct device_float_coords *raw)
+		      const struct device_float_coords *raw,
+		      const struct device_float_coords *predicted)
 {
 	struct libinput_event_pointer *motion_event;
 
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
-	motion_event = zalloc(sizeof *motion_event);
+	motion_event = event_pool_take(device, LIBINPUT_EVENT_POINTER_MOTION);
 	if (!motion_event)
 		return;
 
@@ -2153,6 +2741,7 @@ pointer_notify_motion(struct libinput_device *device,
 		.time = time,
 		.delta = *delta,
 		.delta_raw = *raw,
+		.predicted_raw = *predicted,
 	};
 
 	post_device_event(device, time,
@@ -2170,7 +2759,8 @@ pointer_notify_motion_absolute(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
-	motion_absolute_event = zalloc(sizeof *motion_absolute_event);
+	motion_absolute_event = event_pool_take(device,
+						LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE);
 	if (!motion_absolute_event)
 		return;
 
@@ -2196,14 +2786,14 @@ pointer_notify_button(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
-	button_event = zalloc(sizeof *button_event);
-	if (!button_event)
-		return;
-
 	seat_button_count = update_seat_button_count(device->seat,
 						     button,
 						     state);
 
+	button_event = event_pool_take(device, LIBINPUT_EVENT_POINTER_BUTTON);
+	if (!button_event)
+		return;
+
 	*button_event = (struct libinput_event_pointer) {
 		.time = time,
 		.button = button,
@@ -2229,7 +2819,7 @@ pointer_notify_axis(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_POINTER))
 		return;
 
-	axis_event = zalloc(sizeof *axis_event);
+	axis_event = event_pool_take(device, LIBINPUT_EVENT_POINTER_AXIS);
 	if (!axis_event)
 		return;
 
@@ -2251,14 +2841,15 @@ touch_notify_touch_down(struct libinput_device *device,
 			uint64_t time,
 			int32_t slot,
 			int32_t seat_slot,
-			const struct device_coords *point)
+			const struct device_coords *point,
+			const struct device_coords *predicted)
 {
 	struct libinput_event_touch *touch_event;
 
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
-	touch_event = zalloc(sizeof *touch_event);
+	touch_event = event_pool_take(device, LIBINPUT_EVENT_TOUCH_DOWN);
 	if (!touch_event)
 		return;
 
@@ -2267,6 +2858,7 @@ touch_notify_touch_down(struct libinput_device *device,
 		.slot = slot,
 		.seat_slot = seat_slot,
 		.point = *point,
+		.predicted = *predicted,
 	};
 
 	post_device_event(device, time,
@@ -2279,14 +2871,15 @@ touch_notify_touch_motion(struct libinput_device *device,
 			  uint64_t time,
 			  int32_t slot,
 			  int32_t seat_slot,
-			  const struct device_coords *point)
+			  const struct device_coords *point,
+			  const struct device_coords *predicted)
 {
 	struct libinput_event_touch *touch_event;
 
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
-	touch_event = zalloc(sizeof *touch_event);
+	touch_event = event_pool_take(device, LIBINPUT_EVENT_TOUCH_MOTION);
 	if (!touch_event)
 		return;
 
@@ -2295,6 +2888,7 @@ touch_notify_touch_motion(struct libinput_device *device,
 		.slot = slot,
 		.seat_slot = seat_slot,
 		.point = *point,
+		.predicted = *predicted,
 	};
 
 	post_device_event(device, time,
@@ -2313,7 +2907,7 @@ touch_notify_touch_up(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
-	touch_event = zalloc(sizeof *touch_event);
+	touch_event = event_pool_take(device, LIBINPUT_EVENT_TOUCH_UP);
 	if (!touch_event)
 		return;
 
@@ -2337,7 +2931,7 @@ touch_notify_frame(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_TOUCH))
 		return;
 
-	touch_event = zalloc(sizeof *touch_event);
+	touch_event = event_pool_take(device, LIBINPUT_EVENT_TOUCH_FRAME);
 	if (!touch_event)
 		return;
 
@@ -2360,7 +2954,7 @@ tablet_notify_axis(struct libinput_device *device,
 {
 	struct libinput_event_tablet_tool *axis_event;
 
-	axis_event = zalloc(sizeof *axis_event);
+	axis_event = event_pool_take(device, LIBINPUT_EVENT_TABLET_TOOL_AXIS);
 	if (!axis_event)
 		return;
 
@@ -2392,7 +2986,8 @@ tablet_notify_proximity(struct libinput_device *device,
 {
 	struct libinput_event_tablet_tool *proximity_event;
 
-	proximity_event = zalloc(sizeof *proximity_event);
+	proximity_event = event_pool_take(device,
+					  LIBINPUT_EVENT_TABLET_TOOL_PROXIMITY);
 	if (!proximity_event)
 		return;
 
@@ -2423,7 +3018,7 @@ tablet_notify_tip(struct libinput_device *device,
 {
 	struct libinput_event_tablet_tool *tip_event;
 
-	tip_event = zalloc(sizeof *tip_event);
+	tip_event = event_pool_take(device, LIBINPUT_EVENT_TABLET_TOOL_TIP);
 	if (!tip_event)
 		return;
 
@@ -2456,14 +3051,15 @@ tablet_notify_button(struct libinput_device *device,
 	struct libinput_event_tablet_tool *button_event;
 	int32_t seat_button_count;
 
-	button_event = zalloc(sizeof *button_event);
-	if (!button_event)
-		return;
-
 	seat_button_count = update_seat_button_count(device->seat,
 						     button,
 						     state);
 
+	button_event = event_pool_take(device,
+				       LIBINPUT_EVENT_TABLET_TOOL_BUTTON);
+	if (!button_event)
+		return;
+
 	*button_event = (struct libinput_event_tablet_tool) {
 		.time = time,
 		.tool = libinput_tablet_tool_ref(tool),
@@ -2491,7 +3087,8 @@ tablet_pad_notify_button(struct libinput_device *device,
 	struct libinput_event_tablet_pad *button_event;
 	unsigned int mode;
 
-	button_event = zalloc(sizeof *button_event);
+	button_event = event_pool_take(device,
+				       LIBINPUT_EVENT_TABLET_PAD_BUTTON);
 	if (!button_event)
 		return;
 
@@ -2522,7 +3119,7 @@ tablet_pad_notify_ring(struct libinput_device *device,
 	struct libinput_event_tablet_pad *ring_event;
 	unsigned int mode;
 
-	ring_event = zalloc(sizeof *ring_event);
+	ring_event = event_pool_take(device, LIBINPUT_EVENT_TABLET_PAD_RING);
 	if (!ring_event)
 		return;
 
@@ -2554,7 +3151,7 @@ tablet_pad_notify_strip(struct libinput_device *device,
 	struct libinput_event_tablet_pad *strip_event;
 	unsigned int mode;
 
-	strip_event = zalloc(sizeof *strip_event);
+	strip_event = event_pool_take(device, LIBINPUT_EVENT_TABLET_PAD_STRIP);
 	if (!strip_event)
 		return;
 
@@ -2591,7 +3188,7 @@ gesture_notify(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_GESTURE))
 		return;
 
-	gesture_event = zalloc(sizeof *gesture_event);
+	gesture_event = event_pool_take(device, type);
 	if (!gesture_event)
 		return;
 
@@ -2708,7 +3305,7 @@ switch_notify_toggle(struct libinput_device *device,
 	if (!device_has_cap(device, LIBINPUT_DEVICE_CAP_SWITCH))
 		return;
 
-	switch_event = zalloc(sizeof *switch_event);
+	switch_event = event_pool_take(device, LIBINPUT_EVENT_SWITCH_TOGGLE);
 	if (!switch_event)
 		return;
 
@@ -2723,9 +3320,9 @@ switch_notify_toggle(struct libinput_device *device,
 			  &switch_event->base);
 }
 
-static void
-libinput_post_event(struct libinput *libinput,
-		    struct libinput_event *event)
+static bool
+event_queue_append(struct libinput *libinput,
+		   struct libinput_event *event)
 {
 	struct libinput_event **events = libinput->events;
 	size_t events_len = libinput->events_len;
@@ -2740,12 +3337,16 @@ libinput_post_event(struct libinput *libinput,
 	events_count++;
 	if (events_count > events_len) {
 		events_len *= 2;
+		if (libinput->event_queue.max_events != 0)
+			events_len = min(events_len,
+					 max(libinput->event_queue.max_events,
+					     events_count));
 		events = realloc(events, events_len * sizeof *events);
 		if (!events) {
 			log_error(libinput,
 				  "Failed to reallocate event ring buffer. "
 				  "Events may be discarded\n");
-			return;
+			return false;
 		}
 
 		if (libinput->events_count > 0 && libinput->events_in == 0) {
@@ -2764,16 +3365,15 @@ libinput_post_event(struct libinput *libinput,
 		libinput->events_len = events_len;
 	}
 
-	if (event->device)
-		libinput_device_ref(event->device);
-
 	libinput->events_count = events_count;
 	events[libinput->events_in] = event;
 	libinput->events_in = (libinput->events_in + 1) % libinput->events_len;
+
+	return true;
 }
 
-LIBINPUT_EXPORT struct libinput_event *
-libinput_get_event(struct libinput *libinput)
+static struct libinput_event *
+event_queue_pop(struct libinput *libinput)
 {
 	struct libinput_event *event;
 
@@ -2788,11 +3388,385 @@ libinput_get_event(struct libinput *libinput)
 	return event;
 }
 
+static inline struct libinput_event **
+event_queue_at(struct libinput *libinput, size_t n)
+{
+	return &libinput->events[(libinput->events_out + n) %
+				 libinput->events_len];
+}
+
+static inline bool
+event_is_mergeable_motion(struct libinput_event *a,
+			  struct libinput_event *b)
+{
+	return a->type == LIBINPUT_EVENT_POINTER_MOTION &&
+	       b->type == LIBINPUT_EVENT_POINTER_MOTION &&
+	       a->device == b->device;
+}
+
+static void
+pointer_event_merge_motion(struct libinput_event *dest,
+			   struct libinput_event *src)
+{
+	struct libinput_event_pointer *queued, *motion;
+
+	queued = (struct libinput_event_pointer *) dest;
+	motion = (struct libinput_event_pointer *) src;
+
+	queued->time = motion->time;
+	queued->delta.x += motion->delta.x;
+	queued->delta.y += motion->delta.y;
+	queued->delta_raw.x += motion->delta_raw.x;
+	queued->delta_raw.y += motion->delta_raw.y;
+	/* the prediction is relative to the newest motion */
+	queued->predicted_raw = motion->predicted_raw;
+}
+
+/**
+ * Fold a pointer motion event into the motion event at the tail of the
+ * queue if both come from the same device. Only the tail is considered,
+ * merging across any other event would change the event order.
+ *
+ * @return true if the event was folded and may be released
+ */
+static bool
+event_queue_coalesce_motion(struct libinput *libinput,
+			    struct libinput_event *event)
+{
+	struct libinput_event *tail;
+
+	if (libinput->events_count == 0)
+		return false;
+
+	tail = *event_queue_at(libinput, libinput->events_count - 1);
+	if (!event_is_mergeable_motion(tail, event))
+		return false;
+
+	pointer_event_merge_motion(tail, event);
+	libinput->motion_events_coalesced++;
+
+	return true;
+}
+
+/**
+ * Remove the n-th queued event, counted from the head of the queue. The
+ * events before it move up by one, the caller owns the removed event.
+ */
+static struct libinput_event *
+event_queue_remove(struct libinput *libinput, size_t n)
+{
+	struct libinput_event *event = *event_queue_at(libinput, n);
+
+	for (; n > 0; n--)
+		*event_queue_at(libinput, n) = *event_queue_at(libinput, n - 1);
+
+	libinput->events_out =
+		(libinput->events_out + 1) % libinput->events_len;
+	libinput->events_count--;
+
+	return event;
+}
+
+static void
+event_queue_note_dropped(struct libinput *libinput,
+			 struct libinput_event *event)
+{
+	libinput->event_queue.dropped[event_type_slot(event->type)]++;
+	libinput->event_queue.dropped_total++;
+}
+
+static inline bool
+event_is_motion(struct libinput_event *event)
+{
+	switch (event->type) {
+	case LIBINPUT_EVENT_POINTER_MOTION:
+	case LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE:
+	case LIBINPUT_EVENT_TOUCH_MOTION:
+	case LIBINPUT_EVENT_TABLET_TOOL_AXIS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static inline bool
+event_is_device_notify(struct libinput_event *event)
+{
+	return event->type == LIBINPUT_EVENT_DEVICE_ADDED ||
+	       event->type == LIBINPUT_EVENT_DEVICE_REMOVED;
+}
+
+static bool
+event_queue_drop_oldest_motion(struct libinput *libinput)
+{
+	struct libinput_event *event;
+	size_t n;
+
+	for (n = 0; n < libinput->events_count; n++) {
+		event = *event_queue_at(libinput, n);
+		if (!event_is_motion(event))
+			continue;
+
+		event_queue_remove(libinput, n);
+		event_queue_note_dropped(libinput, event);
+		libinput_event_release(libinput, event);
+		return true;
+	}
+
+	return false;
+}
+
+/**
+ * Merge the oldest pair of adjacent mergeable motion events in the
+ * queue, freeing up one slot.
+ */
+static bool
+event_queue_coalesce_oldest(struct libinput *libinput)
+{
+	struct libinput_event *prev, *next;
+	size_t n;
+
+	for (n = 1; n < libinput->events_count; n++) {
+		prev = *event_queue_at(libinput, n - 1);
+		next = *event_queue_at(libinput, n);
+		if (!event_is_mergeable_motion(prev, next))
+			continue;
+
+		pointer_event_merge_motion(prev, next);
+		event_queue_remove(libinput, n);
+		libinput_event_release(libinput, next);
+		libinput->motion_events_coalesced++;
+		return true;
+	}
+
+	return false;
+}
+
+static inline void
+event_note_dequeued(struct libinput *libinput,
+		    struct libinput_event *event)
+{
+	struct libinput_device *device = event->device;
+
+	if (device && device->latency && event->queued_time)
+		latency_record(device,
+			       LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED,
+			       event->queued_time,
+			       libinput_now(libinput));
+}
+
+static void
+event_handler_deliver(struct libinput *libinput,
+		      struct libinput_event *event)
+{
+	event->transient = true;
+	libinput->event_handler.running = true;
+	libinput->event_handler.func(event, libinput->event_handler.data);
+	libinput->event_handler.running = false;
+	event->transient = false;
+}
+
+/* The handler runs in the middle of a device's frame or a timer
+ * callback, anything that adds, removes, suspends or reconfigures a
+ * device would change state the caller of the handler still uses. See
+ * libinput_dispatch_with_handler() for the list of these calls. */
+bool
+libinput_called_from_handler(struct libinput *libinput, const char *func)
+{
+	if (!libinput->event_handler.running)
+		return false;
+
+	log_bug_client(libinput,
+		       "%s called from within an event handler\n",
+		       func);
+	return true;
+}
+
+static void
+libinput_post_event(struct libinput *libinput,
+		    struct libinput_event *event)
+{
+	/* Inside libinput_dispatch_with_handler() the event goes straight
+	 * to the caller, it never holds a device reference */
+	if (libinput->event_handler.func) {
+		event_note_dequeued(libinput, event);
+		event_handler_deliver(libinput, event);
+		libinput_event_discard(libinput, event);
+		return;
+	}
+
+	/* The device isn't referenced until the event is queued, events
+	 * not making it into the queue are discarded right away */
+	if (libinput->coalesce_motion &&
+	    event_queue_coalesce_motion(libinput, event)) {
+		libinput_event_discard(libinput, event);
+		return;
+	}
+
+	/* A caller missing a device removal would hold on to a dead
+	 * device forever, device notifications are queued regardless of
+	 * the limit */
+	if (libinput->event_queue.max_events != 0 &&
+	    libinput->events_count >= libinput->event_queue.max_events &&
+	    !event_is_device_notify(event)) {
+		switch (libinput->event_queue.overflow) {
+		case LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_NEWEST:
+			goto drop;
+		case LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_OLDEST_MOTION:
+			if (!event_queue_drop_oldest_motion(libinput))
+				goto drop;
+			break;
+		case LIBINPUT_EVENT_QUEUE_OVERFLOW_COALESCE:
+			if (event_queue_coalesce_motion(libinput, event)) {
+				libinput_event_discard(libinput, event);
+				return;
+			}
+			if (!event_queue_coalesce_oldest(libinput))
+				goto drop;
+			break;
+		}
+	}
+
+	if (!event_queue_append(libinput, event)) {
+		libinput_event_discard(libinput, event);
+		return;
+	}
+
+	if (event->device)
+		libinput_device_ref(event->device);
+
+	return;
+
+drop:
+	event_queue_note_dropped(libinput, event);
+	libinput_event_discard(libinput, event);
+}
+
+static struct libinput_event *
+input_thread_get_event(struct libinput *libinput);
+
+LIBINPUT_EXPORT struct libinput_event *
+libinput_get_event(struct libinput *libinput)
+{
+	struct libinput_event *event;
+
+	if (libinput->thread.running)
+		event = input_thread_get_event(libinput);
+	else
+		event = event_queue_pop(libinput);
+
+	if (event)
+		event_note_dequeued(libinput, event);
+
+	return event;
+}
+
+LIBINPUT_EXPORT size_t
+libinput_get_events(struct libinput *libinput,
+		    struct libinput_event **events,
+		    size_t max_events)
+{
+	size_t count, tail_count, i;
+
+	if (libinput->thread.running) {
+		for (count = 0; count < max_events; count++) {
+			events[count] = input_thread_get_event(libinput);
+			if (!events[count])
+				break;
+			event_note_dequeued(libinput, events[count]);
+		}
+		return count;
+	}
+
+	count = min(max_events, libinput->events_count);
+	if (count == 0)
+		return 0;
+
+	/* The queued events may wrap around the end of the ring */
+	tail_count = min(count, libinput->events_len - libinput->events_out);
+	memcpy(events,
+	       libinput->events + libinput->events_out,
+	       tail_count * sizeof *events);
+	if (count > tail_count)
+		memcpy(events + tail_count,
+		       libinput->events,
+		       (count - tail_count) * sizeof *events);
+
+	libinput->events_out =
+		(libinput->events_out + count) % libinput->events_len;
+	libinput->events_count -= count;
+
+	for (i = 0; i < count; i++)
+		event_note_dequeued(libinput, events[i]);
+
+	return count;
+}
+
+LIBINPUT_EXPORT void
+libinput_events_destroy(struct libinput_event **events,
+			size_t nevents)
+{
+	size_t i;
+
+	for (i = 0; i < nevents; i++)
+		libinput_event_destroy(events[i]);
+}
+
+LIBINPUT_EXPORT int
+libinput_dispatch_with_handler(struct libinput *libinput,
+			       libinput_event_handler handler,
+			       void *user_data)
+{
+	struct libinput_event *event;
+	int rc;
+
+	if (!handler) {
+		log_bug_client(libinput, "%s called without a handler\n",
+			       __func__);
+		return -EINVAL;
+	}
+
+	if (libinput->thread.running) {
+		log_bug_client(libinput,
+			       "Event handlers cannot be used with the input thread\n");
+		return -EINVAL;
+	}
+
+	if (libinput->event_handler.func) {
+		log_bug_client(libinput,
+			       "%s called from within an event handler\n",
+			       __func__);
+		return -EINVAL;
+	}
+
+	libinput->event_handler.func = handler;
+	libinput->event_handler.data = user_data;
+
+	/* Events queued before this call go first to keep the order */
+	while ((event = event_queue_pop(libinput))) {
+		event_note_dequeued(libinput, event);
+		event_handler_deliver(libinput, event);
+		libinput_event_release(libinput, event);
+	}
+
+	rc = libinput_dispatch(libinput);
+
+	libinput->event_handler.func = NULL;
+	libinput->event_handler.data = NULL;
+
+	return rc;
+}
+
 LIBINPUT_EXPORT enum libinput_event_type
 libinput_next_event_type(struct libinput *libinput)
 {
 	struct libinput_event *event;
 
+	if (libinput->thread.running) {
+		event = event_ring_peek(&libinput->thread.events);
+		return event ? event->type : LIBINPUT_EVENT_NONE;
+	}
+
 	if (libinput->events_count == 0)
 		return LIBINPUT_EVENT_NONE;
 
@@ -2800,6 +3774,372 @@ libinput_next_event_type(struct libinput *libinput)
 	return event->type;
 }
 
+#define INPUT_THREAD_RING_SIZE 1024
+
+static void
+input_thread_wake_dispatch(void *data)
+{
+	struct libinput *libinput = data;
+	uint64_t discard;
+
+	if (read(libinput->thread.wake_fd, &discard, sizeof discard) < 0)
+		return;
+}
+
+/* Input thread: releases the events the caller has destroyed */
+static void
+input_thread_release_events(struct libinput *libinput)
+{
+	struct libinput_event *event;
+
+	while ((event = event_ring_pop(&libinput->thread.released)))
+		libinput_event_release(libinput, event);
+}
+
+/* Input thread: moves the queued events into the ring for the caller */
+static void
+input_thread_publish_events(struct libinput *libinput)
+{
+	struct event_ring *ring = &libinput->thread.events;
+	struct libinput_event *event;
+	bool published = false;
+
+	while (libinput->events_count > 0) {
+		event = libinput->events[libinput->events_out];
+
+		if (!event_ring_push(ring, event)) {
+			/* The caller wakes us up once it made space. It
+			 * may have done so just before we set the flag,
+			 * so try again. */
+			__atomic_store_n(&libinput->thread.backlog,
+					 true,
+					 __ATOMIC_SEQ_CST);
+			__atomic_thread_fence(__ATOMIC_SEQ_CST);
+			if (!event_ring_push(ring, event))
+				break;
+		}
+
+		event_queue_pop(libinput);
+		published = true;
+	}
+
+	if (published)
+		eventfd_notify(libinput->thread.event_fd);
+}
+
+/* Caller's thread */
+static struct libinput_event *
+input_thread_get_event(struct libinput *libinput)
+{
+	struct libinput_event *event;
+
+	event = event_ring_pop(&libinput->thread.events);
+	if (!event)
+		return NULL;
+
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&libinput->thread.backlog, __ATOMIC_SEQ_CST) &&
+	    __atomic_exchange_n(&libinput->thread.backlog,
+				false,
+				__ATOMIC_SEQ_CST))
+		eventfd_notify(libinput->thread.wake_fd);
+
+	return event;
+}
+
+static void *
+input_thread_func(void *data)
+{
+	struct libinput *libinput = data;
+	struct epoll_event ep[DISPATCH_EPOLL_EVENTS];
+	int count;
+
+	while (!__atomic_load_n(&libinput->thread.quit, __ATOMIC_ACQUIRE)) {
+		count = epoll_wait(libinput->epoll_fd,
+				   ep,
+				   ARRAY_LENGTH(ep),
+				   -1);
+		if (count < 0) {
+			if (errno == EINTR)
+				continue;
+
+			log_error(libinput,
+				  "input thread: epoll_wait failed (%s)\n",
+				  strerror(errno));
+			break;
+		}
+
+		pthread_mutex_lock(&libinput->thread.lock);
+		input_thread_release_events(libinput);
+		libinput_dispatch_sources(libinput, ep, count);
+		input_thread_publish_events(libinput);
+		pthread_mutex_unlock(&libinput->thread.lock);
+	}
+
+	return NULL;
+}
+
+/* Events published but not yet retrieved are older than the ones still
+ * in the queue, put them back in front */
+static void
+input_thread_requeue_events(struct libinput *libinput)
+{
+	struct libinput_event *event;
+	size_t nqueued = libinput->events_count;
+
+	while ((event = event_ring_pop(&libinput->thread.events))) {
+		/* the event holds a device reference, drop both */
+		if (!event_queue_append(libinput, event))
+			libinput_event_release(libinput, event);
+	}
+
+	/* Each append follows a pop, the queue doesn't need to grow */
+	while (nqueued--)
+		event_queue_append(libinput, event_queue_pop(libinput));
+}
+
+static void
+input_thread_cleanup(struct libinput *libinput)
+{
+	if (libinput->thread.wake_source) {
+		libinput_remove_source(libinput, libinput->thread.wake_source);
+		libinput->thread.wake_source = NULL;
+	}
+	if (libinput->thread.wake_fd != -1)
+		close(libinput->thread.wake_fd);
+	if (libinput->thread.event_fd != -1)
+		close(libinput->thread.event_fd);
+	libinput->thread.wake_fd = -1;
+	libinput->thread.event_fd = -1;
+
+	event_ring_destroy(&libinput->thread.events);
+	event_ring_destroy(&libinput->thread.released);
+}
+
+LIBINPUT_EXPORT int
+libinput_input_thread_start(struct libinput *libinput)
+{
+	pthread_mutexattr_t attr;
+	int rc;
+
+	if (libinput_called_from_handler(libinput, __func__))
+		return -EINVAL;
+
+	if (libinput->thread.running) {
+		log_bug_client(libinput, "Input thread is already running\n");
+		return -EALREADY;
+	}
+
+	libinput->thread.event_fd = -1;
+	libinput->thread.wake_fd = -1;
+
+	if (!event_ring_init(&libinput->thread.events,
+			     INPUT_THREAD_RING_SIZE) ||
+	    !event_ring_init(&libinput->thread.released,
+			     INPUT_THREAD_RING_SIZE)) {
+		rc = -ENOMEM;
+		goto error;
+	}
+
+	libinput->thread.event_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+	if (libinput->thread.event_fd == -1) {
+		rc = -errno;
+		goto error;
+	}
+
+	libinput->thread.wake_fd = eventfd(0, EFD_CLOEXEC|EFD_NONBLOCK);
+	if (libinput->thread.wake_fd == -1) {
+		rc = -errno;
+		goto error;
+	}
+
+	libinput->thread.wake_source =
+		libinput_add_fd(libinput,
+				libinput->thread.wake_fd,
+				input_thread_wake_dispatch,
+				libinput);
+	if (!libinput->thread.wake_source) {
+		rc = -ENOMEM;
+		goto error;
+	}
+
+	/* The lock may be taken again by libinput_event_destroy() while
+	 * the caller holds it */
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&libinput->thread.lock, &attr);
+	pthread_mutexattr_destroy(&attr);
+
+	/* Hand over whatever is queued already */
+	input_thread_publish_events(libinput);
+
+	libinput->thread.quit = false;
+	libinput->thread.running = true;
+
+	rc = pthread_create(&libinput->thread.thread,
+			    NULL,
+			    input_thread_func,
+			    libinput);
+	if (rc != 0) {
+		libinput->thread.running = false;
+		pthread_mutex_destroy(&libinput->thread.lock);
+		rc = -rc;
+		goto error;
+	}
+
+	return 0;
+
+error:
+	if (libinput->thread.events.slots)
+		input_thread_requeue_events(libinput);
+	input_thread_cleanup(libinput);
+	return rc;
+}
+
+LIBINPUT_EXPORT void
+libinput_input_thread_stop(struct libinput *libinput)
+{
+	if (!libinput->thread.running)
+		return;
+
+	__atomic_store_n(&libinput->thread.quit, true, __ATOMIC_RELEASE);
+	eventfd_notify(libinput->thread.wake_fd);
+	pthread_join(libinput->thread.thread, NULL);
+
+	libinput->thread.running = false;
+	pthread_mutex_destroy(&libinput->thread.lock);
+
+	input_thread_release_events(libinput);
+	input_thread_requeue_events(libinput);
+	input_thread_cleanup(libinput);
+}
+
+LIBINPUT_EXPORT void
+libinput_lock(struct libinput *libinput)
+{
+	if (libinput->thread.running)
+		pthread_mutex_lock(&libinput->thread.lock);
+}
+
+LIBINPUT_EXPORT void
+libinput_unlock(struct libinput *libinput)
+{
+	if (libinput->thread.running)
+		pthread_mutex_unlock(&libinput->thread.lock);
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_get_statistic(struct libinput *libinput,
+		       enum libinput_statistic statistic)
+{
+	switch (statistic) {
+	case LIBINPUT_STATISTIC_EVENT_POOL_HITS:
+		return libinput->event_pool.hits;
+	case LIBINPUT_STATISTIC_EVENT_POOL_MISSES:
+		return libinput->event_pool.misses;
+	case LIBINPUT_STATISTIC_EVENT_POOL_HIGH_WATER_MARK:
+		return libinput->event_pool.high_water_mark;
+	case LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED:
+		return libinput->motion_events_coalesced;
+	case LIBINPUT_STATISTIC_EVENTS_DROPPED:
+		return libinput->event_queue.dropped_total;
+	}
+
+	log_bug_client(libinput,
+		       "Invalid statistic %d requested\n",
+		       statistic);
+
+	return 0;
+}
+
+LIBINPUT_EXPORT void
+libinput_set_motion_coalescing(struct libinput *libinput,
+			       int enable)
+{
+	libinput->coalesce_motion = !!enable;
+}
+
+LIBINPUT_EXPORT int
+libinput_get_motion_coalescing(struct libinput *libinput)
+{
+	return libinput->coalesce_motion;
+}
+
+LIBINPUT_EXPORT int
+libinput_set_event_queue_limit(struct libinput *libinput,
+			       size_t max_events,
+			       enum libinput_event_queue_overflow overflow)
+{
+	switch (overflow) {
+	case LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_NEWEST:
+	case LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_OLDEST_MOTION:
+	case LIBINPUT_EVENT_QUEUE_OVERFLOW_COALESCE:
+		break;
+	default:
+		log_bug_client(libinput,
+			       "Invalid overflow policy %d\n",
+			       overflow);
+		return -1;
+	}
+
+	libinput->event_queue.max_events = max_events;
+	libinput->event_queue.overflow = overflow;
+
+	return 0;
+}
+
+static inline bool
+event_type_is_valid(enum libinput_event_type type)
+{
+	return type != LIBINPUT_EVENT_NONE && event_type_to_str(type) != NULL;
+}
+
+LIBINPUT_EXPORT uint64_t
+libinput_get_dropped_event_count(struct libinput *libinput,
+				 enum libinput_event_type type)
+{
+	if (!event_type_is_valid(type)) {
+		log_bug_client(libinput,
+			       "Invalid event type %d\n",
+			       type);
+		return 0;
+	}
+
+	return libinput->event_queue.dropped[event_type_slot(type)];
+}
+
+LIBINPUT_EXPORT int
+libinput_set_event_type_enabled(struct libinput *libinput,
+				enum libinput_event_type type,
+				int enabled)
+{
+	if (!event_type_is_valid(type) ||
+	    type == LIBINPUT_EVENT_DEVICE_ADDED ||
+	    type == LIBINPUT_EVENT_DEVICE_REMOVED) {
+		log_bug_client(libinput,
+			       "Event type %d cannot be %s\n",
+			       type,
+			       enabled ? "enabled" : "disabled");
+		return -1;
+	}
+
+	long_set_bit_state(libinput->event_types_disabled,
+			   event_type_slot(type),
+			   !enabled);
+
+	return 0;
+}
+
+LIBINPUT_EXPORT int
+libinput_get_event_type_enabled(struct libinput *libinput,
+				enum libinput_event_type type)
+{
+	if (!event_type_is_valid(type))
+		return 0;
+
+	return !event_type_disabled(libinput, type);
+}
+
 LIBINPUT_EXPORT void
 libinput_set_user_data(struct libinput *libinput,
 		       void *user_data)
@@ -2816,12 +4156,18 @@ libinput_get_user_data(struct libinput *libinput)
 LIBINPUT_EXPORT int
 libinput_resume(struct libinput *libinput)
 {
+	if (libinput_called_from_handler(libinput, __func__))
+		return -1;
+
 	return libinput->interface_backend->resume(libinput);
 }
 
 LIBINPUT_EXPORT void
 libinput_suspend(struct libinput *libinput)
 {
+	if (libinput_called_from_handler(libinput, __func__))
+		return;
+
 	libinput->interface_backend->suspend(libinput);
 }
 
@@ -2894,6 +4240,9 @@ libinput_device_set_seat_logical_name(struct libinput_device *device,
 	if (name == NULL)
 		return -1;
 
+	if (libinput_called_from_handler(libinput, __func__))
+		return -1;
+
 	return libinput->interface_backend->device_change_seat(device,
 							       name);
 }
@@ -2919,6 +4268,69 @@ libinput_device_has_capability(struct libinput_device *device,
 					   capability);
 }
 
+void
+latency_record(struct libinput_device *device,
+	       enum libinput_latency_stage stage,
+	       uint64_t from,
+	       uint64_t to)
+{
+	uint64_t latency = to > from ? to - from : 0;
+	unsigned int bucket = 0;
+
+	while (latency > 1 && bucket < LATENCY_HISTOGRAM_BUCKETS - 1) {
+		latency >>= 1;
+		bucket++;
+	}
+
+	device->latency->buckets[stage - 1][bucket]++;
+}
+
+LIBINPUT_EXPORT int
+libinput_device_set_latency_tracking(struct libinput_device *device,
+				     int enable)
+{
+	free(device->latency);
+	device->latency = NULL;
+
+	if (!enable)
+		return 0;
+
+	device->latency = zalloc(sizeof *device->latency);
+	if (!device->latency)
+		return -ENOMEM;
+
+	return 0;
+}
+
+LIBINPUT_EXPORT size_t
+libinput_device_get_latency_histogram(struct libinput_device *device,
+				      enum libinput_latency_stage stage,
+				      uint64_t *buckets,
+				      size_t nbuckets)
+{
+	switch (stage) {
+	case LIBINPUT_LATENCY_KERNEL_TO_READ:
+	case LIBINPUT_LATENCY_READ_TO_QUEUED:
+	case LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED:
+		break;
+	default:
+		log_bug_client(libinput_device_get_context(device),
+			       "Invalid latency stage %d requested\n",
+			       stage);
+		return 0;
+	}
+
+	if (!device->latency)
+		return 0;
+
+	nbuckets = min(nbuckets, LATENCY_HISTOGRAM_BUCKETS);
+	memcpy(buckets,
+	       device->latency->buckets[stage - 1],
+	       nbuckets * sizeof *buckets);
+
+	return nbuckets;
+}
+
 LIBINPUT_EXPORT int
 libinput_device_get_size(struct libinput_device *device,
 			 double *width,
@@ -3419,6 +4831,13 @@ libinput_config_status_to_str(enum libinput_config_status status)
 	return str;
 }
 
+static inline bool
+device_config_called_from_handler(struct libinput_device *device,
+				  const char *func)
+{
+	return libinput_called_from_handler(device->seat->libinput, func);
+}
+
 LIBINPUT_EXPORT int
 libinput_device_config_tap_get_finger_count(struct libinput_device *device)
 {
@@ -3429,6 +4848,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_tap_set_enabled(struct libinput_device *device,
 				       enum libinput_config_tap_state enable)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (enable != LIBINPUT_CONFIG_TAP_ENABLED &&
 	    enable != LIBINPUT_CONFIG_TAP_DISABLED)
 		return LIBINPUT_CONFIG_STATUS_INVALID;
@@ -3463,6 +4885,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_tap_set_button_map(struct libinput_device *device,
 					    enum libinput_config_tap_button_map map)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	switch (map) {
 	case LIBINPUT_CONFIG_TAP_MAP_LRM:
 	case LIBINPUT_CONFIG_TAP_MAP_LMR:
@@ -3499,6 +4924,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_tap_set_drag_enabled(struct libinput_device *device,
 					    enum libinput_config_drag_state enable)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (enable != LIBINPUT_CONFIG_DRAG_ENABLED &&
 	    enable != LIBINPUT_CONFIG_DRAG_DISABLED)
 		return LIBINPUT_CONFIG_STATUS_INVALID;
@@ -3532,6 +4960,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_tap_set_drag_lock_enabled(struct libinput_device *device,
 						 enum libinput_config_drag_lock_state enable)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (enable != LIBINPUT_CONFIG_DRAG_LOCK_ENABLED &&
 	    enable != LIBINPUT_CONFIG_DRAG_LOCK_DISABLED)
 		return LIBINPUT_CONFIG_STATUS_INVALID;
@@ -3572,6 +5003,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_calibration_set_matrix(struct libinput_device *device,
 					      const float matrix[6])
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (!libinput_device_config_calibration_has_matrix(device))
 		return LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
 
@@ -3613,6 +5047,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_send_events_set_mode(struct libinput_device *device,
 					    uint32_t mode)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if ((libinput_device_config_send_events_get_modes(device) & mode) != mode)
 		return LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
 
@@ -3648,6 +5085,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_accel_set_speed(struct libinput_device *device,
 				       double speed)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	/* Need the negation in case speed is NaN */
 	if (!(speed >= -1.0 && speed <= 1.0))
 		return LIBINPUT_CONFIG_STATUS_INVALID;
@@ -3706,6 +5146,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_accel_set_profile(struct libinput_device *device,
 					 enum libinput_config_accel_profile profile)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	switch (profile) {
 	case LIBINPUT_CONFIG_ACCEL_PROFILE_FLAT:
 	case LIBINPUT_CONFIG_ACCEL_PROFILE_ADAPTIVE:
@@ -3734,6 +5177,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_scroll_set_natural_scroll_enabled(struct libinput_device *device,
 							 int enabled)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (!libinput_device_config_scroll_has_natural_scroll(device))
 		return LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
 
@@ -3771,6 +5217,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_left_handed_set(struct libinput_device *device,
 				       int left_handed)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (!libinput_device_config_left_handed_is_available(device))
 		return LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
 
@@ -3808,6 +5257,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_click_set_method(struct libinput_device *device,
 					enum libinput_config_click_method method)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	/* Check method is a single valid method */
 	switch (method) {
 	case LIBINPUT_CONFIG_CLICK_METHOD_NONE:
@@ -3863,6 +5315,9 @@ libinput_device_config_middle_emulation_set_enabled(
 	int available =
 		libinput_device_config_middle_emulation_is_available(device);
 
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	switch (enable) {
 	case LIBINPUT_CONFIG_MIDDLE_EMULATION_DISABLED:
 		if (!available)
@@ -3912,6 +5367,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_scroll_set_method(struct libinput_device *device,
 					 enum libinput_config_scroll_method method)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	/* Check method is a single valid method */
 	switch (method) {
 	case LIBINPUT_CONFIG_SCROLL_NO_SCROLL:
@@ -3954,6 +5412,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_scroll_set_button(struct libinput_device *device,
 					 uint32_t button)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if ((libinput_device_config_scroll_get_methods(device) &
 	     LIBINPUT_CONFIG_SCROLL_ON_BUTTON_DOWN) == 0)
 		return LIBINPUT_CONFIG_STATUS_UNSUPPORTED;
@@ -3997,6 +5458,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_dwt_set_enabled(struct libinput_device *device,
 				       enum libinput_config_dwt_state enable)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (enable != LIBINPUT_CONFIG_DWT_ENABLED &&
 	    enable != LIBINPUT_CONFIG_DWT_DISABLED)
 		return LIBINPUT_CONFIG_STATUS_INVALID;
@@ -4039,6 +5503,9 @@ LIBINPUT_EXPORT enum libinput_config_status
 libinput_device_config_rotation_set_angle(struct libinput_device *device,
 					  unsigned int degrees_cw)
 {
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
 	if (!libinput_device_config_rotation_is_available(device))
 		return degrees_cw ? LIBINPUT_CONFIG_STATUS_UNSUPPORTED :
 				    LIBINPUT_CONFIG_STATUS_SUCCESS;
@@ -4066,3 +5533,89 @@ libinput_device_config_rotation_get_default_angle(struct libinput_device *device
 
 	return device->config.rotation->get_default_angle(device);
 }
+
+LIBINPUT_EXPORT int
+libinput_device_config_motion_smoothing_is_available(struct libinput_device *device)
+{
+	if (!device->config.motion_smoothing)
+		return 0;
+
+	return device->config.motion_smoothing->is_available(device);
+}
+
+LIBINPUT_EXPORT enum libinput_config_status
+libinput_device_config_motion_smoothing_set_enabled(struct libinput_device *device,
+						    enum libinput_config_motion_smoothing_state enable)
+{
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
+	if (enable != LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED &&
+	    enable != LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED)
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
+	if (!libinput_device_config_motion_smoothing_is_available(device))
+		return enable ? LIBINPUT_CONFIG_STATUS_UNSUPPORTED :
+				LIBINPUT_CONFIG_STATUS_SUCCESS;
+
+	return device->config.motion_smoothing->set_enabled(device, enable);
+}
+
+LIBINPUT_EXPORT enum libinput_config_motion_smoothing_state
+libinput_device_config_motion_smoothing_get_enabled(struct libinput_device *device)
+{
+	if (!libinput_device_config_motion_smoothing_is_available(device))
+		return LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED;
+
+	return device->config.motion_smoothing->get_enabled(device);
+}
+
+LIBINPUT_EXPORT enum libinput_config_motion_smoothing_state
+libinput_device_config_motion_smoothing_get_default_enabled(struct libinput_device *device)
+{
+	if (!libinput_device_config_motion_smoothing_is_available(device))
+		return LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED;
+
+	return device->config.motion_smoothing->get_default_enabled(device);
+}
+
+LIBINPUT_EXPORT int
+libinput_device_config_prediction_is_available(struct libinput_device *device)
+{
+	if (!device->config.prediction)
+		return 0;
+
+	return device->config.prediction->is_available(device);
+}
+
+LIBINPUT_EXPORT enum libinput_config_status
+libinput_device_config_prediction_set_lookahead(struct libinput_device *device,
+						unsigned int lookahead)
+{
+	if (device_config_called_from_handler(device, __func__))
+		return LIBINPUT_CONFIG_STATUS_INVALID;
+
+	if (!libinput_device_config_prediction_is_available(device))
+		return lookahead ? LIBINPUT_CONFIG_STATUS_UNSUPPORTED :
+				   LIBINPUT_CONFIG_STATUS_SUCCESS;
+
+	return device->config.prediction->set_lookahead(device, lookahead);
+}
+
+LIBINPUT_EXPORT unsigned int
+libinput_device_config_prediction_get_lookahead(struct libinput_device *device)
+{
+	if (!libinput_device_config_prediction_is_available(device))
+		return 0;
+
+	return device->config.prediction->get_lookahead(device);
+}
+
+LIBINPUT_EXPORT unsigned int
+libinput_device_config_prediction_get_default_lookahead(struct libinput_device *device)
+{
+	if (!libinput_device_config_prediction_is_available(device))
+		return 0;
+
+	return device->config.prediction->get_default_lookahead(device);
+}
@@ -1140,6 +1140,49 @@ double
 libinput_event_pointer_get_dy_unaccelerated(
 	struct libinput_event_pointer *event);
 
+/**
+ * @ingroup event_pointer
+ *
+ * Return the unaccelerated x motion the pointer is expected to make within
+ * the device's prediction look-ahead after this event, see
+ * libinput_device_config_prediction_set_lookahead(). The prediction is an
+ * extrapolation of the recent unaccelerated motion, in the same
+ * coordinate space as libinput_event_pointer_get_dx_unaccelerated().
+ * A caller may add it to the pointer position it displays, it does not
+ * affect the position implied by the motion deltas. If the look-ahead is
+ * 0, this function returns 0.
+ *
+ * For pointer events that are not of type @ref
+ * LIBINPUT_EVENT_POINTER_MOTION, this function returns 0.
+ *
+ * @note It is an application bug to call this function for events other than
+ * @ref LIBINPUT_EVENT_POINTER_MOTION.
+ *
+ * @return The predicted unaccelerated relative x movement
+ */
+double
+libinput_event_pointer_get_predicted_dx_unaccelerated(
+	struct libinput_event_pointer *event);
+
+/**
+ * @ingroup event_pointer
+ *
+ * Return the unaccelerated y motion the pointer is expected to make within
+ * the device's prediction look-ahead after this event. See
+ * libinput_event_pointer_get_predicted_dx_unaccelerated() for details.
+ *
+ * For pointer events that are not of type @ref
+ * LIBINPUT_EVENT_POINTER_MOTION, this function returns 0.
+ *
+ * @note It is an application bug to call this function for events other than
+ * @ref LIBINPUT_EVENT_POINTER_MOTION.
+ *
+ * @return The predicted unaccelerated relative y movement
+ */
+double
+libinput_event_pointer_get_predicted_dy_unaccelerated(
+	struct libinput_event_pointer *event);
+
 /**
  * @ingroup event_pointer
  *
@@ -1539,6 +1582,96 @@ double
 libinput_event_touch_get_y_transformed(struct libinput_event_touch *event,
 				       uint32_t height);
 
+/**
+ * @ingroup event_touch
+ *
+ * Return the predicted absolute x coordinate of the touch, in mm from the
+ * top left corner of the device. This is where the touch is expected to be
+ * after the device's prediction look-ahead, see
+ * libinput_device_config_prediction_set_lookahead(). The prediction is an
+ * extrapolation of the touch's recent motion and may lie outside of the
+ * device's range. If the look-ahead is 0, this function returns the same
+ * value as libinput_event_touch_get_x().
+ *
+ * For events not of type @ref LIBINPUT_EVENT_TOUCH_DOWN, @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION, this function returns 0.
+ *
+ * @note It is an application bug to call this function for events of type
+ * other than @ref LIBINPUT_EVENT_TOUCH_DOWN or @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION.
+ *
+ * @param event The libinput touch event
+ * @return The predicted absolute x coordinate
+ */
+double
+libinput_event_touch_get_predicted_x(struct libinput_event_touch *event);
+
+/**
+ * @ingroup event_touch
+ *
+ * Return the predicted absolute y coordinate of the touch, in mm from the
+ * top left corner of the device. See libinput_event_touch_get_predicted_x()
+ * for details.
+ *
+ * For events not of type @ref LIBINPUT_EVENT_TOUCH_DOWN, @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION, this function returns 0.
+ *
+ * @note It is an application bug to call this function for events of type
+ * other than @ref LIBINPUT_EVENT_TOUCH_DOWN or @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION.
+ *
+ * @param event The libinput touch event
+ * @return The predicted absolute y coordinate
+ */
+double
+libinput_event_touch_get_predicted_y(struct libinput_event_touch *event);
+
+/**
+ * @ingroup event_touch
+ *
+ * Return the predicted absolute x coordinate of the touch, transformed to
+ * screen coordinates. See libinput_event_touch_get_predicted_x() for
+ * details.
+ *
+ * For events not of type @ref LIBINPUT_EVENT_TOUCH_DOWN, @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION, this function returns 0.
+ *
+ * @note It is an application bug to call this function for events of type
+ * other than @ref LIBINPUT_EVENT_TOUCH_DOWN or @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION.
+ *
+ * @param event The libinput touch event
+ * @param width The current output screen width
+ * @return The predicted absolute x coordinate transformed to a screen
+ * coordinate
+ */
+double
+libinput_event_touch_get_predicted_x_transformed(struct libinput_event_touch *event,
+						 uint32_t width);
+
+/**
+ * @ingroup event_touch
+ *
+ * Return the predicted absolute y coordinate of the touch, transformed to
+ * screen coordinates. See libinput_event_touch_get_predicted_x() for
+ * details.
+ *
+ * For events not of type @ref LIBINPUT_EVENT_TOUCH_DOWN, @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION, this function returns 0.
+ *
+ * @note It is an application bug to call this function for events of type
+ * other than @ref LIBINPUT_EVENT_TOUCH_DOWN or @ref
+ * LIBINPUT_EVENT_TOUCH_MOTION.
+ *
+ * @param event The libinput touch event
+ * @param height The current output screen height
+ * @return The predicted absolute y coordinate transformed to a screen
+ * coordinate
+ */
+double
+libinput_event_touch_get_predicted_y_transformed(struct libinput_event_touch *event,
+						 uint32_t height);
+
 /**
  * @ingroup event_touch
  *
@@ -2994,6 +3127,143 @@ libinput_get_fd(struct libinput *libinput);
 int
 libinput_dispatch(struct libinput *libinput);
 
+/**
+ * @ingroup base
+ *
+ * Event handler type for libinput_dispatch_with_handler().
+ *
+ * The event is owned by libinput and only valid until the handler
+ * returns. The handler must not call libinput_event_destroy() on the
+ * event and must not keep a pointer to the event or any event obtained
+ * from it, e.g. with libinput_event_get_pointer_event(). Any other
+ * object returned by the event, e.g. the device or a tablet tool, must
+ * be referenced by the caller to be used after the handler returns.
+ *
+ * @param event The event
+ * @param user_data The user data passed to
+ * libinput_dispatch_with_handler()
+ */
+typedef void (*libinput_event_handler)(struct libinput_event *event,
+				       void *user_data);
+
+/**
+ * @ingroup base
+ *
+ * Dispatch like libinput_dispatch() but pass every event to the given
+ * handler as soon as it is generated instead of queueing it. Events
+ * already queued when this function is called are passed to the handler
+ * first. When this function returns, the event queue is empty.
+ *
+ * Events passed to the handler are not queued and do not hold a
+ * reference to their device, avoiding the per-event overhead of
+ * libinput_get_event() and libinput_event_destroy(). This is intended
+ * for callers that process events synchronously.
+ *
+ * The handler is called in the middle of processing a device's events
+ * or a timer. It must not call any function that dispatches, adds,
+ * removes, suspends or reconfigures devices, these calls are rejected
+ * with an error logged while the handler runs:
+ * - libinput_dispatch() and this function, which return -EINVAL
+ * - libinput_path_add_device(), which returns NULL, and
+ *   libinput_path_remove_device()
+ * - libinput_udev_assign_seat(), libinput_resume(), which return -1,
+ *   and libinput_suspend()
+ * - libinput_device_set_seat_logical_name(), which returns -1
+ * - libinput_input_thread_start(), which returns -EINVAL
+ * - libinput_unref() if it drops the last reference, the context stays
+ *   alive
+ * - the libinput_device_config_...() functions that change a setting,
+ *   which return @ref LIBINPUT_CONFIG_STATUS_INVALID
+ *
+ * This function cannot be used while the input thread is running, see
+ * libinput_input_thread_start().
+ *
+ * @param libinput A previously initialized libinput context
+ * @param handler The handler called for each event, must not be NULL
+ * @param user_data Caller-specific data passed to the handler
+ *
+ * @return 0 on success, or a negative errno on failure
+ */
+int
+libinput_dispatch_with_handler(struct libinput *libinput,
+			       libinput_event_handler handler,
+			       void *user_data);
+
+/**
+ * @ingroup base
+ *
+ * Start a dedicated input thread for this context. The thread reads
+ * the devices, processes their events and runs libinput's timers
+ * independently of the caller's main loop. Finished events are handed
+ * to the caller through a lock-free queue.
+ *
+ * Once the thread runs, libinput_get_fd() returns a different file
+ * descriptor. It becomes readable whenever events are available; call
+ * libinput_dispatch() to clear it, then retrieve the events with
+ * libinput_get_event() as usual. A caller must re-fetch the fd after
+ * calling this function.
+ *
+ * While the thread runs, only libinput_get_fd(), libinput_dispatch(),
+ * libinput_get_event(), libinput_get_events(),
+ * libinput_next_event_type(), the libinput_event accessors and
+ * libinput_event_destroy() may be called without further precautions.
+ * Any other call on this context, its seats or its devices (including
+ * reference counting and configuration) must be wrapped in
+ * libinput_lock() and libinput_unlock().
+ *
+ * The log handler and the open_restricted and close_restricted
+ * callbacks of the @ref libinput_interface are invoked from the input
+ * thread.
+ *
+ * @param libinput A previously initialized libinput context
+ * @return 0 on success, or a negative errno on failure
+ *
+ * @see libinput_input_thread_stop
+ */
+int
+libinput_input_thread_start(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Stop the input thread started with libinput_input_thread_start() and
+ * return to dispatching from the caller's thread. Events that have not
+ * been retrieved yet stay in the event queue. A caller must re-fetch the
+ * fd with libinput_get_fd() after calling this function.
+ *
+ * This function must not be called while holding the lock taken with
+ * libinput_lock(). If no input thread is running, this function does
+ * nothing.
+ *
+ * @param libinput A previously initialized libinput context
+ */
+void
+libinput_input_thread_stop(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Block the input thread from processing events until
+ * libinput_unlock() is called. This is required around any call that
+ * is not safe to make while the input thread runs, see
+ * libinput_input_thread_start(). If no input thread is running, this
+ * function does nothing.
+ *
+ * @param libinput A previously initialized libinput context
+ */
+void
+libinput_lock(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * Release the lock taken with libinput_lock().
+ *
+ * @param libinput A previously initialized libinput context
+ */
+void
+libinput_unlock(struct libinput *libinput);
+
 /**
  * @ingroup base
  *
@@ -3008,6 +3278,47 @@ libinput_dispatch(struct libinput *libinput);
 struct libinput_event *
 libinput_get_event(struct libinput *libinput);
 
+/**
+ * @ingroup base
+ *
+ * Retrieve up to max_events events from libinput's internal event queue.
+ * The events are stored in the caller-provided array in the same order as
+ * they would be returned by repeated calls to libinput_get_event().
+ *
+ * After handling the retrieved events, the caller must destroy each event
+ * using libinput_event_destroy() or all of them at once using
+ * libinput_events_destroy().
+ *
+ * @param libinput A previously initialized libinput context
+ * @param events An array with space for at least max_events events
+ * @param max_events The maximum number of events to retrieve
+ * @return The number of events stored in events, or 0 if no event is
+ * available.
+ *
+ * @see libinput_events_destroy
+ */
+size_t
+libinput_get_events(struct libinput *libinput,
+		    struct libinput_event **events,
+		    size_t max_events);
+
+/**
+ * @ingroup event
+ *
+ * Destroy an array of events, freeing all associated resources. This is
+ * equivalent to calling libinput_event_destroy() on each event in the
+ * array, NULL entries are ignored. The array itself is not freed.
+ *
+ * @param events An array of events retrieved by libinput_get_events() or
+ * libinput_get_event()
+ * @param nevents The number of events in the array
+ *
+ * @see libinput_get_events
+ */
+void
+libinput_events_destroy(struct libinput_event **events,
+			size_t nevents);
+
 /**
  * @ingroup base
  *
@@ -3022,6 +3333,224 @@ libinput_get_event(struct libinput *libinput);
 enum libinput_event_type
 libinput_next_event_type(struct libinput *libinput);
 
+/**
+ * @ingroup base
+ *
+ * Statistics about the internal state of a libinput context, see
+ * libinput_get_statistic().
+ */
+enum libinput_statistic {
+	/**
+	 * The number of events allocated from the context's event pool
+	 * without needing to allocate new memory.
+	 */
+	LIBINPUT_STATISTIC_EVENT_POOL_HITS = 1,
+	/**
+	 * The number of events for which the event pool had to allocate new
+	 * memory.
+	 */
+	LIBINPUT_STATISTIC_EVENT_POOL_MISSES,
+	/**
+	 * The highest number of events allocated at any one time, i.e.
+	 * events queued in the context plus events retrieved by the caller
+	 * but not yet destroyed with libinput_event_destroy().
+	 */
+	LIBINPUT_STATISTIC_EVENT_POOL_HIGH_WATER_MARK,
+	/**
+	 * The number of pointer motion events merged into an already
+	 * queued motion event, see libinput_set_motion_coalescing().
+	 */
+	LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED,
+	/**
+	 * The number of events discarded because the event queue was full,
+	 * see libinput_set_event_queue_limit().
+	 */
+	LIBINPUT_STATISTIC_EVENTS_DROPPED,
+};
+
+/**
+ * @ingroup base
+ *
+ * Return the current value of a statistic about the context's internal
+ * state. Statistics are accumulated over the lifetime of the context and
+ * are intended for performance analysis and debugging only.
+ *
+ * libinput allocates events from a per-context pool and returns them to
+ * that pool in libinput_event_destroy(). The pool only grows, memory is
+ * released when the context is destroyed.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param statistic The statistic to query
+ * @return The current value of the statistic or 0 if the statistic is
+ * invalid
+ */
+uint64_t
+libinput_get_statistic(struct libinput *libinput,
+		       enum libinput_statistic statistic);
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable coalescing of pointer motion events. When enabled, a
+ * @ref LIBINPUT_EVENT_POINTER_MOTION event is merged into the event at
+ * the tail of the queue if that event is a @ref
+ * LIBINPUT_EVENT_POINTER_MOTION event from the same device. The
+ * accelerated and unaccelerated deltas of the merged event are the sum
+ * of the individual deltas, the timestamp is that of the most recent
+ * event.
+ *
+ * Events are only merged while they are waiting in the queue, a caller
+ * that keeps up with the event stream sees the same events regardless
+ * of this setting. Events are never merged across other events, the
+ * relative order of events is preserved.
+ *
+ * Coalescing is disabled by default. The number of merged events is
+ * available as @ref LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param enable Non-zero to enable coalescing, zero to disable it
+ *
+ * @see libinput_get_motion_coalescing
+ */
+void
+libinput_set_motion_coalescing(struct libinput *libinput,
+			       int enable);
+
+/**
+ * @ingroup base
+ *
+ * @param libinput A previously initialized libinput context
+ * @return Non-zero if pointer motion events are coalesced, zero otherwise
+ *
+ * @see libinput_set_motion_coalescing
+ */
+int
+libinput_get_motion_coalescing(struct libinput *libinput);
+
+/**
+ * @ingroup base
+ *
+ * The policy applied when an event is generated while the event queue
+ * is at its limit, see libinput_set_event_queue_limit().
+ */
+enum libinput_event_queue_overflow {
+	/**
+	 * Discard the new event.
+	 */
+	LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_NEWEST = 1,
+	/**
+	 * Discard the oldest queued motion event, i.e. an event of type
+	 * @ref LIBINPUT_EVENT_POINTER_MOTION, @ref
+	 * LIBINPUT_EVENT_POINTER_MOTION_ABSOLUTE, @ref
+	 * LIBINPUT_EVENT_TOUCH_MOTION or @ref
+	 * LIBINPUT_EVENT_TABLET_TOOL_AXIS. If no such event is queued, the
+	 * new event is discarded.
+	 */
+	LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_OLDEST_MOTION,
+	/**
+	 * Merge pointer motion events as described in
+	 * libinput_set_motion_coalescing(). If the new event cannot be
+	 * merged into the tail of the queue, the oldest pair of adjacent
+	 * mergeable events in the queue is merged instead. If no events
+	 * can be merged, the new event is discarded.
+	 */
+	LIBINPUT_EVENT_QUEUE_OVERFLOW_COALESCE,
+};
+
+/**
+ * @ingroup base
+ *
+ * Limit the number of events queued in this context. Once the limit is
+ * reached, the overflow policy decides which events are discarded or
+ * merged to make room for new events. The memory used by the queue
+ * is bounded by the limit.
+ *
+ * Events of type @ref LIBINPUT_EVENT_DEVICE_ADDED and @ref
+ * LIBINPUT_EVENT_DEVICE_REMOVED are never discarded, they are queued
+ * even if the queue is full.
+ *
+ * Events are only discarded while the queue is full. A caller that
+ * keeps up with libinput_get_event() never loses events. Discarding
+ * events may leave the caller with an inconsistent state, e.g. a
+ * button press without a matching release. The limit should be
+ * generous enough to only trigger when the caller is stuck.
+ *
+ * By default, the event queue is unlimited. The number of discarded
+ * events is available through libinput_get_dropped_event_count() and
+ * @ref LIBINPUT_STATISTIC_EVENTS_DROPPED.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param max_events The maximum number of queued events or 0 for an
+ * unlimited queue
+ * @param overflow The policy applied when the queue is full
+ * @return 0 on success or -1 if the overflow policy is invalid
+ */
+int
+libinput_set_event_queue_limit(struct libinput *libinput,
+			       size_t max_events,
+			       enum libinput_event_queue_overflow overflow);
+
+/**
+ * @ingroup base
+ *
+ * Return the number of events of the given type discarded because the
+ * event queue was full, see libinput_set_event_queue_limit(). Events
+ * merged into other events are not counted, see @ref
+ * LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param type The event type
+ * @return The number of discarded events of this type
+ */
+uint64_t
+libinput_get_dropped_event_count(struct libinput *libinput,
+				 enum libinput_event_type type);
+
+/**
+ * @ingroup base
+ *
+ * Enable or disable delivery of events of the given type. Events of a
+ * disabled type are not queued and, where possible, not created at all.
+ * A caller that ignores some event types should disable them to avoid
+ * the cost of creating, queueing and destroying these events.
+ *
+ * Disabling an event type only affects the events seen by the caller,
+ * libinput's internal handling of the underlying device events is
+ * unchanged. For example, keyboard events still trigger
+ * disable-while-typing on a touchpad even when @ref
+ * LIBINPUT_EVENT_KEYBOARD_KEY is disabled.
+ *
+ * Events already queued are not affected. All event types are enabled
+ * by default. @ref LIBINPUT_EVENT_DEVICE_ADDED and @ref
+ * LIBINPUT_EVENT_DEVICE_REMOVED cannot be disabled.
+ *
+ * @param libinput A previously initialized libinput context
+ * @param type The event type
+ * @param enabled Zero to disable the event type, non-zero to enable it
+ * @return 0 on success or -1 if the event type is invalid or cannot be
+ * disabled
+ *
+ * @see libinput_get_event_type_enabled
+ */
+int
+libinput_set_event_type_enabled(struct libinput *libinput,
+				enum libinput_event_type type,
+				int enabled);
+
+/**
+ * @ingroup base
+ *
+ * @param libinput A previously initialized libinput context
+ * @param type The event type
+ * @return Non-zero if events of this type are delivered to the caller,
+ * zero if the event type is disabled or invalid
+ *
+ * @see libinput_set_event_type_enabled
+ */
+int
+libinput_get_event_type_enabled(struct libinput *libinput,
+				enum libinput_event_type type);
+
 /**
  * @ingroup base
  *
@@ -3614,6 +4143,75 @@ libinput_device_get_size(struct libinput_device *device,
 			 double *width,
 			 double *height);
 
+/**
+ * @ingroup device
+ *
+ * The stages of an event's way through libinput for which latency can be
+ * tracked, see libinput_device_set_latency_tracking().
+ */
+enum libinput_latency_stage {
+	/**
+	 * From the kernel's timestamp of an evdev frame to libinput reading
+	 * the frame off the device.
+	 */
+	LIBINPUT_LATENCY_KERNEL_TO_READ = 1,
+	/**
+	 * From libinput reading the device to an event being added to the
+	 * event queue.
+	 */
+	LIBINPUT_LATENCY_READ_TO_QUEUED,
+	/**
+	 * From an event being added to the event queue to the caller
+	 * retrieving it with libinput_get_event(). Inside
+	 * libinput_dispatch_with_handler(), events not queued before the
+	 * call skip the queue and this is the time until the handler is
+	 * called.
+	 */
+	LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED,
+};
+
+/**
+ * @ingroup device
+ *
+ * Enable or disable latency tracking for this device. While enabled,
+ * libinput keeps a histogram of the time spent in each @ref
+ * libinput_latency_stage, see libinput_device_get_latency_histogram().
+ * Enabling latency tracking resets the histograms.
+ *
+ * Latency tracking is disabled by default, it adds a clock lookup to
+ * every event of this device.
+ *
+ * @param device A current input device
+ * @param enable Non-zero to enable latency tracking, zero to disable it
+ * @return 0 on success, or a negative errno on failure
+ */
+int
+libinput_device_set_latency_tracking(struct libinput_device *device,
+				     int enable);
+
+/**
+ * @ingroup device
+ *
+ * Copy the latency histogram for the given stage into the caller-provided
+ * array. Bucket 0 counts latencies below 2us, bucket n counts latencies
+ * of at least 2^n us and below 2^(n+1) us. The last bucket libinput keeps
+ * counts all latencies that exceed the range of the other buckets.
+ *
+ * @param device A current input device
+ * @param stage The stage to get the histogram for
+ * @param buckets An array with space for at least nbuckets values
+ * @param nbuckets The maximum number of buckets to copy
+ * @return The number of buckets copied, or 0 if latency tracking is
+ * disabled for this device or the stage is invalid
+ *
+ * @see libinput_device_set_latency_tracking
+ */
+size_t
+libinput_device_get_latency_histogram(struct libinput_device *device,
+				      enum libinput_latency_stage stage,
+				      uint64_t *buckets,
+				      size_t nbuckets);
+
 /**
  * @ingroup device
  *
@@ -3777,8 +4375,10 @@ libinput_device_group_get_user_data(struct libinput_device_group *group);
  *    - libinput_device_config_click_set_method()
  *    - libinput_device_config_scroll_set_method()
  *    - libinput_device_config_dwt_set_enabled()
+ *    - libinput_device_config_motion_smoothing_set_enabled()
  * - Touchscreens:
  *    - libinput_device_config_calibration_set_matrix()
+ *    - libinput_device_config_prediction_set_lookahead()
  * - Pointer devices (mice, trackballs, touchpads):
  *    - libinput_device_config_accel_set_speed()
  *    - libinput_device_config_accel_set_profile()
@@ -3786,6 +4386,7 @@ libinput_device_group_get_user_data(struct libinput_device_group *group);
  *    - libinput_device_config_left_handed_set()
  *    - libinput_device_config_middle_emulation_set_enabled()
  *    - libinput_device_config_rotation_set_angle()
+ *    - libinput_device_config_prediction_set_lookahead()
  * - All devices:
  *    - libinput_device_config_send_events_set_mode()
  */
@@ -5258,6 +5859,173 @@ libinput_device_config_rotation_get_angle(struct libinput_device *device);
 unsigned int
 libinput_device_config_rotation_get_default_angle(struct libinput_device *device);
 
+/**
+ * @ingroup config
+ *
+ * Possible states for the velocity-adaptive motion smoothing.
+ */
+enum libinput_config_motion_smoothing_state {
+	LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED,
+	LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED,
+};
+
+/**
+ * @ingroup config
+ *
+ * Check if this device supports velocity-adaptive motion smoothing. When
+ * enabled, the device averages its most recent positions over a window
+ * that is wide for slow movements, reducing jitter during precise
+ * pointing, and narrow for fast movements, so fast swipes are not
+ * delayed. This feature is usually available on touchpads.
+ *
+ * @param device The device to configure
+ * @return 0 if this device does not support motion smoothing, or 1
+ * otherwise.
+ *
+ * @see libinput_device_config_motion_smoothing_set_enabled
+ * @see libinput_device_config_motion_smoothing_get_enabled
+ * @see libinput_device_config_motion_smoothing_get_default_enabled
+ */
+int
+libinput_device_config_motion_smoothing_is_available(struct libinput_device *device);
+
+/**
+ * @ingroup config
+ *
+ * Enable or disable velocity-adaptive motion smoothing on this device.
+ *
+ * @note Enabling or disabling motion smoothing may not take effect
+ * immediately, a touch in progress keeps its previous setting until it
+ * ends.
+ *
+ * @param device The device to configure
+ * @param enable @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED to disable
+ * motion smoothing, @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED to enable
+ *
+ * @return A config status code. Disabling motion smoothing on a device
+ * that does not support the feature always succeeds.
+ *
+ * @see libinput_device_config_motion_smoothing_is_available
+ * @see libinput_device_config_motion_smoothing_get_enabled
+ * @see libinput_device_config_motion_smoothing_get_default_enabled
+ */
+enum libinput_config_status
+libinput_device_config_motion_smoothing_set_enabled(struct libinput_device *device,
+						    enum libinput_config_motion_smoothing_state enable);
+
+/**
+ * @ingroup config
+ *
+ * Check if velocity-adaptive motion smoothing is currently enabled on this
+ * device. If the device does not support motion smoothing, this function
+ * returns @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED.
+ *
+ * @param device The device to configure
+ * @return @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED if disabled,
+ * @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED if enabled.
+ *
+ * @see libinput_device_config_motion_smoothing_is_available
+ * @see libinput_device_config_motion_smoothing_set_enabled
+ * @see libinput_device_config_motion_smoothing_get_default_enabled
+ */
+enum libinput_config_motion_smoothing_state
+libinput_device_config_motion_smoothing_get_enabled(struct libinput_device *device);
+
+/**
+ * @ingroup config
+ *
+ * Check if velocity-adaptive motion smoothing is enabled on this device
+ * by default. If the device does not support motion smoothing, this
+ * function returns @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED.
+ *
+ * @param device The device to configure
+ * @return @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED if disabled,
+ * @ref LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED if enabled.
+ *
+ * @see libinput_device_config_motion_smoothing_is_available
+ * @see libinput_device_config_motion_smoothing_set_enabled
+ * @see libinput_device_config_motion_smoothing_get_enabled
+ */
+enum libinput_config_motion_smoothing_state
+libinput_device_config_motion_smoothing_get_default_enabled(struct libinput_device *device);
+
+/**
+ * @ingroup config
+ *
+ * Check if this device can predict its motion. Devices that support
+ * prediction extrapolate the recent motion of each touch or of the pointer
+ * by a configurable look-ahead, so a caller can draw where the finger will
+ * be rather than where it was when the kernel timestamped the event, hiding
+ * part of the latency between the device and the display.
+ *
+ * @param device The device to configure
+ * @return Non-zero if the device supports motion prediction, zero
+ * otherwise.
+ *
+ * @see libinput_device_config_prediction_set_lookahead
+ * @see libinput_device_config_prediction_get_lookahead
+ * @see libinput_device_config_prediction_get_default_lookahead
+ * @see libinput_event_touch_get_predicted_x
+ * @see libinput_event_pointer_get_predicted_dx_unaccelerated
+ */
+int
+libinput_device_config_prediction_is_available(struct libinput_device *device);
+
+/**
+ * @ingroup config
+ *
+ * Set the look-ahead of the motion prediction in ms. A look-ahead of 0
+ * disables prediction, the predicted touch coordinates are then the
+ * current coordinates and the predicted pointer motion is 0. Larger
+ * look-aheads hide more latency but overshoot more on sudden changes of
+ * direction, a look-ahead of more than 50ms is rejected.
+ *
+ * @param device The device to configure
+ * @param lookahead The look-ahead in ms
+ *
+ * @return A config status code. Setting a look-ahead of 0 on a device that
+ * does not support prediction always succeeds.
+ *
+ * @see libinput_device_config_prediction_is_available
+ * @see libinput_device_config_prediction_get_lookahead
+ * @see libinput_device_config_prediction_get_default_lookahead
+ */
+enum libinput_config_status
+libinput_device_config_prediction_set_lookahead(struct libinput_device *device,
+						unsigned int lookahead);
+
+/**
+ * @ingroup config
+ *
+ * Get the current look-ahead of the motion prediction in ms. If the device
+ * does not support prediction, this function returns 0.
+ *
+ * @param device The device to configure
+ * @return The look-ahead in ms
+ *
+ * @see libinput_device_config_prediction_is_available
+ * @see libinput_device_config_prediction_set_lookahead
+ * @see libinput_device_config_prediction_get_default_lookahead
+ */
+unsigned int
+libinput_device_config_prediction_get_lookahead(struct libinput_device *device);
+
+/**
+ * @ingroup config
+ *
+ * Get the default look-ahead of the motion prediction in ms. If the device
+ * does not support prediction, this function returns 0.
+ *
+ * @param device The device to configure
+ * @return The default look-ahead in ms
+ *
+ * @see libinput_device_config_prediction_is_available
+ * @see libinput_device_config_prediction_set_lookahead
+ * @see libinput_device_config_prediction_get_lookahead
+ */
+unsigned int
+libinput_device_config_prediction_get_default_lookahead(struct libinput_device *device);
+
 #ifdef __cplusplus
 }
 #endif
@@ -339,6 +339,9 @@ libinput_path_add_device(struct libinput *libinput,
 		return NULL;
 	}
 
+	if (libinput_called_from_handler(libinput, __func__))
+		return NULL;
+
 	udev_device = udev_device_from_devnode(libinput, udev, path);
 	if (!udev_device) {
 		log_bug_client(libinput, "Invalid path %s\n", path);
@@ -369,6 +372,9 @@ libinput_path_remove_device(struct libinput_device *device)
 		return;
 	}
 
+	if (libinput_called_from_handler(libinput, __func__))
+		return;
+
 	list_for_each(dev, &input->path_list, link) {
 		if (dev->udev_device == evdev->udev_device) {
 			list_remove(&dev->link);
@@ -33,6 +33,110 @@
 #include "libinput-private.h"
 #include "timer.h"
 
+/* The armed timers are kept in a binary min-heap ordered by expiry
+ * time, the earliest timer is always heap[0] */
+
+static inline bool
+timer_is_armed(struct libinput_timer *timer)
+{
+	return timer->expire != 0;
+}
+
+/* Expired but timer_func not yet called */
+static inline bool
+timer_is_pending(struct libinput_timer *timer)
+{
+	return timer->link.next != NULL;
+}
+
+static inline void
+timer_heap_place(struct libinput *libinput,
+		 struct libinput_timer *timer,
+		 size_t index)
+{
+	libinput->timer.heap[index] = timer;
+	timer->heap_index = index;
+}
+
+static void
+timer_heap_sift_up(struct libinput *libinput, size_t index)
+{
+	struct libinput_timer **heap = libinput->timer.heap;
+	struct libinput_timer *timer = heap[index];
+	size_t parent;
+
+	while (index > 0) {
+		parent = (index - 1) / 2;
+		if (heap[parent]->expire <= timer->expire)
+			break;
+
+		timer_heap_place(libinput, heap[parent], index);
+		index = parent;
+	}
+
+	timer_heap_place(libinput, timer, index);
+}
+
+static void
+timer_heap_sift_down(struct libinput *libinput, size_t index)
+{
+	struct libinput_timer **heap = libinput->timer.heap;
+	struct libinput_timer *timer = heap[index];
+	size_t count = libinput->timer.heap_count;
+	size_t child;
+
+	while ((child = 2 * index + 1) < count) {
+		if (child + 1 < count &&
+		    heap[child + 1]->expire < heap[child]->expire)
+			child++;
+
+		if (timer->expire <= heap[child]->expire)
+			break;
+
+		timer_heap_place(libinput, heap[child], index);
+		index = child;
+	}
+
+	timer_heap_place(libinput, timer, index);
+}
+
+static bool
+timer_heap_insert(struct libinput *libinput, struct libinput_timer *timer)
+{
+	struct libinput_timer **heap;
+	size_t size = libinput->timer.heap_size;
+
+	if (libinput->timer.heap_count == size) {
+		size = size ? size * 2 : 16;
+		heap = realloc(libinput->timer.heap, size * sizeof *heap);
+		if (!heap)
+			return false;
+
+		libinput->timer.heap = heap;
+		libinput->timer.heap_size = size;
+	}
+
+	timer_heap_place(libinput, timer, libinput->timer.heap_count++);
+	timer_heap_sift_up(libinput, timer->heap_index);
+
+	return true;
+}
+
+static void
+timer_heap_remove(struct libinput *libinput, struct libinput_timer *timer)
+{
+	struct libinput_timer *last;
+	size_t index = timer->heap_index;
+
+	last = libinput->timer.heap[--libinput->timer.heap_count];
+	if (last == timer)
+		return;
+
+	timer_heap_place(libinput, last, index);
+	timer_heap_sift_down(libinput, index);
+	timer_heap_sift_up(libinput, last->heap_index);
+}
+
 void
 libinput_timer_init(struct libinput_timer *timer, struct libinput *libinput,
 		    void (*timer_func)(uint64_t now, void *timer_func_data),
@@ -41,22 +145,30 @@ libinput_timer_init(struct libinput_timer *timer, struct libinput *libinput,
 	timer->libinput = libinput;
 	timer->timer_func = timer_func;
 	timer->timer_func_data = timer_func_data;
+	timer->expire = 0;
+	timer->link.prev = NULL;
+	timer->link.next = NULL;
 }
 
 static void
 libinput_timer_arm_timer_fd(struct libinput *libinput)
 {
 	int r;
-	struct libinput_timer *timer;
 	struct itimerspec its = { { 0, 0 }, { 0, 0 } };
-	uint64_t earliest_expire = UINT64_MAX;
+	uint64_t earliest_expire = 0;
 
-	list_for_each(timer, &libinput->timer.list, link) {
-		if (timer->expire < earliest_expire)
-			earliest_expire = timer->expire;
-	}
+	/* libinput_timer_flush() re-arms once the dispatch is done */
+	if (libinput->timer.deferred)
+		return;
+
+	if (libinput->timer.heap_count > 0)
+		earliest_expire = libinput->timer.heap[0]->expire;
+
+	/* Only talk to the kernel when the earliest deadline changes */
+	if (earliest_expire == libinput->timer.next_expire)
+		return;
 
-	if (earliest_expire != UINT64_MAX) {
+	if (earliest_expire != 0) {
 		its.it_value.tv_sec = earliest_expire / ms2us(1000);
 		its.it_value.tv_nsec = (earliest_expire % ms2us(1000)) * 1000;
 	}
@@ -64,11 +176,16 @@ libinput_timer_arm_timer_fd(struct libinput *libinput)
 	r = timerfd_settime(libinput->timer.fd, TFD_TIMER_ABSTIME, &its, NULL);
 	if (r)
 		log_error(libinput, "timerfd_settime error: %s\n", strerror(errno));
+	else
+		libinput->timer.next_expire = earliest_expire;
 }
 
 void
 libinput_timer_set(struct libinput_timer *timer, uint64_t expire)
 {
+	struct libinput *libinput = timer->libinput;
+	uint64_t old_expire = timer->expire;
+
 #ifndef NDEBUG
 	uint64_t now = libinput_now(timer->libinput);
 	if (expire < now)
@@ -84,29 +201,63 @@ libinput_timer_set(struct libinput_timer *timer, uint64_t expire)
 
 	assert(expire);
 
-	if (!timer->expire)
-		list_insert(&timer->libinput->timer.list, &timer->link);
+	/* Re-arming an expired timer before its timer_func ran replaces
+	 * that expiry */
+	if (timer_is_pending(timer))
+		list_remove(&timer->link);
 
 	timer->expire = expire;
-	libinput_timer_arm_timer_fd(timer->libinput);
+
+	if (!old_expire) {
+		if (!timer_heap_insert(libinput, timer)) {
+			log_error(libinput,
+				  "Failed to grow the timer heap, "
+				  "timer discarded\n");
+			timer->expire = 0;
+			return;
+		}
+	} else if (expire < old_expire) {
+		timer_heap_sift_up(libinput, timer->heap_index);
+	} else if (expire > old_expire) {
+		timer_heap_sift_down(libinput, timer->heap_index);
+	}
+
+	libinput_timer_arm_timer_fd(libinput);
 }
 
 void
 libinput_timer_cancel(struct libinput_timer *timer)
 {
-	if (!timer->expire)
+	if (timer_is_pending(timer))
+		list_remove(&timer->link);
+
+	if (!timer_is_armed(timer))
 		return;
 
+	timer_heap_remove(timer->libinput, timer);
 	timer->expire = 0;
-	list_remove(&timer->link);
 	libinput_timer_arm_timer_fd(timer->libinput);
 }
 
+void
+libinput_timer_defer(struct libinput *libinput)
+{
+	libinput->timer.deferred = true;
+}
+
+void
+libinput_timer_flush(struct libinput *libinput)
+{
+	libinput->timer.deferred = false;
+	libinput_timer_arm_timer_fd(libinput);
+}
+
 static void
 libinput_timer_handler(void *data)
 {
 	struct libinput *libinput = data;
-	struct libinput_timer *timer, *tmp;
+	struct libinput_timer *timer;
+	struct list expired;
 	uint64_t now;
 	uint64_t discard;
 	int r;
@@ -122,13 +273,27 @@ libinput_timer_handler(void *data)
 	if (now == 0)
 		return;
 
-	list_for_each_safe(timer, tmp, &libinput->timer.list, link) {
-		if (timer->expire <= now) {
-			/* Clear the timer before calling timer_func,
-			   as timer_func may re-arm it */
-			libinput_timer_cancel(timer);
-			timer->timer_func(now, timer->timer_func_data);
-		}
+	/* Collect all expired timers first so that a timer re-armed by
+	 * a timer_func does not fire again in this pass. Timers are
+	 * cleared before calling timer_func, as timer_func may re-arm
+	 * them. */
+	list_init(&expired);
+	while (libinput->timer.heap_count > 0) {
+		timer = libinput->timer.heap[0];
+		if (timer->expire > now)
+			break;
+
+		timer_heap_remove(libinput, timer);
+		timer->expire = 0;
+		list_insert(expired.prev, &timer->link);
+	}
+
+	libinput_timer_arm_timer_fd(libinput);
+
+	while (!list_empty(&expired)) {
+		timer = container_of(expired.next, timer, link);
+		list_remove(&timer->link);
+		timer->timer_func(now, timer->timer_func_data);
 	}
 }
 
@@ -140,7 +305,11 @@ libinput_timer_subsys_init(struct libinput *libinput)
 	if (libinput->timer.fd < 0)
 		return -1;
 
-	list_init(&libinput->timer.list);
+	libinput->timer.heap = NULL;
+	libinput->timer.heap_count = 0;
+	libinput->timer.heap_size = 0;
+	libinput->timer.next_expire = 0;
+	libinput->timer.deferred = false;
 
 	libinput->timer.source = libinput_add_fd(libinput,
 						 libinput->timer.fd,
@@ -158,8 +327,9 @@ void
 libinput_timer_subsys_destroy(struct libinput *libinput)
 {
 	/* All timer users should have destroyed their timers now */
-	assert(list_empty(&libinput->timer.list));
+	assert(libinput->timer.heap_count == 0);
 
+	free(libinput->timer.heap);
 	libinput_remove_source(libinput, libinput->timer.source);
 	close(libinput->timer.fd);
 }
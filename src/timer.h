@@ -24,6 +24,7 @@
 #ifndef TIMER_H
 #define TIMER_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include "libinput-util.h"
@@ -32,7 +33,8 @@ struct libinput;
 
 struct libinput_timer {
 	struct libinput *libinput;
-	struct list link;
+	size_t heap_index; /* only valid while the timer is armed */
+	struct list link; /* expired, waiting for timer_func */
 	uint64_t expire; /* in absolute us CLOCK_MONOTONIC */
 	void (*timer_func)(uint64_t now, void *timer_func_data);
 	void *timer_func_data;
@@ -50,6 +52,14 @@ libinput_timer_set(struct libinput_timer *timer, uint64_t expire);
 void
 libinput_timer_cancel(struct libinput_timer *timer);
 
+/* Stop reprogramming the timerfd on every timer change until
+ * libinput_timer_flush(), which programs the earliest deadline once */
+void
+libinput_timer_defer(struct libinput *libinput);
+
+void
+libinput_timer_flush(struct libinput *libinput);
+
 int
 libinput_timer_subsys_init(struct libinput *libinput);
 
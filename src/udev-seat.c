@@ -381,6 +381,9 @@ libinput_udev_assign_seat(struct libinput *libinput,
 		return -1;
 	}
 
+	if (libinput_called_from_handler(libinput, __func__))
+		return -1;
+
 	if (input->seat_id != NULL)
 		return -1;
 
@@ -411,6 +411,9 @@ extern struct litest_test_device litest_mouse_wheel_tilt_device;
 extern struct litest_test_device litest_lid_switch_device;
 extern struct litest_test_device litest_lid_switch_surface3_device;
 extern struct litest_test_device litest_appletouch_device;
+extern struct litest_test_device litest_touchscreen_read_frames_device;
+extern struct litest_test_device litest_touchpad_read_frames_device;
+extern struct litest_test_device litest_lid_switch_read_frames_device;
 
 struct litest_test_device* devices[] = {
 	&litest_synaptics_clickpad_device,
@@ -476,6 +479,9 @@ struct litest_test_device* devices[] = {
 	&litest_lid_switch_device,
 	&litest_lid_switch_surface3_device,
 	&litest_appletouch_device,
+	&litest_touchscreen_read_frames_device,
+	&litest_touchpad_read_frames_device,
+	&litest_lid_switch_read_frames_device,
 	NULL,
 };
 
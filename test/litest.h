@@ -232,6 +232,9 @@ enum litest_device_type {
 	LITEST_LID_SWITCH,
 	LITEST_LID_SWITCH_SURFACE3,
 	LITEST_APPLETOUCH,
+	LITEST_TOUCHSCREEN_READ_FRAMES,
+	LITEST_TOUCHPAD_READ_FRAMES,
+	LITEST_LID_SWITCH_READ_FRAMES,
 };
 
 enum litest_device_feature {
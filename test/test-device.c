@@ -1583,6 +1583,317 @@ START_TEST(device_seat_phys_name)
 }
 END_TEST
 
+static uint64_t
+latency_sample_count(struct libinput_device *device,
+		     enum libinput_latency_stage stage)
+{
+	uint64_t buckets[64];
+	uint64_t total = 0;
+	size_t i, nbuckets;
+
+	nbuckets = libinput_device_get_latency_histogram(device,
+							 stage,
+							 buckets,
+							 ARRAY_LENGTH(buckets));
+	for (i = 0; i < nbuckets; i++)
+		total += buckets[i];
+
+	return total;
+}
+
+START_TEST(device_latency_tracking)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+	uint64_t buckets[4];
+
+	litest_drain_events(li);
+
+	/* disabled by default */
+	ck_assert_int_eq(libinput_device_get_latency_histogram(device,
+				LIBINPUT_LATENCY_KERNEL_TO_READ,
+				buckets,
+				ARRAY_LENGTH(buckets)),
+			 0);
+
+	ck_assert_int_eq(libinput_device_set_latency_tracking(device, 1), 0);
+	ck_assert_int_eq(libinput_device_get_latency_histogram(device,
+				LIBINPUT_LATENCY_KERNEL_TO_READ,
+				buckets,
+				ARRAY_LENGTH(buckets)),
+			 ARRAY_LENGTH(buckets));
+
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_A, false);
+	litest_drain_events(li);
+
+	ck_assert_int_eq(latency_sample_count(device,
+				LIBINPUT_LATENCY_KERNEL_TO_READ),
+			 2);
+	ck_assert_int_eq(latency_sample_count(device,
+				LIBINPUT_LATENCY_READ_TO_QUEUED),
+			 2);
+	ck_assert_int_eq(latency_sample_count(device,
+				LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED),
+			 2);
+
+	/* re-enabling resets the histograms */
+	ck_assert_int_eq(libinput_device_set_latency_tracking(device, 1), 0);
+	ck_assert_int_eq(latency_sample_count(device,
+				LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED),
+			 0);
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_device_get_latency_histogram(device,
+							       0,
+							       buckets,
+							       1),
+			 0);
+	litest_restore_log_handler(li);
+
+	ck_assert_int_eq(libinput_device_set_latency_tracking(device, 0), 0);
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_A, false);
+	litest_drain_events(li);
+	ck_assert_int_eq(latency_sample_count(device,
+				LIBINPUT_LATENCY_KERNEL_TO_READ),
+			 0);
+}
+END_TEST
+
+START_TEST(device_read_frames_udev_property)
+{
+	struct litest_device *dev = litest_current_device();
+	struct udev_device *udev_device;
+	const char *prop;
+
+	/* make sure the tests below don't silently run on libevdev */
+	udev_device = libinput_device_get_udev_device(dev->libinput_device);
+	prop = udev_device_get_property_value(udev_device,
+					      "LIBINPUT_ATTR_READ_FRAMES");
+	ck_assert_notnull(prop);
+	ck_assert_str_eq(prop, "1");
+	udev_device_unref(udev_device);
+}
+END_TEST
+
+START_TEST(device_read_frames_carry_over)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+	double x, y, last_x = 0;
+	int nmotion = 0;
+
+	litest_touch_down(dev, 0, 10, 10);
+	litest_drain_events(li);
+
+	/* 99 frames of three events each don't fit into the frame buffer,
+	 * the read splits one of them. Processed in two halves it would
+	 * move only one axis */
+	litest_touch_move_to(dev, 0, 10, 10, 80, 80, 100, 0);
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) ==
+		    LIBINPUT_EVENT_TOUCH_FRAME) {
+			libinput_event_destroy(event);
+			continue;
+		}
+
+		tev = litest_is_touch_event(event,
+					    LIBINPUT_EVENT_TOUCH_MOTION);
+		x = libinput_event_touch_get_x_transformed(tev, 100);
+		y = libinput_event_touch_get_y_transformed(tev, 100);
+		ck_assert_double_eq(x, y);
+		ck_assert_double_gt(x, last_x);
+		last_x = x;
+		nmotion++;
+
+		libinput_event_destroy(event);
+	}
+
+	ck_assert_int_eq(nmotion, 99);
+}
+END_TEST
+
+START_TEST(device_read_frames_syn_dropped)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+	enum libinput_event_type type;
+	double x = 0, y = 0;
+
+	litest_touch_down(dev, 0, 10, 10);
+	litest_drain_events(li);
+
+	/* ~1500 events overflow the kernel's client buffer, the device
+	 * state is synced after the SYN_DROPPED */
+	litest_touch_move_to(dev, 0, 10, 10, 80, 80, 500, 0);
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		type = libinput_event_get_type(event);
+		ck_assert(type == LIBINPUT_EVENT_TOUCH_MOTION ||
+			  type == LIBINPUT_EVENT_TOUCH_FRAME);
+		if (type == LIBINPUT_EVENT_TOUCH_MOTION) {
+			tev = libinput_event_get_touch_event(event);
+			x = libinput_event_touch_get_x_transformed(tev, 100);
+			y = libinput_event_touch_get_y_transformed(tev, 100);
+		}
+		libinput_event_destroy(event);
+	}
+
+	ck_assert(fabs(x - 80) < 1);
+	ck_assert(fabs(y - 80) < 1);
+
+	/* the device is still usable */
+	litest_touch_up(dev, 0);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_UP);
+	libinput_event_destroy(event);
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, 50, 50);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_DOWN);
+	x = libinput_event_touch_get_x_transformed(tev, 100);
+	ck_assert(fabs(x - 50) < 1);
+	libinput_event_destroy(event);
+	litest_drain_events(li);
+}
+END_TEST
+
+START_TEST(device_read_frames_incomplete)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+
+	litest_touch_down(dev, 0, 10, 10);
+	litest_drain_events(li);
+
+	/* The kernel doesn't hand out a frame before its SYN_REPORT, the
+	 * read fails with EAGAIN and the device must stay around */
+	litest_event(dev, EV_ABS, ABS_MT_POSITION_X, 750);
+	litest_event(dev, EV_ABS, ABS_MT_POSITION_Y, 750);
+	libinput_dispatch(li);
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	/* x and y range from 0 to 1500 */
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_MOTION);
+	ck_assert_double_eq(libinput_event_touch_get_x_transformed(tev, 1501),
+			    750);
+	ck_assert_double_eq(libinput_event_touch_get_y_transformed(tev, 1501),
+			    750);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_FRAME);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(device_read_frames_touchpad_split)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	double dx, dy;
+	int nmotion = 0;
+
+	litest_touch_down(dev, 0, 20, 50);
+	litest_drain_events(li);
+
+	/* 149 frames of three events each, more than the frame buffer
+	 * holds but less than the kernel's client buffer */
+	litest_touch_move_to(dev, 0, 20, 50, 80, 50, 150, 0);
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		ptrev = litest_is_motion_event(event);
+		dx = libinput_event_pointer_get_dx_unaccelerated(ptrev);
+		dy = libinput_event_pointer_get_dy_unaccelerated(ptrev);
+		ck_assert_double_gt(dx, 0);
+		ck_assert_double_eq(dy, 0);
+		nmotion++;
+		libinput_event_destroy(event);
+	}
+
+	ck_assert_int_gt(nmotion, 0);
+
+	litest_touch_up(dev, 0);
+	litest_drain_events(li);
+}
+END_TEST
+
+START_TEST(device_read_frames_no_hook)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	enum libinput_switch_state state;
+	int i;
+
+	litest_drain_events(li);
+
+	/* the lid dispatch has no process_frame hook and gets the frames
+	 * one event at a time */
+	for (i = 0; i < 10; i++) {
+		state = (i % 2) ? LIBINPUT_SWITCH_STATE_OFF :
+				  LIBINPUT_SWITCH_STATE_ON;
+		litest_lid_action(dev, state);
+	}
+	libinput_dispatch(li);
+
+	for (i = 0; i < 10; i++) {
+		state = (i % 2) ? LIBINPUT_SWITCH_STATE_OFF :
+				  LIBINPUT_SWITCH_STATE_ON;
+		event = libinput_get_event(li);
+		litest_is_switch_event(event, LIBINPUT_SWITCH_LID, state);
+		libinput_event_destroy(event);
+	}
+
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(device_read_frames_latency)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	struct libinput *li = dev->libinput;
+
+	litest_touch_down(dev, 0, 10, 10);
+	litest_drain_events(li);
+
+	ck_assert_int_eq(libinput_device_set_latency_tracking(device, 1), 0);
+
+	/* one of the 99 frames is split across two reads, it must only
+	 * be counted once */
+	litest_touch_move_to(dev, 0, 10, 10, 80, 80, 100, 0);
+	litest_drain_events(li);
+
+	ck_assert_int_eq(latency_sample_count(device,
+				LIBINPUT_LATENCY_KERNEL_TO_READ),
+			 99);
+}
+END_TEST
+
 void
 litest_setup_tests_device(void)
 {
@@ -1662,4 +1973,16 @@ litest_setup_tests_device(void)
 	litest_add("device:output", device_no_output, LITEST_KEYS, LITEST_ANY);
 
 	litest_add("device:seat", device_seat_phys_name, LITEST_ANY, LITEST_ANY);
+
+	litest_add_for_device("device:latency", device_latency_tracking, LITEST_KEYBOARD);
+
+	litest_add_for_device("device:read frames", device_read_frames_udev_property, LITEST_TOUCHSCREEN_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_udev_property, LITEST_TOUCHPAD_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_udev_property, LITEST_LID_SWITCH_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_carry_over, LITEST_TOUCHSCREEN_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_syn_dropped, LITEST_TOUCHSCREEN_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_incomplete, LITEST_TOUCHSCREEN_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_touchpad_split, LITEST_TOUCHPAD_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_no_hook, LITEST_LID_SWITCH_READ_FRAMES);
+	litest_add_for_device("device:read frames", device_read_frames_latency, LITEST_TOUCHSCREEN_READ_FRAMES);
 }
@@ -24,6 +24,7 @@
 #include "config.h"
 
 #include <check.h>
+#include <poll.h>
 #include <stdio.h>
 
 #include "libinput-util.h"
@@ -422,6 +423,121 @@ START_TEST(keyboard_no_scroll)
 }
 END_TEST
 
+START_TEST(keyboard_dispatched_before_pointer)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_device *mouse;
+	struct libinput_event *event;
+	int i;
+
+	mouse = litest_add_device(li, LITEST_MOUSE);
+	litest_drain_events(li);
+
+	/* The mouse events come first, but keyboards are dispatched
+	   ahead of pointer devices */
+	for (i = 0; i < 10; i++) {
+		litest_event(mouse, EV_REL, REL_X, 1);
+		litest_event(mouse, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_event(dev, EV_KEY, KEY_A, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event, KEY_A, LIBINPUT_KEY_STATE_PRESSED);
+	libinput_event_destroy(event);
+
+	for (i = 0; i < 10; i++) {
+		event = libinput_get_event(li);
+		litest_is_motion_event(event);
+		libinput_event_destroy(event);
+	}
+	litest_assert_empty_queue(li);
+
+	litest_event(dev, EV_KEY, KEY_A, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_drain_events(li);
+
+	litest_delete_device(mouse);
+}
+END_TEST
+
+START_TEST(keyboard_not_starved_by_flood)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct litest_device *touch;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+	struct pollfd fds;
+	/* A big kernel buffer so the flood isn't dropped */
+	struct input_absinfo abs[] = {
+		{ ABS_MT_SLOT, 0, 31, 0, 0, 0 },
+		{ .value = -1 },
+	};
+	const int nframes = 700;
+	int i, nmotion = 0;
+	double x = 0;
+
+	touch = litest_add_device_with_overrides(li,
+						 LITEST_GENERIC_MULTITOUCH_SCREEN,
+						 NULL, NULL, abs, NULL);
+	litest_touch_down(touch, 0, 5, 5);
+	litest_drain_events(li);
+
+	/* 1400 events, more than one libinput_dispatch() processes from
+	 * one device: 64 events per round, 16 rounds */
+	for (i = 0; i < nframes; i++) {
+		litest_event(touch, EV_ABS, ABS_MT_POSITION_X, 100 + i);
+		litest_event(touch, EV_SYN, SYN_REPORT, 0);
+	}
+	litest_event(dev, EV_KEY, KEY_A, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event, KEY_A, LIBINPUT_KEY_STATE_PRESSED);
+	libinput_event_destroy(event);
+
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) ==
+		    LIBINPUT_EVENT_TOUCH_MOTION)
+			nmotion++;
+		libinput_event_destroy(event);
+	}
+	ck_assert_int_gt(nmotion, 0);
+	ck_assert_int_lt(nmotion, nframes);
+
+	/* the rest is still there and the fd says so */
+	fds.fd = libinput_get_fd(li);
+	fds.events = POLLIN;
+	fds.revents = 0;
+	ck_assert_int_eq(poll(&fds, 1, 0), 1);
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) ==
+		    LIBINPUT_EVENT_TOUCH_MOTION) {
+			tev = libinput_event_get_touch_event(event);
+			/* x ranges from 0 to 1500 */
+			x = libinput_event_touch_get_x_transformed(tev, 1501);
+			nmotion++;
+		}
+		libinput_event_destroy(event);
+	}
+	ck_assert_int_eq(nmotion, nframes);
+	ck_assert_double_eq(x, 100 + nframes - 1);
+
+	litest_event(dev, EV_KEY, KEY_A, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_touch_up(touch, 0);
+	litest_drain_events(li);
+
+	litest_delete_device(touch);
+}
+END_TEST
+
 void
 litest_setup_tests_keyboard(void)
 {
@@ -437,4 +553,7 @@ litest_setup_tests_keyboard(void)
 	litest_add("keyboard:leds", keyboard_leds, LITEST_ANY, LITEST_ANY);
 
 	litest_add("keyboard:scroll", keyboard_no_scroll, LITEST_KEYS, LITEST_WHEEL);
+
+	litest_add_for_device("keyboard:dispatch", keyboard_dispatched_before_pointer, LITEST_KEYBOARD);
+	litest_add_for_device("keyboard:dispatch", keyboard_not_starved_by_flood, LITEST_KEYBOARD);
 }
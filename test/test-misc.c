@@ -535,6 +535,685 @@ START_TEST(event_conversion_switch)
 }
 END_TEST
 
+START_TEST(event_pool_statistics)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	uint64_t hits, misses;
+	int i;
+
+	litest_drain_events(li);
+
+	/* warm up the keyboard event pool */
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_A, false);
+	litest_drain_events(li);
+
+	hits = libinput_get_statistic(li, LIBINPUT_STATISTIC_EVENT_POOL_HITS);
+	misses = libinput_get_statistic(li,
+					LIBINPUT_STATISTIC_EVENT_POOL_MISSES);
+	ck_assert_int_gt(misses, 0);
+	ck_assert_int_ge(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_HIGH_WATER_MARK),
+			 2);
+
+	/* destroyed events are recycled, the pool doesn't grow */
+	for (i = 0; i < 10; i++) {
+		litest_keyboard_key(dev, KEY_A, true);
+		litest_keyboard_key(dev, KEY_A, false);
+		litest_drain_events(li);
+	}
+
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_MISSES),
+			 misses);
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_HITS),
+			 hits + 20);
+
+	/* queue more events than fit into one slab */
+	for (i = 0; i < 50; i++) {
+		litest_keyboard_key(dev, KEY_A, true);
+		litest_keyboard_key(dev, KEY_A, false);
+		libinput_dispatch(li);
+	}
+
+	ck_assert_int_gt(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_MISSES),
+			 misses);
+	ck_assert_int_ge(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_HIGH_WATER_MARK),
+			 100);
+
+	litest_drain_events(li);
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_get_statistic(li, 0), 0);
+	litest_restore_log_handler(li);
+}
+END_TEST
+
+static void
+queue_motion(struct litest_device *dev, int dx)
+{
+	litest_event(dev, EV_REL, REL_X, dx);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+}
+
+static void
+assert_motion(struct libinput *li, int dx)
+{
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	litest_assert_int_eq(
+		libinput_event_pointer_get_dx_unaccelerated(ptrev), dx);
+	libinput_event_destroy(event);
+}
+
+static void
+assert_button(struct libinput *li, enum libinput_button_state state)
+{
+	struct libinput_event *event;
+
+	event = libinput_get_event(li);
+	litest_is_button_event(event, BTN_LEFT, state);
+	libinput_event_destroy(event);
+}
+
+START_TEST(event_queue_limit_drop_newest)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	int i;
+
+	litest_drain_events(li);
+
+	ck_assert_int_eq(libinput_set_event_queue_limit(li,
+				4,
+				LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_NEWEST),
+			 0);
+
+	for (i = 1; i <= 6; i++)
+		queue_motion(dev, i);
+	libinput_dispatch(li);
+
+	for (i = 1; i <= 4; i++)
+		assert_motion(li, i);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_POINTER_MOTION),
+			 2);
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_POINTER_BUTTON),
+			 0);
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENTS_DROPPED),
+			 2);
+
+	/* unlimited again */
+	libinput_set_event_queue_limit(li,
+				       0,
+				       LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_NEWEST);
+	for (i = 1; i <= 6; i++)
+		queue_motion(dev, i);
+	libinput_dispatch(li);
+
+	for (i = 1; i <= 6; i++)
+		assert_motion(li, i);
+	litest_assert_empty_queue(li);
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_set_event_queue_limit(li, 4, 0), -1);
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_NONE),
+			 0);
+	ck_assert_int_eq(libinput_get_dropped_event_count(li, 1099), 0);
+	litest_restore_log_handler(li);
+}
+END_TEST
+
+START_TEST(event_queue_limit_device_notify)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_device *device;
+	struct libinput_event *event;
+	int i;
+
+	litest_drain_events(li);
+
+	libinput_set_event_queue_limit(li,
+				       4,
+				       LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_NEWEST);
+
+	for (i = 1; i <= 6; i++)
+		queue_motion(dev, i);
+	libinput_dispatch(li);
+
+	/* the queue is full, device notifications are queued anyway */
+	device = libinput_path_add_device(li,
+					  libevdev_uinput_get_devnode(dev->uinput));
+	ck_assert(device != NULL);
+	libinput_path_remove_device(device);
+	libinput_dispatch(li);
+
+	for (i = 1; i <= 4; i++)
+		assert_motion(li, i);
+
+	event = libinput_get_event(li);
+	litest_assert_event_type(event, LIBINPUT_EVENT_DEVICE_ADDED);
+	ck_assert_ptr_eq(libinput_event_get_device(event), device);
+	libinput_event_destroy(event);
+
+	event = libinput_get_event(li);
+	litest_assert_event_type(event, LIBINPUT_EVENT_DEVICE_REMOVED);
+	ck_assert_ptr_eq(libinput_event_get_device(event), device);
+	libinput_event_destroy(event);
+
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_POINTER_MOTION),
+			 2);
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_DEVICE_ADDED),
+			 0);
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_DEVICE_REMOVED),
+			 0);
+}
+END_TEST
+
+START_TEST(event_queue_limit_drop_oldest_motion)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	int i;
+
+	litest_drain_events(li);
+
+	libinput_set_event_queue_limit(li,
+			3,
+			LIBINPUT_EVENT_QUEUE_OVERFLOW_DROP_OLDEST_MOTION);
+
+	litest_event(dev, EV_KEY, BTN_LEFT, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	for (i = 1; i <= 5; i++)
+		queue_motion(dev, i);
+	libinput_dispatch(li);
+
+	/* the button event survives, the motion events are replaced */
+	assert_button(li, LIBINPUT_BUTTON_STATE_PRESSED);
+	assert_motion(li, 4);
+	assert_motion(li, 5);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_POINTER_MOTION),
+			 3);
+
+	/* without motion events in the queue the newest event goes */
+	litest_event(dev, EV_KEY, BTN_LEFT, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_KEY, BTN_LEFT, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_KEY, BTN_LEFT, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	queue_motion(dev, 1);
+	libinput_dispatch(li);
+
+	assert_button(li, LIBINPUT_BUTTON_STATE_RELEASED);
+	assert_button(li, LIBINPUT_BUTTON_STATE_PRESSED);
+	assert_button(li, LIBINPUT_BUTTON_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_dropped_event_count(li,
+					LIBINPUT_EVENT_POINTER_MOTION),
+			 4);
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENTS_DROPPED),
+			 4);
+}
+END_TEST
+
+START_TEST(event_queue_limit_coalesce)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	int i;
+
+	litest_drain_events(li);
+
+	libinput_set_event_queue_limit(li,
+				       3,
+				       LIBINPUT_EVENT_QUEUE_OVERFLOW_COALESCE);
+
+	/* the queue fills up, further events merge into the tail */
+	for (i = 1; i <= 5; i++)
+		queue_motion(dev, i);
+	libinput_dispatch(li);
+
+	assert_motion(li, 1);
+	assert_motion(li, 2);
+	assert_motion(li, 3 + 4 + 5);
+	litest_assert_empty_queue(li);
+
+	/* the button event can't merge, the oldest motion events do */
+	queue_motion(dev, 1);
+	queue_motion(dev, 2);
+	litest_event(dev, EV_KEY, BTN_LEFT, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_KEY, BTN_LEFT, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	assert_motion(li, 1 + 2);
+	assert_button(li, LIBINPUT_BUTTON_STATE_PRESSED);
+	assert_button(li, LIBINPUT_BUTTON_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED),
+			 3);
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENTS_DROPPED),
+			 0);
+}
+END_TEST
+
+START_TEST(event_type_subscription)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	uint64_t hits, misses;
+	int i;
+
+	litest_drain_events(li);
+
+	ck_assert_int_eq(libinput_get_event_type_enabled(li,
+					LIBINPUT_EVENT_POINTER_MOTION),
+			 1);
+	ck_assert_int_eq(libinput_set_event_type_enabled(li,
+					LIBINPUT_EVENT_POINTER_MOTION,
+					0),
+			 0);
+	ck_assert_int_eq(libinput_get_event_type_enabled(li,
+					LIBINPUT_EVENT_POINTER_MOTION),
+			 0);
+
+	hits = libinput_get_statistic(li, LIBINPUT_STATISTIC_EVENT_POOL_HITS);
+	misses = libinput_get_statistic(li,
+					LIBINPUT_STATISTIC_EVENT_POOL_MISSES);
+
+	/* disabled events are never allocated */
+	for (i = 1; i <= 5; i++)
+		queue_motion(dev, i);
+	libinput_dispatch(li);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_HITS),
+			 hits);
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_MISSES),
+			 misses);
+
+	/* other types are still delivered */
+	litest_event(dev, EV_KEY, BTN_LEFT, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	queue_motion(dev, 1);
+	litest_event(dev, EV_KEY, BTN_LEFT, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	assert_button(li, LIBINPUT_BUTTON_STATE_PRESSED);
+	assert_button(li, LIBINPUT_BUTTON_STATE_RELEASED);
+	litest_assert_empty_queue(li);
+
+	libinput_set_event_type_enabled(li, LIBINPUT_EVENT_POINTER_MOTION, 1);
+	queue_motion(dev, 3);
+	libinput_dispatch(li);
+	assert_motion(li, 3);
+	litest_assert_empty_queue(li);
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_set_event_type_enabled(li,
+					LIBINPUT_EVENT_DEVICE_REMOVED,
+					0),
+			 -1);
+	ck_assert_int_eq(libinput_set_event_type_enabled(li,
+					LIBINPUT_EVENT_NONE,
+					0),
+			 -1);
+	ck_assert_int_eq(libinput_set_event_type_enabled(li, 1099, 1), -1);
+	litest_restore_log_handler(li);
+	ck_assert_int_eq(libinput_get_event_type_enabled(li, 1099), 0);
+	ck_assert_int_eq(libinput_get_event_type_enabled(li,
+					LIBINPUT_EVENT_DEVICE_REMOVED),
+			 1);
+}
+END_TEST
+
+struct handler_data {
+	int nevents;
+	enum libinput_event_type types[8];
+	uint32_t keys[8];
+	bool destroy;
+};
+
+static void
+event_handler(struct libinput_event *event, void *user_data)
+{
+	struct handler_data *data = user_data;
+	struct libinput_event_keyboard *kev;
+
+	ck_assert_int_lt(data->nevents, ARRAY_LENGTH(data->types));
+
+	data->types[data->nevents] = libinput_event_get_type(event);
+	kev = libinput_event_get_keyboard_event(event);
+	if (kev)
+		data->keys[data->nevents] = libinput_event_keyboard_get_key(kev);
+	data->nevents++;
+
+	/* handler events must not be destroyed, this is a client bug */
+	if (data->destroy)
+		libinput_event_destroy(event);
+}
+
+START_TEST(event_dispatch_with_handler)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct handler_data data = { 0 };
+	uint64_t high_water_mark;
+	int i;
+
+	litest_drain_events(li);
+
+	/* a queued event is delivered before the new ones */
+	litest_keyboard_key(dev, KEY_A, true);
+	libinput_dispatch(li);
+	litest_keyboard_key(dev, KEY_A, false);
+	litest_keyboard_key(dev, KEY_B, true);
+	litest_keyboard_key(dev, KEY_B, false);
+
+	ck_assert_int_eq(libinput_dispatch_with_handler(li,
+							event_handler,
+							&data),
+			 0);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(data.nevents, 4);
+	for (i = 0; i < 4; i++)
+		ck_assert_int_eq(data.types[i], LIBINPUT_EVENT_KEYBOARD_KEY);
+	ck_assert_int_eq(data.keys[0], KEY_A);
+	ck_assert_int_eq(data.keys[1], KEY_A);
+	ck_assert_int_eq(data.keys[2], KEY_B);
+	ck_assert_int_eq(data.keys[3], KEY_B);
+
+	/* each event goes back to the pool before the next one is
+	 * generated */
+	high_water_mark = libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_HIGH_WATER_MARK);
+	for (i = 0; i < 4; i++) {
+		litest_keyboard_key(dev, KEY_A, true);
+		litest_keyboard_key(dev, KEY_A, false);
+	}
+	data.nevents = 0;
+	libinput_dispatch_with_handler(li, event_handler, &data);
+	ck_assert_int_eq(data.nevents, 8);
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_EVENT_POOL_HIGH_WATER_MARK),
+			 high_water_mark);
+	litest_assert_empty_queue(li);
+
+	/* after dispatching with a handler events are queued again */
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_A, false);
+	libinput_dispatch(li);
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_KEYBOARD_KEY);
+
+	/* destroying a handler event is ignored */
+	data.nevents = 0;
+	data.destroy = true;
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_A, false);
+	litest_disable_log_handler(li);
+	libinput_dispatch_with_handler(li, event_handler, &data);
+	litest_restore_log_handler(li);
+	ck_assert_int_eq(data.nevents, 2);
+	litest_assert_empty_queue(li);
+
+	/* a NULL handler is a client bug */
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_dispatch_with_handler(li, NULL, NULL),
+			 -EINVAL);
+	litest_restore_log_handler(li);
+}
+END_TEST
+
+struct forbidden_data {
+	struct libinput_device *device;
+	int nevents;
+	int dispatch_rc;
+	enum libinput_config_status status;
+};
+
+static void
+event_handler_forbidden_calls(struct libinput_event *event, void *user_data)
+{
+	struct forbidden_data *data = user_data;
+	struct libinput *li = libinput_event_get_context(event);
+
+	data->nevents++;
+
+	/* all of these would pull the device out from under the
+	 * dispatcher */
+	libinput_path_remove_device(data->device);
+	libinput_suspend(li);
+	data->dispatch_rc = libinput_dispatch(li);
+	data->status = libinput_device_config_send_events_set_mode(
+				data->device,
+				LIBINPUT_CONFIG_SEND_EVENTS_DISABLED);
+}
+
+START_TEST(event_dispatch_with_handler_forbidden_calls)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct forbidden_data data = { 0 };
+
+	data.device = dev->libinput_device;
+	litest_drain_events(li);
+
+	litest_keyboard_key(dev, KEY_A, true);
+	litest_keyboard_key(dev, KEY_A, false);
+
+	litest_disable_log_handler(li);
+	ck_assert_int_eq(libinput_dispatch_with_handler(li,
+					event_handler_forbidden_calls,
+					&data),
+			 0);
+	litest_restore_log_handler(li);
+
+	ck_assert_int_eq(data.nevents, 2);
+	ck_assert_int_eq(data.dispatch_rc, -EINVAL);
+	ck_assert_int_eq(data.status, LIBINPUT_CONFIG_STATUS_INVALID);
+	litest_assert_empty_queue(li);
+
+	/* the device is neither removed nor disabled */
+	ck_assert_int_eq(libinput_device_config_send_events_get_mode(
+					dev->libinput_device),
+			 LIBINPUT_CONFIG_SEND_EVENTS_ENABLED);
+	litest_keyboard_key(dev, KEY_B, true);
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event, KEY_B, LIBINPUT_KEY_STATE_PRESSED);
+	libinput_event_destroy(event);
+
+	litest_keyboard_key(dev, KEY_B, false);
+	litest_drain_events(li);
+}
+END_TEST
+
+START_TEST(event_dispatch_with_handler_latency)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct handler_data data = { 0 };
+	uint64_t buckets[64] = { 0 };
+	uint64_t total = 0;
+	size_t i, nbuckets;
+
+	litest_drain_events(li);
+	libinput_device_set_latency_tracking(dev->libinput_device, 1);
+
+	/* one event is queued first, the other goes straight to the
+	 * handler, both count as dequeued */
+	litest_keyboard_key(dev, KEY_A, true);
+	libinput_dispatch(li);
+	litest_keyboard_key(dev, KEY_A, false);
+	libinput_dispatch_with_handler(li, event_handler, &data);
+	ck_assert_int_eq(data.nevents, 2);
+
+	nbuckets = libinput_device_get_latency_histogram(dev->libinput_device,
+				LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED,
+				buckets,
+				ARRAY_LENGTH(buckets));
+	for (i = 0; i < nbuckets; i++)
+		total += buckets[i];
+	ck_assert_int_eq(total, 2);
+}
+END_TEST
+
+START_TEST(event_get_events)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *events[7];
+	enum libinput_key_state state;
+	size_t count;
+	int i, j;
+	int total = 0;
+
+	litest_drain_events(li);
+
+	ck_assert_int_eq(libinput_get_events(li, events, ARRAY_LENGTH(events)),
+			 0);
+
+	/* Interleave queueing and retrieving so the ring wraps around */
+	for (j = 0; j < 4; j++) {
+		for (i = 0; i < 5; i++) {
+			litest_keyboard_key(dev, KEY_A, true);
+			litest_keyboard_key(dev, KEY_A, false);
+		}
+		libinput_dispatch(li);
+
+		ck_assert_int_eq(libinput_get_events(li, events, 0), 0);
+
+		while ((count = libinput_get_events(li,
+						    events,
+						    ARRAY_LENGTH(events)))) {
+			ck_assert_int_le(count, ARRAY_LENGTH(events));
+
+			for (i = 0; i < (int)count; i++) {
+				if (total % 2)
+					state = LIBINPUT_KEY_STATE_RELEASED;
+				else
+					state = LIBINPUT_KEY_STATE_PRESSED;
+				litest_is_keyboard_event(events[i],
+							 KEY_A,
+							 state);
+				total++;
+			}
+
+			libinput_events_destroy(events, count);
+		}
+	}
+
+	ck_assert_int_eq(total, 40);
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
+START_TEST(input_thread)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	int epoll_fd = libinput_get_fd(li);
+	int i, count;
+
+	litest_drain_events(li);
+
+	/* queued before the thread starts */
+	litest_keyboard_key(dev, KEY_A, true);
+	libinput_dispatch(li);
+
+	ck_assert_int_eq(libinput_input_thread_start(li), 0);
+	ck_assert_int_ne(libinput_get_fd(li), epoll_fd);
+
+	litest_keyboard_key(dev, KEY_A, false);
+
+	litest_wait_for_event(li);
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event, KEY_A, LIBINPUT_KEY_STATE_PRESSED);
+	libinput_event_destroy(event);
+
+	litest_wait_for_event(li);
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event, KEY_A, LIBINPUT_KEY_STATE_RELEASED);
+	libinput_event_destroy(event);
+
+	/* more events than the thread can publish at once */
+	for (i = 0; i < 600; i++) {
+		litest_keyboard_key(dev, KEY_A, true);
+		litest_keyboard_key(dev, KEY_A, false);
+		if (i % 100 == 0)
+			msleep(10);
+	}
+
+	count = 0;
+	while (count < 1200) {
+		litest_wait_for_event(li);
+		while ((event = libinput_get_event(li))) {
+			litest_is_keyboard_event(event,
+						 KEY_A,
+						 count % 2 ?
+						 LIBINPUT_KEY_STATE_RELEASED :
+						 LIBINPUT_KEY_STATE_PRESSED);
+			libinput_event_destroy(event);
+			count++;
+		}
+	}
+	ck_assert_int_eq(count, 1200);
+
+	/* events not retrieved yet survive stopping the thread */
+	litest_keyboard_key(dev, KEY_B, true);
+	litest_wait_for_event(li);
+
+	libinput_input_thread_stop(li);
+	ck_assert_int_eq(libinput_get_fd(li), epoll_fd);
+
+	litest_keyboard_key(dev, KEY_B, false);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event, KEY_B, LIBINPUT_KEY_STATE_PRESSED);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_keyboard_event(event, KEY_B, LIBINPUT_KEY_STATE_RELEASED);
+	libinput_event_destroy(event);
+
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
 START_TEST(bitfield_helpers)
 {
 	/* This value has a bit set on all of the word boundaries we want to
@@ -572,6 +1251,112 @@ START_TEST(bitfield_helpers)
 }
 END_TEST
 
+START_TEST(key_counts_helpers)
+{
+	struct key_counts counts = {0};
+	unsigned int code;
+
+	ck_assert_int_eq(key_counts_get(&counts, KEY_A), 0);
+	ck_assert_int_eq(key_counts_dec(&counts, KEY_A), 0);
+
+	ck_assert_int_eq(key_counts_inc(&counts, KEY_A), 1);
+	ck_assert_int_eq(key_counts_inc(&counts, KEY_A), 2);
+	ck_assert_int_eq(key_counts_inc(&counts, BTN_LEFT), 1);
+	ck_assert_int_eq(key_counts_get(&counts, KEY_A), 2);
+	ck_assert_int_eq(key_counts_get(&counts, BTN_LEFT), 1);
+	ck_assert_int_eq(key_counts_get(&counts, KEY_B), 0);
+
+	ck_assert_int_eq(key_counts_dec(&counts, KEY_A), 1);
+	ck_assert_int_eq(key_counts_dec(&counts, KEY_A), 0);
+	ck_assert_int_eq(key_counts_dec(&counts, KEY_A), 0);
+	ck_assert_int_eq(key_counts_get(&counts, BTN_LEFT), 1);
+	ck_assert_int_eq(key_counts_dec(&counts, BTN_LEFT), 0);
+	ck_assert_int_eq(counts.nentries, 0);
+
+	/* more keys than the initial allocation */
+	for (code = KEY_ESC; code < KEY_ESC + 40; code++)
+		ck_assert_int_eq(key_counts_inc(&counts, code), 1);
+	for (code = KEY_ESC; code < KEY_ESC + 40; code++)
+		ck_assert_int_eq(key_counts_get(&counts, code), 1);
+	for (code = KEY_ESC; code < KEY_ESC + 40; code += 2)
+		ck_assert_int_eq(key_counts_dec(&counts, code), 0);
+	for (code = KEY_ESC; code < KEY_ESC + 40; code++)
+		ck_assert_int_eq(key_counts_get(&counts, code),
+				 (code - KEY_ESC) % 2);
+	ck_assert_int_eq(counts.nentries, 20);
+
+	key_counts_release(&counts);
+	ck_assert_int_eq(counts.nentries, 0);
+}
+END_TEST
+
+START_TEST(motion_predictor_helpers)
+{
+	struct motion_predictor p;
+	double x, y;
+	uint64_t time = ms2us(1000);
+	int i;
+
+	motion_predictor_reset(&p);
+
+	/* a single sample has no velocity */
+	motion_predictor_update(&p, time, 100, 200);
+	motion_predictor_predict(&p, ms2us(10), &x, &y);
+	ck_assert_double_eq(x, 100);
+	ck_assert_double_eq(y, 200);
+
+	/* constant velocity of 1 unit/ms in x, -0.5 units/ms in y */
+	for (i = 1; i <= 10; i++) {
+		time += ms2us(8);
+		motion_predictor_update(&p, time, 100 + 8 * i, 200 - 4 * i);
+	}
+	motion_predictor_predict(&p, ms2us(10), &x, &y);
+	ck_assert(fabs(x - 190) < 0.01);
+	ck_assert(fabs(y - 155) < 0.01);
+	motion_predictor_predict(&p, 0, &x, &y);
+	ck_assert(fabs(x - 180) < 0.01);
+	ck_assert(fabs(y - 160) < 0.01);
+
+	/* a change of speed is picked up within a few samples */
+	for (i = 1; i <= 10; i++) {
+		time += ms2us(8);
+		motion_predictor_update(&p, time, 180 + 16 * i, 160);
+	}
+	motion_predictor_predict(&p, ms2us(10), &x, &y);
+	ck_assert(fabs(x - 360) < 1);
+	ck_assert(fabs(y - 160) < 1);
+
+	/* up to 50ms between samples is still the same motion */
+	time += ms2us(50);
+	motion_predictor_update(&p, time, 440, 160);
+	motion_predictor_predict(&p, ms2us(10), &x, &y);
+	ck_assert(fabs(x - 460) < 1);
+	ck_assert(fabs(y - 160) < 1);
+
+	/* anything longer is not */
+	time += ms2us(50) + 1;
+	motion_predictor_update(&p, time, 540, 160);
+	motion_predictor_predict(&p, ms2us(10), &x, &y);
+	ck_assert_double_eq(x, 540);
+	ck_assert_double_eq(y, 160);
+
+	/* a gap in the samples means the motion stopped */
+	time += ms2us(500);
+	motion_predictor_update(&p, time, 400, 160);
+	motion_predictor_predict(&p, ms2us(10), &x, &y);
+	ck_assert_double_eq(x, 400);
+	ck_assert_double_eq(y, 160);
+
+	/* so does time going backwards */
+	time += ms2us(8);
+	motion_predictor_update(&p, time, 408, 160);
+	motion_predictor_update(&p, time - ms2us(4), 412, 160);
+	motion_predictor_predict(&p, ms2us(10), &x, &y);
+	ck_assert_double_eq(x, 412);
+	ck_assert_double_eq(y, 160);
+}
+END_TEST
+
 START_TEST(context_ref_counting)
 {
 	struct libinput *li;
@@ -1261,7 +2046,20 @@ litest_setup_tests_misc(void)
 	litest_add_for_device("events:conversion", event_conversion_tablet, LITEST_WACOM_CINTIQ);
 	litest_add_for_device("events:conversion", event_conversion_tablet_pad, LITEST_WACOM_INTUOS5_PAD);
 	litest_add_for_device("events:conversion", event_conversion_switch, LITEST_LID_SWITCH);
+	litest_add_for_device("events:pool", event_pool_statistics, LITEST_KEYBOARD);
+	litest_add_for_device("events:queue limit", event_queue_limit_drop_newest, LITEST_MOUSE);
+	litest_add_for_device("events:queue limit", event_queue_limit_device_notify, LITEST_MOUSE);
+	litest_add_for_device("events:queue limit", event_queue_limit_drop_oldest_motion, LITEST_MOUSE);
+	litest_add_for_device("events:queue limit", event_queue_limit_coalesce, LITEST_MOUSE);
+	litest_add_for_device("events:subscription", event_type_subscription, LITEST_MOUSE);
+	litest_add_for_device("events:handler", event_dispatch_with_handler, LITEST_KEYBOARD);
+	litest_add_for_device("events:handler", event_dispatch_with_handler_latency, LITEST_KEYBOARD);
+	litest_add_for_device("events:handler", event_dispatch_with_handler_forbidden_calls, LITEST_KEYBOARD);
+	litest_add_for_device("events:bulk", event_get_events, LITEST_KEYBOARD);
+	litest_add_for_device("events:thread", input_thread, LITEST_KEYBOARD);
 	litest_add_no_device("misc:bitfield_helpers", bitfield_helpers);
+	litest_add_no_device("misc:key_counts", key_counts_helpers);
+	litest_add_no_device("misc:motion_predictor", motion_predictor_helpers);
 
 	litest_add_no_device("context:refcount", context_ref_counting);
 	litest_add_no_device("config:status string", config_status_string);
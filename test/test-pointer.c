@@ -33,6 +33,7 @@
 #include <values.h>
 
 #include "libinput-util.h"
+#include "filter.h"
 #include "litest.h"
 
 static void
@@ -343,6 +344,147 @@ START_TEST(pointer_motion_unaccel)
 }
 END_TEST
 
+static void
+assert_predicted_motion(struct libinput *li, bool moves)
+{
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	double dx, dy;
+
+	libinput_dispatch(li);
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	dx = libinput_event_pointer_get_predicted_dx_unaccelerated(ptrev);
+	dy = libinput_event_pointer_get_predicted_dy_unaccelerated(ptrev);
+	if (!moves)
+		ck_assert_double_eq(dx, 0.0);
+	ck_assert_double_eq(dy, 0.0);
+	libinput_event_destroy(event);
+}
+
+START_TEST(pointer_motion_prediction)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_device *device = dev->libinput_device;
+	int i;
+
+	ck_assert(libinput_device_config_prediction_is_available(device));
+	litest_drain_events(li);
+
+	/* disabled by default, nothing is predicted */
+	litest_event(dev, EV_REL, REL_X, 5);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	assert_predicted_motion(li, false);
+
+	/* How far ahead the prediction is depends on the time between the
+	 * frames, see the predictor tests in test-misc. Whatever it is, the
+	 * prediction stays on the axis the pointer moves along */
+	libinput_device_config_prediction_set_lookahead(device, 16);
+
+	/* the first frame has no velocity */
+	litest_event(dev, EV_REL, REL_X, 5);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	assert_predicted_motion(li, false);
+
+	for (i = 0; i < 10; i++) {
+		litest_event(dev, EV_REL, REL_X, 5);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+		assert_predicted_motion(li, true);
+	}
+
+	libinput_device_config_prediction_set_lookahead(device, 0);
+	litest_event(dev, EV_REL, REL_X, 5);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	assert_predicted_motion(li, false);
+}
+END_TEST
+
+START_TEST(pointer_motion_coalescing)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+	uint64_t coalesced;
+	int i;
+
+	ck_assert_int_eq(libinput_get_motion_coalescing(li), 0);
+	libinput_set_motion_coalescing(li, 1);
+	ck_assert_int_eq(libinput_get_motion_coalescing(li), 1);
+
+	litest_drain_events(li);
+	coalesced = libinput_get_statistic(li,
+			LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED);
+
+	/* the caller falls behind, all five frames end up in one event */
+	for (i = 0; i < 5; i++) {
+		litest_event(dev, EV_REL, REL_X, 2);
+		litest_event(dev, EV_REL, REL_Y, -1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	ptrev = litest_is_motion_event(event);
+	litest_assert_int_eq(
+		libinput_event_pointer_get_dx_unaccelerated(ptrev), 10);
+	litest_assert_int_eq(
+		libinput_event_pointer_get_dy_unaccelerated(ptrev), -5);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED),
+			 coalesced + 4);
+
+	/* motion events are never merged across other events */
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_KEY, BTN_LEFT, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_event(dev, EV_REL, REL_X, 1);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	litest_is_motion_event(event);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_button_event(event,
+			       BTN_LEFT,
+			       LIBINPUT_BUTTON_STATE_PRESSED);
+	libinput_event_destroy(event);
+	event = libinput_get_event(li);
+	litest_is_motion_event(event);
+	libinput_event_destroy(event);
+	litest_assert_empty_queue(li);
+
+	ck_assert_int_eq(libinput_get_statistic(li,
+				LIBINPUT_STATISTIC_MOTION_EVENTS_COALESCED),
+			 coalesced + 4);
+
+	litest_event(dev, EV_KEY, BTN_LEFT, 0);
+	litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	litest_drain_events(li);
+
+	/* disabled again, every frame is its own event */
+	libinput_set_motion_coalescing(li, 0);
+	for (i = 0; i < 2; i++) {
+		litest_event(dev, EV_REL, REL_X, 1);
+		litest_event(dev, EV_SYN, SYN_REPORT, 0);
+	}
+	libinput_dispatch(li);
+
+	for (i = 0; i < 2; i++) {
+		event = libinput_get_event(li);
+		litest_is_motion_event(event);
+		libinput_event_destroy(event);
+	}
+	litest_assert_empty_queue(li);
+}
+END_TEST
+
 static void
 test_button_event(struct litest_device *dev, unsigned int button, int state)
 {
@@ -1282,6 +1424,311 @@ START_TEST(pointer_accel_direction_change)
 }
 END_TEST
 
+static void
+filter_test_event(int i,
+		  double scale,
+		  struct device_float_coords *delta,
+		  uint64_t *time)
+{
+	int dir = (i / 8) % 2 ? -1 : 1;
+
+	delta->x = scale * dir * (1 + (i * 7) % 11);
+	delta->y = scale * ((i * 5) % 7 - 3);
+	*time += (i == 20) ? ms2us(1500) : ms2us(1 + i % 4);
+}
+
+static void
+filter_regression_run(struct motion_filter *filter,
+		      double scale,
+		      const struct normalized_coords *expected,
+		      size_t nexpected)
+{
+	struct device_float_coords delta;
+	struct normalized_coords out;
+	uint64_t time = ms2us(1000);
+	size_t i;
+
+	/* The accumulated positions and the acceleration table may round
+	 * differently to the recorded values, allow for a relative error
+	 * of 1e-12 (absolute for values below 1) */
+	for (i = 0; i < nexpected; i++) {
+		filter_test_event(i, scale, &delta, &time);
+		out = filter_dispatch(filter, &delta, NULL, time);
+		ck_assert(fabs(out.x - expected[i].x) <=
+			  1e-12 * max(1.0, fabs(expected[i].x)));
+		ck_assert(fabs(out.y - expected[i].y) <=
+			  1e-12 * max(1.0, fabs(expected[i].y)));
+	}
+	filter_destroy(filter);
+}
+
+START_TEST(pointer_accel_filter_regression)
+{
+	/* Output of the linear, touchpad and x230 filters, recorded with
+	 * the per-tracker delta accumulation that was used before the
+	 * trackers switched to accumulated positions. The sequence
+	 * includes direction changes and a motion timeout. */
+	struct normalized_coords expected_linear[] = {
+		{ 0.31581137248946939, -0.94743411746840822 },
+		{ 16.775496993305254, 4.1938742483263134 },
+		{ 9.723635316005776, 0 },
+		{ 26.739997119015882, -4.861817658002888 },
+		{ 17.150000000000002, 7.3500000000000005 },
+		{ 7.3500000000000005, 2.4500000000000002 },
+		{ 24.5, -2.4500000000000002 },
+		{ 14.700000000000001, -7.3500000000000005 },
+		{ -4.9000000000000004, 4.9000000000000004 },
+		{ -22.050000000000001, 0 },
+		{ -12.25, -4.9000000000000004 },
+		{ -2.1989855781562602, 6.5969567344687805 },
+		{ -18.488823552352947, 2.3111029440441184 },
+		{ -9.8000000000000007, -2.4500000000000002 },
+		{ -26.950000000000003, -7.3500000000000005 },
+		{ -17.150000000000002, 4.9000000000000004 },
+		{ 7.3500000000000005, 0 },
+		{ 24.5, -4.9000000000000004 },
+		{ 14.700000000000001, 7.3500000000000005 },
+		{ 4.8373853571275012, 2.4186926785637506 },
+		{ 12.509653082391651, -1.3899614535990723 },
+		{ 10.53379480068968, -6.3202768804138074 },
+		{ 2.3011071001436867, 4.6022142002873734 },
+		{ 18.07647084500476, 0 },
+		{ -9.8000000000000007, -4.9000000000000004 },
+		{ -26.950000000000003, 7.3500000000000005 },
+		{ -17.150000000000002, 2.4500000000000002 },
+		{ -7.3500000000000005, -2.4500000000000002 },
+		{ -24.5, -7.3500000000000005 },
+		{ -14.700000000000001, 4.9000000000000004 },
+		{ -4.9000000000000004, 0 },
+		{ -22.050000000000001, -4.9000000000000004 },
+	};
+	struct normalized_coords expected_linear_1200dpi[] = {
+		{ 0.2591500998202948, -0.7774502994608844 },
+		{ 13.968844710631901, 3.4922111776579752 },
+		{ 7.8032322430588987, 0 },
+		{ 19.790813056301864, -3.5983296466003396 },
+		{ 14.291666666666668, 6.125 },
+		{ 5.9472980234019426, 1.9824326744673142 },
+		{ 19.824326744673144, -1.9824326744673142 },
+		{ 12.25, -6.125 },
+		{ -4.0833333333333339, 4.0833333333333339 },
+		{ -18.375, 0 },
+		{ -10.208333333333334, -4.0833333333333339 },
+		{ -1.7614835172404264, 5.284450551721279 },
+		{ -15.051807611315365, 1.8814759514144206 },
+		{ -8.1666666666666679, -2.041666666666667 },
+		{ -22.458333333333332, -6.125 },
+		{ -14.291666666666668, 4.0833333333333339 },
+		{ 6.125, 0 },
+		{ 20.416666666666668, -4.0833333333333339 },
+		{ 12.25, 6.125 },
+		{ 3.8874770585228591, 1.9437385292614295 },
+		{ 8.4413139944396125, -0.9379237771599569 },
+		{ 7.2705925410031664, -4.3623555246018997 },
+		{ 1.9359095050713071, 3.8718190101426142 },
+		{ 12.309126241646123, 0 },
+		{ -7.9189941311002361, -3.959497065550118 },
+		{ -22.458333333333332, 6.125 },
+		{ -14.291666666666668, 2.041666666666667 },
+		{ -5.6566229391154277, -1.8855409797051426 },
+		{ -19.630099125499708, -5.8890297376499126 },
+		{ -12.25, 4.0833333333333339 },
+		{ -3.9823898572093763, 0 },
+		{ -17.920754357442192, -3.9823898572093763 },
+	};
+	struct normalized_coords expected_touchpad[] = {
+		{ 0.041273426936480111, -0.12382028080944031 },
+		{ 1.8806358051639469, 0.47015895129098673 },
+		{ 1.0951999999999997, 0 },
+		{ 3.0117999999999996, -0.54759999999999986 },
+		{ 1.9165999999999996, 0.8213999999999998 },
+		{ 0.8213999999999998, 0.27379999999999993 },
+		{ 2.7379999999999995, -0.27379999999999993 },
+		{ 1.6427999999999996, -0.8213999999999998 },
+		{ -0.54759999999999986, 0.54759999999999986 },
+		{ -2.4641999999999995, 0 },
+		{ -1.3689999999999998, -0.54759999999999986 },
+		{ -0.27379999999999993, 0.8213999999999998 },
+		{ -2.1903999999999995, 0.27379999999999993 },
+		{ -1.0951999999999997, -0.27379999999999993 },
+		{ -3.0117999999999996, -0.8213999999999998 },
+		{ -1.9165999999999996, 0.54759999999999986 },
+		{ 0.8213999999999998, 0 },
+		{ 2.7379999999999995, -0.54759999999999986 },
+		{ 1.6427999999999996, 0.8213999999999998 },
+		{ 0.54759999999999986, 0.27379999999999993 },
+		{ 2.1168525782855836, -0.2352058420317315 },
+		{ 1.1760292101586576, -0.70561752609519446 },
+		{ 0.27379999999999993, 0.54759999999999986 },
+		{ 2.1903999999999995, 0 },
+		{ -1.0951999999999997, -0.54759999999999986 },
+		{ -3.0117999999999996, 0.8213999999999998 },
+		{ -1.9165999999999996, 0.27379999999999993 },
+		{ -0.8213999999999998, -0.27379999999999993 },
+		{ -2.7379999999999995, -0.8213999999999998 },
+		{ -1.6427999999999996, 0.54759999999999986 },
+		{ -0.54759999999999986, 0 },
+		{ -2.4641999999999995, -0.54759999999999986 },
+	};
+	struct normalized_coords expected_x230[] = {
+		{ 1.082288446904181e-05, -3.2468653407125425e-05 },
+		{ 0.13603409606749153, 0.034008524016872883 },
+		{ 0.14935206457029732, 0 },
+		{ 0.18778159347741519, -0.034142107904984578 },
+		{ 0.33758705146276818, 0.14468016491261493 },
+		{ 0.15592994566457877, 0.051976648554859589 },
+		{ 0.37716614153882078, -0.037716614153882076 },
+		{ 0.20424484590197159, -0.10212242295098579 },
+		{ -0.04312622508208596, 0.04312622508208596 },
+		{ -0.3849882615380219, 0 },
+		{ -0.21391640130103784, -0.085566560520415127 },
+		{ -0.018460748656857682, 0.055382245970573042 },
+		{ -0.37426571869640346, 0.046783214837050432 },
+		{ -0.19445263442267224, -0.048613158605668061 },
+		{ -0.1802571951105893, -0.049161053211978889 },
+		{ -0.11751074625101367, 0.033574498928861052 },
+		{ 0.064217342483841075, 0 },
+		{ 0.45095925821314908, -0.0901918516426298 },
+		{ 0.27434512002776212, 0.13717256001388106 },
+		{ 0.041744040353142574, 0.020872020176571287 },
+		{ 0.0622561531340163, -0.006917350348224033 },
+		{ 0.065293129902585886, -0.039175877941551522 },
+		{ 0.017190452344185394, 0.034380904688370788 },
+		{ 0.075997426902935081, 0 },
+		{ -0.14252920475671788, -0.071264602378358938 },
+		{ -0.56470748853152386, 0.15401113323587012 },
+		{ -0.34290248800426515, 0.048986069714895025 },
+		{ -0.10737644358828541, -0.03579214786276181 },
+		{ -0.56100101654997414, -0.16830030496499221 },
+		{ -0.36859120569123499, 0.12286373523041166 },
+		{ -0.069525326207070054, 0 },
+		{ -0.1579991394853946, -0.035110919885643244 },
+	};
+	struct motion_filter *filter;
+
+	filter = create_pointer_accelerator_filter_linear(1000);
+	filter_set_speed(filter, 0.3);
+	filter_regression_run(filter, 1.0,
+			      expected_linear,
+			      ARRAY_LENGTH(expected_linear));
+
+	filter = create_pointer_accelerator_filter_linear(1200);
+	filter_set_speed(filter, 0.3);
+	filter_regression_run(filter, 1.0,
+			      expected_linear_1200dpi,
+			      ARRAY_LENGTH(expected_linear_1200dpi));
+
+	filter = create_pointer_accelerator_filter_touchpad(1000);
+	filter_regression_run(filter, 0.37,
+			      expected_touchpad,
+			      ARRAY_LENGTH(expected_touchpad));
+
+	filter = create_pointer_accelerator_filter_lenovo_x230(1000);
+	filter_regression_run(filter, 0.37,
+			      expected_x230,
+			      ARRAY_LENGTH(expected_x230));
+}
+END_TEST
+
+START_TEST(pointer_accel_filter_batch)
+{
+	struct motion_filter *(*create[])(int dpi) = {
+		create_pointer_accelerator_filter_flat,
+		create_pointer_accelerator_filter_linear,
+		create_pointer_accelerator_filter_linear_low_dpi,
+		create_pointer_accelerator_filter_touchpad,
+		create_pointer_accelerator_filter_lenovo_x230,
+		create_pointer_accelerator_filter_trackpoint,
+	};
+	struct motion_filter *single, *batch;
+	struct device_float_coords deltas[32];
+	struct normalized_coords accelerated[32], out;
+	uint64_t times[32];
+	uint64_t time;
+	unsigned int i;
+	int j;
+
+	time = ms2us(1000);
+	for (j = 0; j < (int)ARRAY_LENGTH(deltas); j++) {
+		filter_test_event(j, 1.0, &deltas[j], &time);
+		times[j] = time;
+	}
+
+	for (i = 0; i < ARRAY_LENGTH(create); i++) {
+		single = create[i](800);
+		batch = create[i](800);
+		filter_set_speed(single, 0.4);
+		filter_set_speed(batch, 0.4);
+
+		/* split into two batches to check the filter state carries
+		 * over */
+		filter_dispatch_batch(batch, deltas, times, accelerated,
+				      10, NULL);
+		filter_dispatch_batch(batch, &deltas[10], &times[10],
+				      &accelerated[10],
+				      ARRAY_LENGTH(deltas) - 10, NULL);
+
+		for (j = 0; j < (int)ARRAY_LENGTH(deltas); j++) {
+			out = filter_dispatch(single, &deltas[j], NULL, times[j]);
+			ck_assert(out.x == accelerated[j].x);
+			ck_assert(out.y == accelerated[j].y);
+		}
+
+		filter_destroy(single);
+		filter_destroy(batch);
+	}
+}
+END_TEST
+
+START_TEST(pointer_accel_lut_matches_profile)
+{
+	struct {
+		struct motion_filter *(*create)(int dpi);
+		accel_profile_func_t profile;
+		int dpi;
+	} filters[] = {
+		{ create_pointer_accelerator_filter_linear,
+		  pointer_accel_profile_linear, 1000 },
+		{ create_pointer_accelerator_filter_linear_low_dpi,
+		  pointer_accel_profile_linear_low_dpi, 400 },
+		{ create_pointer_accelerator_filter_touchpad,
+		  touchpad_accel_profile_linear, 1000 },
+		{ create_pointer_accelerator_filter_lenovo_x230,
+		  touchpad_lenovo_x230_accel_profile, 1000 },
+		{ create_pointer_accelerator_filter_trackpoint,
+		  trackpoint_accel_profile, 1000 },
+	};
+	struct motion_filter *filter;
+	double speed, velocity, expected, factor;
+	unsigned int i;
+	int v;
+
+	for (i = 0; i < ARRAY_LENGTH(filters); i++) {
+		filter = filters[i].create(filters[i].dpi);
+
+		for (speed = -1.0; speed <= 1.0; speed += 0.25) {
+			ck_assert(filter_set_speed(filter, speed));
+
+			/* 0 to 10 units/ms */
+			for (v = 0; v <= 10000; v++) {
+				velocity = v/1000000.0;
+				expected = filters[i].profile(filter,
+							      NULL,
+							      velocity,
+							      0);
+				factor = pointer_accel_profile_lut(filter,
+								   NULL,
+								   velocity,
+								   0);
+				ck_assert(fabs(factor - expected) < 1e-9);
+			}
+		}
+
+		filter_destroy(filter);
+	}
+}
+END_TEST
+
 START_TEST(pointer_accel_profile_defaults)
 {
 	struct litest_device *dev = litest_current_device();
@@ -1909,6 +2356,8 @@ litest_setup_tests_pointer(void)
 	litest_add_ranged("pointer:motion", pointer_motion_relative_min_decel, LITEST_RELATIVE, LITEST_ANY, &compass);
 	litest_add("pointer:motion", pointer_motion_absolute, LITEST_ABSOLUTE, LITEST_ANY);
 	litest_add("pointer:motion", pointer_motion_unaccel, LITEST_RELATIVE, LITEST_ANY);
+	litest_add_for_device("pointer:motion", pointer_motion_coalescing, LITEST_MOUSE);
+	litest_add_for_device("pointer:motion", pointer_motion_prediction, LITEST_MOUSE);
 	litest_add("pointer:button", pointer_button, LITEST_BUTTON, LITEST_CLICKPAD);
 	litest_add_no_device("pointer:button", pointer_button_auto_release);
 	litest_add_no_device("pointer:button", pointer_seat_button_count);
@@ -1938,6 +2387,9 @@ litest_setup_tests_pointer(void)
 	litest_add("pointer:accel", pointer_accel_defaults_absolute, LITEST_ABSOLUTE, LITEST_RELATIVE);
 	litest_add("pointer:accel", pointer_accel_defaults_absolute_relative, LITEST_ABSOLUTE|LITEST_RELATIVE, LITEST_ANY);
 	litest_add("pointer:accel", pointer_accel_direction_change, LITEST_RELATIVE, LITEST_ANY);
+	litest_add_no_device("pointer:accel", pointer_accel_filter_regression);
+	litest_add_no_device("pointer:accel", pointer_accel_lut_matches_profile);
+	litest_add_no_device("pointer:accel", pointer_accel_filter_batch);
 	litest_add("pointer:accel", pointer_accel_profile_defaults, LITEST_RELATIVE, LITEST_TOUCHPAD);
 	litest_add("pointer:accel", pointer_accel_profile_defaults_noprofile, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("pointer:accel", pointer_accel_profile_invalid, LITEST_RELATIVE, LITEST_ANY);
@@ -0,0 +1,348 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* The timer heap is internal to libinput.so, so this test builds timer.c
+ * on its own and provides the few context hooks it needs. The timerfd is
+ * real, the test invokes the timer source's dispatch function directly
+ * once all timers it cares about are in the past. */
+
+#include <config.h>
+
+#include <check.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libinput-private.h"
+#include "timer.h"
+
+#define NTIMERS 32
+
+struct libinput_source {
+	libinput_source_dispatch_t dispatch;
+	void *user_data;
+	int fd;
+};
+
+struct test_timer {
+	struct libinput_timer timer;
+	int id;
+	void (*func)(struct test_timer *t, uint64_t now);
+	struct test_timer *other;
+};
+
+static struct libinput_source timer_source;
+static int fired[NTIMERS * 2];
+static int nfired;
+
+struct libinput_source *
+libinput_add_fd(struct libinput *libinput,
+		int fd,
+		libinput_source_dispatch_t dispatch,
+		void *user_data)
+{
+	timer_source.dispatch = dispatch;
+	timer_source.user_data = user_data;
+	timer_source.fd = fd;
+
+	return &timer_source;
+}
+
+void
+libinput_remove_source(struct libinput *libinput,
+		       struct libinput_source *source)
+{
+	source->dispatch = NULL;
+}
+
+void
+log_msg(struct libinput *libinput,
+	enum libinput_log_priority priority,
+	const char *format, ...)
+{
+	/* silence, the tests re-arm timers in the past on purpose */
+}
+
+static void
+test_timer_func(uint64_t now, void *data)
+{
+	struct test_timer *t = data;
+
+	ck_assert_int_lt(nfired, ARRAY_LENGTH(fired));
+	fired[nfired++] = t->id;
+
+	if (t->func)
+		t->func(t, now);
+}
+
+static struct libinput *
+timer_context_new(void)
+{
+	struct libinput *li = zalloc(sizeof(*li));
+
+	ck_assert_int_eq(libinput_timer_subsys_init(li), 0);
+	nfired = 0;
+
+	return li;
+}
+
+static void
+timer_context_destroy(struct libinput *li)
+{
+	libinput_timer_subsys_destroy(li);
+	free(li);
+}
+
+static void
+test_timer_init(struct libinput *li, struct test_timer *t, int id)
+{
+	memset(t, 0, sizeof(*t));
+	t->id = id;
+	libinput_timer_init(&t->timer, li, test_timer_func, t);
+}
+
+/* Wait until the given time has passed, then run the timer source */
+static void
+timer_dispatch_after(struct libinput *li, uint64_t time)
+{
+	while (libinput_now(li) <= time)
+		msleep(1);
+
+	timer_source.dispatch(timer_source.user_data);
+}
+
+static void
+assert_heap_valid(struct libinput *li)
+{
+	struct libinput_timer **heap = li->timer.heap;
+	size_t i;
+
+	for (i = 0; i < li->timer.heap_count; i++) {
+		ck_assert_int_eq(heap[i]->heap_index, i);
+		ck_assert_int_ne(heap[i]->expire, 0);
+		if (i > 0)
+			ck_assert_int_le(heap[(i - 1)/2]->expire,
+					 heap[i]->expire);
+	}
+}
+
+START_TEST(timer_heap_order)
+{
+	struct libinput *li = timer_context_new();
+	struct test_timer timers[NTIMERS];
+	uint64_t now = libinput_now(li);
+	int i, id;
+
+	/* arm in a scrambled order, 7 is coprime with NTIMERS */
+	for (i = 0; i < NTIMERS; i++) {
+		id = (i * 7) % NTIMERS;
+		test_timer_init(li, &timers[id], id);
+		libinput_timer_set(&timers[id].timer, now + ms2us(id + 1));
+		assert_heap_valid(li);
+	}
+
+	ck_assert_int_eq(li->timer.heap_count, NTIMERS);
+	ck_assert_ptr_eq(li->timer.heap[0], &timers[0].timer);
+
+	/* moving a timer earlier and later keeps the heap valid */
+	libinput_timer_set(&timers[NTIMERS - 1].timer, now + ms2us(1) - 1);
+	assert_heap_valid(li);
+	ck_assert_ptr_eq(li->timer.heap[0], &timers[NTIMERS - 1].timer);
+	libinput_timer_set(&timers[NTIMERS - 1].timer, now + ms2us(NTIMERS));
+	assert_heap_valid(li);
+
+	timer_dispatch_after(li, now + ms2us(NTIMERS));
+
+	ck_assert_int_eq(nfired, NTIMERS);
+	for (i = 0; i < NTIMERS; i++)
+		ck_assert_int_eq(fired[i], i);
+	ck_assert_int_eq(li->timer.heap_count, 0);
+
+	timer_context_destroy(li);
+}
+END_TEST
+
+START_TEST(timer_heap_cancel)
+{
+	struct libinput *li = timer_context_new();
+	struct test_timer timers[NTIMERS];
+	struct libinput_timer *mid;
+	uint64_t now = libinput_now(li);
+	int i;
+
+	for (i = 0; i < NTIMERS; i++) {
+		test_timer_init(li, &timers[i], i);
+		libinput_timer_set(&timers[i].timer, now + ms2us(i + 1));
+	}
+
+	/* a timer in the middle of the heap, the root and a leaf */
+	mid = li->timer.heap[5];
+	libinput_timer_cancel(mid);
+	assert_heap_valid(li);
+	libinput_timer_cancel(li->timer.heap[0]);
+	assert_heap_valid(li);
+	libinput_timer_cancel(li->timer.heap[li->timer.heap_count - 1]);
+	assert_heap_valid(li);
+	ck_assert_int_eq(li->timer.heap_count, NTIMERS - 3);
+
+	/* cancelling twice is harmless */
+	libinput_timer_cancel(mid);
+	assert_heap_valid(li);
+	ck_assert_int_eq(li->timer.heap_count, NTIMERS - 3);
+
+	timer_dispatch_after(li, now + ms2us(NTIMERS));
+
+	ck_assert_int_eq(nfired, NTIMERS - 3);
+	for (i = 1; i < nfired; i++)
+		ck_assert_int_lt(fired[i - 1], fired[i]);
+	for (i = 0; i < nfired; i++) {
+		ck_assert_ptr_ne(&timers[fired[i]].timer, mid);
+		ck_assert_int_ne(fired[i], 0);
+	}
+
+	timer_context_destroy(li);
+}
+END_TEST
+
+static void
+rearm_self(struct test_timer *t, uint64_t now)
+{
+	/* only once */
+	t->func = NULL;
+	libinput_timer_set(&t->timer, now + ms2us(2));
+}
+
+START_TEST(timer_rearm_in_callback)
+{
+	struct libinput *li = timer_context_new();
+	struct test_timer a, b;
+	uint64_t now = libinput_now(li);
+
+	test_timer_init(li, &a, 1);
+	test_timer_init(li, &b, 2);
+	a.func = rearm_self;
+	libinput_timer_set(&a.timer, now + ms2us(1));
+	libinput_timer_set(&b.timer, now + ms2us(20));
+
+	timer_dispatch_after(li, now + ms2us(1));
+	ck_assert_int_eq(nfired, 1);
+	ck_assert_int_eq(fired[0], 1);
+
+	/* a is back in the heap, ahead of b */
+	ck_assert_int_eq(li->timer.heap_count, 2);
+	ck_assert_ptr_eq(li->timer.heap[0], &a.timer);
+	assert_heap_valid(li);
+
+	timer_dispatch_after(li, now + ms2us(20));
+	ck_assert_int_eq(nfired, 3);
+	ck_assert_int_eq(fired[1], 1);
+	ck_assert_int_eq(fired[2], 2);
+	ck_assert_int_eq(li->timer.heap_count, 0);
+
+	timer_context_destroy(li);
+}
+END_TEST
+
+static void
+rearm_self_expired(struct test_timer *t, uint64_t now)
+{
+	/* already expired, but must not fire again in this pass */
+	libinput_timer_set(&t->timer, now);
+}
+
+static void
+cancel_other(struct test_timer *t, uint64_t now)
+{
+	libinput_timer_cancel(&t->other->timer);
+}
+
+START_TEST(timer_collect_before_fire)
+{
+	struct libinput *li = timer_context_new();
+	struct test_timer a, b, c;
+	uint64_t now = libinput_now(li);
+
+	test_timer_init(li, &a, 1);
+	test_timer_init(li, &b, 2);
+	test_timer_init(li, &c, 3);
+	a.func = rearm_self_expired;
+	b.func = cancel_other;
+	b.other = &c;
+	libinput_timer_set(&a.timer, now + ms2us(1));
+	libinput_timer_set(&b.timer, now + ms2us(2));
+	libinput_timer_set(&c.timer, now + ms2us(3));
+
+	/* all three expire in the same pass. a re-arms itself into the
+	 * past and b cancels c, which was already collected */
+	timer_dispatch_after(li, now + ms2us(3));
+	ck_assert_int_eq(nfired, 2);
+	ck_assert_int_eq(fired[0], 1);
+	ck_assert_int_eq(fired[1], 2);
+
+	ck_assert_int_eq(li->timer.heap_count, 1);
+	ck_assert_ptr_eq(li->timer.heap[0], &a.timer);
+
+	/* the re-armed a fires on the next pass */
+	a.func = NULL;
+	timer_dispatch_after(li, now + ms2us(3));
+	ck_assert_int_eq(nfired, 3);
+	ck_assert_int_eq(fired[2], 1);
+	ck_assert_int_eq(li->timer.heap_count, 0);
+
+	timer_context_destroy(li);
+}
+END_TEST
+
+static Suite *
+timer_suite(void)
+{
+	TCase *tc;
+	Suite *s;
+
+	s = suite_create("timer");
+	tc = tcase_create("heap");
+	tcase_add_test(tc, timer_heap_order);
+	tcase_add_test(tc, timer_heap_cancel);
+	tcase_add_test(tc, timer_rearm_in_callback);
+	tcase_add_test(tc, timer_collect_before_fire);
+	suite_add_tcase(s, tc);
+
+	return s;
+}
+
+int
+main(int argc, char **argv)
+{
+	int nfailed;
+	Suite *s;
+	SRunner *sr;
+
+	s = timer_suite();
+	sr = srunner_create(s);
+
+	srunner_run_all(sr, CK_ENV);
+	nfailed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+
+	return (nfailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -843,6 +843,135 @@ START_TEST(touch_time_usec)
 }
 END_TEST
 
+START_TEST(touch_prediction_config)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	enum libinput_config_status status;
+
+	ck_assert(libinput_device_config_prediction_is_available(device));
+	ck_assert_int_eq(libinput_device_config_prediction_get_lookahead(device),
+			 0);
+	ck_assert_int_eq(libinput_device_config_prediction_get_default_lookahead(device),
+			 0);
+
+	status = libinput_device_config_prediction_set_lookahead(device, 16);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	ck_assert_int_eq(libinput_device_config_prediction_get_lookahead(device),
+			 16);
+
+	status = libinput_device_config_prediction_set_lookahead(device, 51);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_INVALID);
+	ck_assert_int_eq(libinput_device_config_prediction_get_lookahead(device),
+			 16);
+
+	status = libinput_device_config_prediction_set_lookahead(device, 0);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+}
+END_TEST
+
+START_TEST(touch_prediction_disabled)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, 10, 50);
+	litest_touch_move_to(dev, 0, 10, 50, 90, 50, 10, 2);
+	litest_touch_up(dev, 0);
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		enum libinput_event_type type = libinput_event_get_type(event);
+
+		if (type == LIBINPUT_EVENT_TOUCH_DOWN ||
+		    type == LIBINPUT_EVENT_TOUCH_MOTION) {
+			tev = libinput_event_get_touch_event(event);
+			ck_assert_double_eq(libinput_event_touch_get_predicted_x(tev),
+					    libinput_event_touch_get_x(tev));
+			ck_assert_double_eq(libinput_event_touch_get_predicted_y(tev),
+					    libinput_event_touch_get_y(tev));
+		}
+		libinput_event_destroy(event);
+	}
+}
+END_TEST
+
+static void
+assert_predicted_touch(struct libinput *li, bool moves)
+{
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+	double x, y, px, py;
+
+	libinput_dispatch(li);
+
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) !=
+		    LIBINPUT_EVENT_TOUCH_MOTION) {
+			libinput_event_destroy(event);
+			continue;
+		}
+
+		tev = libinput_event_get_touch_event(event);
+		x = libinput_event_touch_get_x(tev);
+		y = libinput_event_touch_get_y(tev);
+		px = libinput_event_touch_get_predicted_x(tev);
+		py = libinput_event_touch_get_predicted_y(tev);
+		if (!moves)
+			ck_assert_double_eq(px, x);
+		ck_assert_double_eq(py, y);
+		libinput_event_destroy(event);
+	}
+}
+
+START_TEST(touch_prediction_motion)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput *li = dev->libinput;
+	struct libinput_event *event;
+	struct libinput_event_touch *tev;
+
+	libinput_device_config_prediction_set_lookahead(dev->libinput_device,
+							16);
+	litest_drain_events(li);
+
+	/* a new touch has no velocity */
+	litest_touch_down(dev, 0, 10, 50);
+	libinput_dispatch(li);
+
+	event = libinput_get_event(li);
+	tev = litest_is_touch_event(event, LIBINPUT_EVENT_TOUCH_DOWN);
+	ck_assert_double_eq(libinput_event_touch_get_predicted_x(tev),
+			    libinput_event_touch_get_x(tev));
+	ck_assert_double_eq(libinput_event_touch_get_predicted_y(tev),
+			    libinput_event_touch_get_y(tev));
+	libinput_event_destroy(event);
+	litest_drain_events(li);
+
+	/* How far ahead the prediction is depends on the time between the
+	 * frames, see the predictor tests in test-misc. Whatever it is, the
+	 * prediction stays on the line the touch moves along */
+	litest_touch_move_to(dev, 0, 10, 50, 90, 50, 10, 0);
+	assert_predicted_touch(li, true);
+	litest_touch_up(dev, 0);
+	litest_drain_events(li);
+
+	/* without a look-ahead, the prediction is the touch */
+	libinput_device_config_prediction_set_lookahead(dev->libinput_device,
+							0);
+	litest_touch_down(dev, 0, 10, 50);
+	litest_drain_events(li);
+	litest_touch_move_to(dev, 0, 10, 50, 90, 50, 10, 0);
+	assert_predicted_touch(li, false);
+	litest_touch_up(dev, 0);
+	litest_drain_events(li);
+}
+END_TEST
+
 START_TEST(touch_fuzz)
 {
 	struct litest_device *dev = litest_current_device();
@@ -919,5 +1048,9 @@ litest_setup_tests_touch(void)
 
 	litest_add("touch:time", touch_time_usec, LITEST_TOUCH, LITEST_TOUCHPAD);
 
+	litest_add("touch:prediction", touch_prediction_config, LITEST_TOUCH, LITEST_TOUCHPAD);
+	litest_add("touch:prediction", touch_prediction_disabled, LITEST_TOUCH, LITEST_TOUCHPAD);
+	litest_add("touch:prediction", touch_prediction_motion, LITEST_TOUCH, LITEST_TOUCHPAD);
+
 	litest_add_for_device("touch:fuzz", touch_fuzz, LITEST_MULTITOUCH_FUZZ_SCREEN);
 }
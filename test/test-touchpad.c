@@ -65,6 +65,149 @@ START_TEST(touchpad_1fg_motion)
 }
 END_TEST
 
+START_TEST(touchpad_motion_smoothing_config)
+{
+	struct litest_device *dev = litest_current_device();
+	struct libinput_device *device = dev->libinput_device;
+	enum libinput_config_status status;
+	enum libinput_config_motion_smoothing_state state;
+
+	ck_assert(libinput_device_config_motion_smoothing_is_available(device));
+	state = libinput_device_config_motion_smoothing_get_enabled(device);
+	ck_assert_int_eq(state, LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED);
+	state = libinput_device_config_motion_smoothing_get_default_enabled(device);
+	ck_assert_int_eq(state, LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED);
+
+	status = libinput_device_config_motion_smoothing_set_enabled(device,
+				LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	state = libinput_device_config_motion_smoothing_get_enabled(device);
+	ck_assert_int_eq(state, LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED);
+
+	status = libinput_device_config_motion_smoothing_set_enabled(device,
+				LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+	state = libinput_device_config_motion_smoothing_get_enabled(device);
+	ck_assert_int_eq(state, LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED);
+
+	status = libinput_device_config_motion_smoothing_set_enabled(device, 3);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_INVALID);
+}
+END_TEST
+
+struct smoothing_result {
+	double dx, dy; /* total unaccelerated motion */
+	double variance; /* of the per-frame deltas during the slow move */
+};
+
+static void
+smoothing_frame_motion(struct libinput *li, double *dx, double *dy)
+{
+	struct libinput_event *event;
+	struct libinput_event_pointer *ptrev;
+
+	*dx = 0.0;
+	*dy = 0.0;
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		ptrev = litest_is_motion_event(event);
+		*dx += libinput_event_pointer_get_dx_unaccelerated(ptrev);
+		*dy += libinput_event_pointer_get_dy_unaccelerated(ptrev);
+		libinput_event_destroy(event);
+	}
+}
+
+/* A slow move to the right with 1mm of noise on the y axis, followed by
+ * a flick. The slow part sleeps between frames so the touch stays below
+ * TOUCHPAD_SMOOTHING_SLOW_SPEED however long a frame takes. The flick is
+ * sent without delay, its last frame is fast enough that the smoothed
+ * position catches up with the finger. */
+static void
+smoothing_replay(struct litest_device *dev,
+		 enum libinput_config_motion_smoothing_state state,
+		 double w, double h,
+		 struct smoothing_result *result)
+{
+	struct libinput *li = dev->libinput;
+	enum libinput_config_status status;
+	const int nframes = 15;
+	double x = 20, y = 50;
+	double dx, dy;
+	double sum_x = 0.0, sum_y = 0.0, sum_sq = 0.0;
+	int i;
+
+	status = libinput_device_config_motion_smoothing_set_enabled(
+				dev->libinput_device,
+				state);
+	ck_assert_int_eq(status, LIBINPUT_CONFIG_STATUS_SUCCESS);
+
+	memset(result, 0, sizeof(*result));
+	litest_drain_events(li);
+
+	litest_touch_down(dev, 0, x, y);
+	smoothing_frame_motion(li, &dx, &dy);
+
+	for (i = 1; i <= nframes; i++) {
+		/* 1mm per frame in x, the hysteresis eats 0.5mm of the
+		 * noise */
+		x += 100.0/w;
+		y = 50 + (i % 2 ? 100.0/h : -100.0/h);
+		msleep(40);
+		litest_touch_move(dev, 0, x, y);
+		smoothing_frame_motion(li, &dx, &dy);
+
+		result->dx += dx;
+		result->dy += dy;
+		sum_x += dx;
+		sum_y += dy;
+		sum_sq += dx * dx + dy * dy;
+	}
+
+	result->variance = sum_sq/nframes -
+			   (sum_x * sum_x + sum_y * sum_y)/(nframes * nframes);
+
+	litest_touch_move_to(dev, 0, x, y, x + 2000.0/w, 50, 4, 0);
+	smoothing_frame_motion(li, &dx, &dy);
+	result->dx += dx;
+	result->dy += dy;
+
+	litest_touch_up(dev, 0);
+	litest_drain_events(li);
+}
+
+START_TEST(touchpad_motion_smoothing_motion)
+{
+	struct litest_device *dev = litest_current_device();
+	struct smoothing_result off, on;
+	double w, h;
+
+	/* without a resolution there's no speed to pick the window by */
+	if (libinput_device_get_size(dev->libinput_device, &w, &h) != 0)
+		return;
+
+	litest_disable_tap(dev->libinput_device);
+
+	smoothing_replay(dev,
+			 LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED,
+			 w, h,
+			 &off);
+	smoothing_replay(dev,
+			 LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED,
+			 w, h,
+			 &on);
+
+	/* no motion is lost */
+	ck_assert_double_gt(off.dx, 0.0);
+	ck_assert_double_eq(on.dx, off.dx);
+	ck_assert_double_eq(on.dy, off.dy);
+
+	/* but the noise is smoothed out */
+	ck_assert_double_gt(off.variance, 0.0);
+	ck_assert_double_lt(on.variance, off.variance/2);
+}
+END_TEST
+
 START_TEST(touchpad_2fg_no_motion)
 {
 	struct litest_device *dev = litest_current_device();
@@ -2602,6 +2745,44 @@ START_TEST(touchpad_dwt)
 }
 END_TEST
 
+START_TEST(touchpad_dwt_keyboard_events_disabled)
+{
+	struct litest_device *touchpad = litest_current_device();
+	struct litest_device *keyboard;
+	struct libinput *li = touchpad->libinput;
+
+	if (!has_disable_while_typing(touchpad))
+		return;
+
+	keyboard = dwt_init_paired_keyboard(li, touchpad);
+	litest_disable_tap(touchpad->libinput_device);
+	litest_drain_events(li);
+
+	/* the caller doesn't see key events, dwt still does */
+	libinput_set_event_type_enabled(li, LIBINPUT_EVENT_KEYBOARD_KEY, 0);
+
+	litest_keyboard_key(keyboard, KEY_A, true);
+	litest_keyboard_key(keyboard, KEY_A, false);
+	libinput_dispatch(li);
+	litest_touch_down(touchpad, 0, 50, 50);
+	litest_touch_move_to(touchpad, 0, 50, 50, 70, 50, 10, 1);
+	litest_touch_up(touchpad, 0);
+
+	litest_assert_empty_queue(li);
+
+	litest_timeout_dwt_short();
+	libinput_dispatch(li);
+
+	litest_touch_down(touchpad, 0, 50, 50);
+	litest_touch_move_to(touchpad, 0, 50, 50, 70, 50, 10, 1);
+	litest_touch_up(touchpad, 0);
+
+	litest_assert_only_typed_events(li, LIBINPUT_EVENT_POINTER_MOTION);
+
+	litest_delete_device(keyboard);
+}
+END_TEST
+
 START_TEST(touchpad_dwt_update_keyboard)
 {
 	struct litest_device *touchpad = litest_current_device();
@@ -4947,6 +5128,8 @@ litest_setup_tests_touchpad(void)
 	struct range axis_range = {ABS_X, ABS_Y + 1};
 
 	litest_add("touchpad:motion", touchpad_1fg_motion, LITEST_TOUCHPAD, LITEST_ANY);
+	litest_add("touchpad:motion", touchpad_motion_smoothing_config, LITEST_TOUCHPAD, LITEST_ANY);
+	litest_add("touchpad:motion", touchpad_motion_smoothing_motion, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add("touchpad:motion", touchpad_2fg_no_motion, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH);
 
 	litest_add("touchpad:scroll", touchpad_2fg_scroll, LITEST_TOUCHPAD, LITEST_SINGLE_TOUCH|LITEST_SEMI_MT);
@@ -5025,6 +5208,7 @@ litest_setup_tests_touchpad(void)
 	litest_add_ranged("touchpad:state", touchpad_initial_state, LITEST_TOUCHPAD, LITEST_ANY, &axis_range);
 
 	litest_add("touchpad:dwt", touchpad_dwt, LITEST_TOUCHPAD, LITEST_ANY);
+	litest_add("touchpad:dwt", touchpad_dwt_keyboard_events_disabled, LITEST_TOUCHPAD, LITEST_ANY);
 	litest_add_for_device("touchpad:dwt", touchpad_dwt_update_keyboard, LITEST_SYNAPTICS_I2C);
 	litest_add_for_device("touchpad:dwt", touchpad_dwt_update_keyboard_with_state, LITEST_SYNAPTICS_I2C);
 	litest_add("touchpad:dwt", touchpad_dwt_enable_touch, LITEST_TOUCHPAD, LITEST_ANY);
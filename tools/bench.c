@@ -0,0 +1,159 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <libevdev/libevdev.h>
+
+#include "libinput-util.h"
+#include "bench.h"
+
+static int
+open_restricted(const char *path, int flags, void *user_data)
+{
+	int fd = open(path, flags);
+
+	return fd < 0 ? -errno : fd;
+}
+
+static void
+close_restricted(int fd, void *user_data)
+{
+	close(fd);
+}
+
+static const struct libinput_interface interface = {
+	.open_restricted = open_restricted,
+	.close_restricted = close_restricted,
+};
+
+struct libevdev_uinput *
+bench_create_touchpad(const char *name,
+		      unsigned int nslots,
+		      unsigned int width,
+		      unsigned int height,
+		      unsigned int resolution)
+{
+	struct libevdev *dev;
+	struct libevdev_uinput *uinput = NULL;
+	struct input_absinfo x = {
+		.minimum = 0,
+		.maximum = width * resolution,
+		.resolution = resolution,
+	};
+	struct input_absinfo y = {
+		.minimum = 0,
+		.maximum = height * resolution,
+		.resolution = resolution,
+	};
+	struct input_absinfo slot = {
+		.minimum = 0,
+		.maximum = nslots - 1,
+	};
+	struct input_absinfo tracking_id = {
+		.minimum = 0,
+		.maximum = 65535,
+	};
+	unsigned int tools[] = {
+		BTN_TOOL_FINGER,
+		BTN_TOOL_DOUBLETAP,
+		BTN_TOOL_TRIPLETAP,
+		BTN_TOOL_QUADTAP,
+		BTN_TOOL_QUINTTAP,
+	};
+	unsigned int i;
+	int rc;
+
+	dev = libevdev_new();
+	libevdev_set_name(dev, name);
+	libevdev_enable_property(dev, INPUT_PROP_POINTER);
+	libevdev_enable_property(dev, INPUT_PROP_BUTTONPAD);
+	libevdev_enable_event_code(dev, EV_ABS, ABS_X, &x);
+	libevdev_enable_event_code(dev, EV_ABS, ABS_Y, &y);
+	libevdev_enable_event_code(dev, EV_ABS, ABS_MT_SLOT, &slot);
+	libevdev_enable_event_code(dev, EV_ABS, ABS_MT_POSITION_X, &x);
+	libevdev_enable_event_code(dev, EV_ABS, ABS_MT_POSITION_Y, &y);
+	libevdev_enable_event_code(dev,
+				   EV_ABS,
+				   ABS_MT_TRACKING_ID,
+				   &tracking_id);
+	libevdev_enable_event_code(dev, EV_KEY, BTN_LEFT, NULL);
+	libevdev_enable_event_code(dev, EV_KEY, BTN_TOUCH, NULL);
+	for (i = 0; i < min(nslots, ARRAY_LENGTH(tools)); i++)
+		libevdev_enable_event_code(dev, EV_KEY, tools[i], NULL);
+
+	rc = libevdev_uinput_create_from_device(dev,
+						LIBEVDEV_UINPUT_OPEN_MANAGED,
+						&uinput);
+	if (rc != 0)
+		fprintf(stderr,
+			"Failed to create uinput device (%s)\n",
+			strerror(-rc));
+
+	libevdev_free(dev);
+
+	return uinput;
+}
+
+void
+bench_drain_events(struct libinput *li)
+{
+	struct libinput_event *event;
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li)))
+		libinput_event_destroy(event);
+}
+
+struct libinput *
+bench_create_context(struct libevdev_uinput *uinput,
+		     struct libinput_device **device)
+{
+	const char *devnode = libevdev_uinput_get_devnode(uinput);
+	struct libinput *li;
+	struct libinput_device *d;
+
+	li = libinput_path_create_context(&interface, NULL);
+	if (!li)
+		return NULL;
+
+	d = libinput_path_add_device(li, devnode);
+	if (!d) {
+		fprintf(stderr, "Failed to add %s\n", devnode);
+		libinput_unref(li);
+		return NULL;
+	}
+
+	bench_drain_events(li);
+
+	if (device)
+		*device = d;
+
+	return li;
+}
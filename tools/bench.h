@@ -0,0 +1,45 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <libevdev/libevdev-uinput.h>
+#include <libinput.h>
+
+/* A buttonpad with width × height mm at the given resolution in units/mm,
+ * with nslots touch slots and a BTN_TOOL_* for up to five fingers */
+struct libevdev_uinput *bench_create_touchpad(const char *name,
+					      unsigned int nslots,
+					      unsigned int width,
+					      unsigned int height,
+					      unsigned int resolution);
+
+/* A path context with the uinput device added and the device-added
+ * events drained. If device is not NULL, it is set to the device */
+struct libinput *bench_create_context(struct libevdev_uinput *uinput,
+				      struct libinput_device **device);
+
+void bench_drain_events(struct libinput *li);
+
+#endif
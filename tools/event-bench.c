@@ -0,0 +1,466 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libevdev/libevdev.h>
+#include <libevdev/libevdev-uinput.h>
+#include <libinput.h>
+
+#include "libinput-util.h"
+#include "bench.h"
+
+/* A frame is REL_X, REL_Y, REL_WHEEL and SYN_REPORT, the kernel buffers
+ * 64 events per client for a device like this */
+#define MAX_BURST 16
+/* The kernel buffers 8 frames per client for multitouch devices */
+#define MAX_TOUCHPAD_BURST 8
+
+struct bench_device {
+	const char *name;
+	unsigned int nslots; /* 0 for the mouse */
+};
+
+static const struct bench_device devices[] = {
+	{ "mouse", 0 },
+	{ "touchpad5", 5 },
+	{ "touchpad10", 10 },
+};
+
+struct result {
+	uint64_t duration;
+	uint64_t delivered;
+	uint64_t allocated;
+};
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct libevdev_uinput *
+create_mouse(void)
+{
+	struct libevdev *dev;
+	struct libevdev_uinput *uinput = NULL;
+	int rc;
+
+	dev = libevdev_new();
+	libevdev_set_name(dev, "libinput event-bench mouse");
+	libevdev_enable_event_code(dev, EV_REL, REL_X, NULL);
+	libevdev_enable_event_code(dev, EV_REL, REL_Y, NULL);
+	libevdev_enable_event_code(dev, EV_REL, REL_WHEEL, NULL);
+	libevdev_enable_event_code(dev, EV_KEY, BTN_LEFT, NULL);
+	libevdev_enable_event_code(dev, EV_KEY, BTN_RIGHT, NULL);
+	libevdev_enable_event_code(dev, EV_KEY, BTN_MIDDLE, NULL);
+
+	rc = libevdev_uinput_create_from_device(dev,
+						LIBEVDEV_UINPUT_OPEN_MANAGED,
+						&uinput);
+	if (rc != 0)
+		fprintf(stderr,
+			"Failed to create uinput device (%s)\n",
+			strerror(-rc));
+
+	libevdev_free(dev);
+
+	return uinput;
+}
+
+static void
+write_mouse_frame(struct libevdev_uinput *uinput, size_t frame)
+{
+	libevdev_uinput_write_event(uinput, EV_REL, REL_X, 1);
+	libevdev_uinput_write_event(uinput, EV_REL, REL_Y, -1);
+	if (frame % 8 == 0)
+		libevdev_uinput_write_event(uinput, EV_REL, REL_WHEEL, 1);
+	libevdev_uinput_write_event(uinput, EV_SYN, SYN_REPORT, 0);
+}
+
+static int
+touch_x(unsigned int slot)
+{
+	return 200 + slot * 350;
+}
+
+static int
+touch_y(size_t frame)
+{
+	return 500 + (frame % 256) * 8;
+}
+
+static void
+write_touchpad_tool(struct libevdev_uinput *uinput,
+		    unsigned int nfingers)
+{
+	unsigned int tools[] = {
+		BTN_TOOL_FINGER,
+		BTN_TOOL_DOUBLETAP,
+		BTN_TOOL_TRIPLETAP,
+		BTN_TOOL_QUADTAP,
+		BTN_TOOL_QUINTTAP,
+	};
+	unsigned int i;
+
+	/* the kernel stops at QUINTTAP for more than five fingers */
+	nfingers = min(nfingers, ARRAY_LENGTH(tools));
+
+	libevdev_uinput_write_event(uinput, EV_KEY, BTN_TOUCH, nfingers > 0);
+	for (i = 0; i < ARRAY_LENGTH(tools); i++)
+		libevdev_uinput_write_event(uinput,
+					    EV_KEY,
+					    tools[i],
+					    i + 1 == nfingers);
+}
+
+static void
+touchpad_down(struct libevdev_uinput *uinput, unsigned int nslots)
+{
+	unsigned int i;
+
+	for (i = 0; i < nslots; i++) {
+		libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_SLOT, i);
+		libevdev_uinput_write_event(uinput,
+					    EV_ABS,
+					    ABS_MT_TRACKING_ID,
+					    i);
+		libevdev_uinput_write_event(uinput,
+					    EV_ABS,
+					    ABS_MT_POSITION_X,
+					    touch_x(i));
+		libevdev_uinput_write_event(uinput,
+					    EV_ABS,
+					    ABS_MT_POSITION_Y,
+					    touch_y(0));
+	}
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_X, touch_x(0));
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_Y, touch_y(0));
+	write_touchpad_tool(uinput, nslots);
+	libevdev_uinput_write_event(uinput, EV_SYN, SYN_REPORT, 0);
+}
+
+static void
+touchpad_up(struct libevdev_uinput *uinput, unsigned int nslots)
+{
+	unsigned int i;
+
+	for (i = 0; i < nslots; i++) {
+		libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_SLOT, i);
+		libevdev_uinput_write_event(uinput,
+					    EV_ABS,
+					    ABS_MT_TRACKING_ID,
+					    -1);
+	}
+	write_touchpad_tool(uinput, 0);
+	libevdev_uinput_write_event(uinput, EV_SYN, SYN_REPORT, 0);
+}
+
+static void
+write_touchpad_frame(struct libevdev_uinput *uinput,
+		     unsigned int nslots,
+		     size_t frame)
+{
+	unsigned int i;
+
+	/* every touch moves in every frame */
+	for (i = 0; i < nslots; i++) {
+		libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_SLOT, i);
+		libevdev_uinput_write_event(uinput,
+					    EV_ABS,
+					    ABS_MT_POSITION_Y,
+					    touch_y(frame));
+	}
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_Y, touch_y(frame));
+	libevdev_uinput_write_event(uinput, EV_SYN, SYN_REPORT, 0);
+}
+
+static uint64_t
+pool_allocations(struct libinput *li)
+{
+	return libinput_get_statistic(li, LIBINPUT_STATISTIC_EVENT_POOL_HITS) +
+	       libinput_get_statistic(li, LIBINPUT_STATISTIC_EVENT_POOL_MISSES);
+}
+
+static bool
+run_benchmark(struct libevdev_uinput *uinput,
+	      const struct bench_device *device,
+	      const enum libinput_event_type *disabled,
+	      size_t ndisabled,
+	      size_t nframes,
+	      size_t burst,
+	      struct result *result)
+{
+	struct libinput *li;
+	struct libinput_event *event;
+	uint64_t start, allocated;
+	size_t i, j;
+
+	li = bench_create_context(uinput, NULL);
+	if (!li)
+		return false;
+
+	for (i = 0; i < ndisabled; i++)
+		libinput_set_event_type_enabled(li, disabled[i], 0);
+
+	if (device->nslots > 0) {
+		touchpad_down(uinput, device->nslots);
+		bench_drain_events(li);
+	}
+
+	memset(result, 0, sizeof(*result));
+	allocated = pool_allocations(li);
+
+	for (i = 0; i < nframes; i += burst) {
+		/* only the libinput side is timed, not the uinput writes */
+		for (j = 0; j < burst; j++) {
+			if (device->nslots > 0)
+				write_touchpad_frame(uinput,
+						     device->nslots,
+						     i + j);
+			else
+				write_mouse_frame(uinput, i + j);
+		}
+
+		start = now_ns();
+		libinput_dispatch(li);
+		while ((event = libinput_get_event(li))) {
+			result->delivered++;
+			libinput_event_destroy(event);
+		}
+		result->duration += now_ns() - start;
+	}
+
+	result->allocated = pool_allocations(li) - allocated;
+
+	if (device->nslots > 0) {
+		touchpad_up(uinput, device->nslots);
+		bench_drain_events(li);
+	}
+
+	libinput_unref(li);
+
+	return true;
+}
+
+static bool
+parse_event_type(const char *name, enum libinput_event_type *type)
+{
+	if (streq(name, "motion"))
+		*type = LIBINPUT_EVENT_POINTER_MOTION;
+	else if (streq(name, "button"))
+		*type = LIBINPUT_EVENT_POINTER_BUTTON;
+	else if (streq(name, "axis"))
+		*type = LIBINPUT_EVENT_POINTER_AXIS;
+	else
+		return false;
+
+	return true;
+}
+
+static const struct bench_device *
+parse_device(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < ARRAY_LENGTH(devices); i++) {
+		if (streq(name, devices[i].name))
+			return &devices[i];
+	}
+
+	return NULL;
+}
+
+static void
+print_result(const char *name, size_t nframes, const struct result *r)
+{
+	printf("%-18s %10zu %10.2f %10" PRIu64 " %10" PRIu64 "\n",
+	       name,
+	       nframes,
+	       (double)r->duration/nframes,
+	       r->delivered,
+	       r->allocated);
+}
+
+static void
+usage(void)
+{
+	printf("Usage: %s [options]\n", program_invocation_short_name);
+	printf("\n"
+	       "Replays mouse or touchpad events through a uinput device and\n"
+	       "compares the time libinput spends per frame with all event types\n"
+	       "enabled and with some event types disabled through\n"
+	       "libinput_set_event_type_enabled().\n"
+	       "The touchpad devices put all fingers down and move every touch\n"
+	       "in every frame.\n"
+	       "This tool needs permission to create uinput devices.\n"
+	       "\n"
+	       "Options:\n"
+	       "--device=<mouse|touchpad5|touchpad10>\n"
+	       "	device to replay events on (default: mouse)\n"
+	       "--disable=<motion|button|axis>\n"
+	       "	event type to disable, may be given multiple times\n"
+	       "	(default: motion)\n"
+	       "--nframes=<int>	... number of frames to replay (default: 100000)\n"
+	       "--burst=<int>	... frames written before each libinput_dispatch()\n"
+	       "		    (default: 8, max: %d, %d for touchpads)\n",
+	       MAX_BURST,
+	       MAX_TOUCHPAD_BURST);
+}
+
+int
+main(int argc, char **argv)
+{
+	enum libinput_event_type disabled[3];
+	size_t ndisabled = 0;
+	size_t nframes = 100000;
+	size_t burst = 8;
+	const struct bench_device *device = &devices[0];
+	struct libevdev_uinput *uinput;
+	struct result all, subscribed;
+	int rc = 1;
+
+	enum {
+		OPT_HELP = 1,
+		OPT_DISABLE,
+		OPT_NFRAMES,
+		OPT_BURST,
+		OPT_DEVICE,
+	};
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		static struct option long_options[] = {
+			{"help", 0, 0, OPT_HELP },
+			{"disable", 1, 0, OPT_DISABLE },
+			{"nframes", 1, 0, OPT_NFRAMES },
+			{"burst", 1, 0, OPT_BURST },
+			{"device", 1, 0, OPT_DEVICE },
+			{0, 0, 0, 0}
+		};
+
+		c = getopt_long(argc, argv, "",
+				long_options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case OPT_HELP:
+			usage();
+			exit(0);
+			break;
+		case OPT_DISABLE:
+			if (ndisabled == ARRAY_LENGTH(disabled) ||
+			    !parse_event_type(optarg,
+					      &disabled[ndisabled])) {
+				usage();
+				return 1;
+			}
+			ndisabled++;
+			break;
+		case OPT_NFRAMES:
+			nframes = strtoul(optarg, NULL, 10);
+			if (nframes == 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case OPT_BURST:
+			burst = strtoul(optarg, NULL, 10);
+			if (burst == 0 || burst > MAX_BURST) {
+				usage();
+				return 1;
+			}
+			break;
+		case OPT_DEVICE:
+			device = parse_device(optarg);
+			if (!device) {
+				usage();
+				return 1;
+			}
+			break;
+		default:
+			usage();
+			exit(1);
+			break;
+		}
+	}
+
+	if (ndisabled == 0)
+		disabled[ndisabled++] = LIBINPUT_EVENT_POINTER_MOTION;
+
+	if (device->nslots > 0 && burst > MAX_TOUCHPAD_BURST) {
+		usage();
+		return 1;
+	}
+
+	/* every burst is replayed in full */
+	nframes = (nframes + burst - 1) / burst * burst;
+
+	if (device->nslots > 0)
+		uinput = bench_create_touchpad("libinput event-bench touchpad",
+					       device->nslots,
+					       100, 75, 40);
+	else
+		uinput = create_mouse();
+	if (!uinput)
+		return 1;
+
+	/* let udev pick up the device before libinput opens it */
+	usleep(100000);
+
+	if (!run_benchmark(uinput, device, NULL, 0, nframes, burst, &all) ||
+	    !run_benchmark(uinput, device, disabled, ndisabled, nframes, burst,
+			   &subscribed))
+		goto out;
+
+	printf("# %s, %zu frames, %zu frames per dispatch\n",
+	       device->name,
+	       nframes,
+	       burst);
+	printf("%-18s %10s %10s %10s %10s\n",
+	       "# event types", "frames", "ns/frame", "delivered", "allocated");
+	print_result("all", nframes, &all);
+	print_result("subscribed", nframes, &subscribed);
+
+	rc = 0;
+out:
+	libevdev_uinput_destroy(uinput);
+
+	return rc;
+}
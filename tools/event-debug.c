@@ -734,6 +734,66 @@ print_switch_event(struct libinput_event *ev)
 	printf("switch %s state %d\n", which, state);
 }
 
+static void
+print_latency_histogram(struct libinput_device *dev,
+			enum libinput_latency_stage stage,
+			const char *name)
+{
+	uint64_t buckets[32];
+	size_t nbuckets = sizeof(buckets)/sizeof(buckets[0]);
+	size_t i, last = 0;
+	uint64_t total = 0;
+
+	nbuckets = libinput_device_get_latency_histogram(dev,
+							 stage,
+							 buckets,
+							 nbuckets);
+	for (i = 0; i < nbuckets; i++) {
+		total += buckets[i];
+		if (buckets[i])
+			last = i;
+	}
+
+	printf("  %-18s", name);
+	if (total == 0) {
+		printf(" no samples\n");
+		return;
+	}
+
+	printf(" %" PRIu64 " samples\n", total);
+	for (i = 0; i <= last; i++) {
+		if (i == nbuckets - 1)
+			printf("    >= %8uus", 1U << i);
+		else
+			printf("    <  %8uus", 2U << i);
+		printf(" %10" PRIu64 " (%5.1f%%)\n",
+		       buckets[i],
+		       100.0 * buckets[i]/total);
+	}
+}
+
+static void
+handle_latency_tracking(struct libinput_event *ev)
+{
+	struct libinput_device *dev = libinput_event_get_device(ev);
+
+	if (libinput_event_get_type(ev) == LIBINPUT_EVENT_DEVICE_ADDED) {
+		libinput_device_set_latency_tracking(dev, 1);
+		return;
+	}
+
+	printf("Latency for %s:\n", libinput_device_get_name(dev));
+	print_latency_histogram(dev,
+				LIBINPUT_LATENCY_KERNEL_TO_READ,
+				"kernel to read");
+	print_latency_histogram(dev,
+				LIBINPUT_LATENCY_READ_TO_QUEUED,
+				"read to queued");
+	print_latency_histogram(dev,
+				LIBINPUT_LATENCY_QUEUED_TO_DEQUEUED,
+				"queued to dequeued");
+}
+
 static int
 handle_and_print_events(struct libinput *li)
 {
@@ -752,6 +812,8 @@ handle_and_print_events(struct libinput *li)
 			print_device_notify(ev);
 			tools_device_apply_config(libinput_event_get_device(ev),
 						  &context.options);
+			if (context.options.show_latency)
+				handle_latency_tracking(ev);
 			break;
 		case LIBINPUT_EVENT_KEYBOARD_KEY:
 			print_key_event(ev);
@@ -889,6 +951,12 @@ main(int argc, char **argv)
 
 	mainloop(li);
 
+	/* removing the devices prints their latency */
+	if (context.options.show_latency) {
+		libinput_suspend(li);
+		handle_and_print_events(li);
+	}
+
 	libinput_unref(li);
 
 	return 0;
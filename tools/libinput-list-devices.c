@@ -226,6 +226,34 @@ dwt_default(struct libinput_device *device)
 		return "disabled";
 }
 
+static const char *
+motion_smoothing_default(struct libinput_device *device)
+{
+	if (!libinput_device_config_motion_smoothing_is_available(device))
+		return "n/a";
+
+	if (libinput_device_config_motion_smoothing_get_default_enabled(device))
+		return "enabled";
+	else
+		return "disabled";
+}
+
+static char *
+prediction_default(struct libinput_device *device)
+{
+	char *str;
+	unsigned int lookahead;
+
+	if (!libinput_device_config_prediction_is_available(device)) {
+		xasprintf(&str, "n/a");
+		return str;
+	}
+
+	lookahead = libinput_device_config_prediction_get_default_lookahead(device);
+	xasprintf(&str, "%ums", lookahead);
+	return str;
+}
+
 static char *
 rotation_default(struct libinput_device *device)
 {
@@ -337,6 +365,12 @@ print_device_notify(struct libinput_event *ev)
 	printf("Rotation:         %s\n", str);
 	free(str);
 
+	printf("Motion smoothing: %s\n", motion_smoothing_default(dev));
+
+	str = prediction_default(dev);
+	printf("Prediction:       %s\n", str);
+	free(str);
+
 	if (libinput_device_has_capability(dev,
 					   LIBINPUT_DEVICE_CAP_TABLET_PAD))
 		print_pad_info(dev);
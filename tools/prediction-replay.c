@@ -0,0 +1,426 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/* Replays the first touch of evemu recordings through the motion predictor
+ * and scores the predicted positions against where the touch actually was
+ * one look-ahead later. Without a recording, a synthetic trace is scored.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "linux/input.h"
+#include "libinput-util.h"
+
+#define MAX_LOOKAHEADS 16
+
+static const unsigned int default_lookaheads[] = { 4, 8, 16, 24, 32 };
+
+struct sample {
+	uint64_t time;
+	double x, y; /* mm */
+	unsigned int sequence; /* touch down to touch up */
+};
+
+struct trace {
+	struct sample *samples;
+	size_t nsamples;
+	size_t size;
+	unsigned int nsequences;
+};
+
+struct score {
+	unsigned int count;
+	double sum_sq; /* mm² */
+	double max; /* mm */
+	double sum_sq_unpredicted; /* mm² */
+};
+
+static void
+trace_append(struct trace *trace,
+	     uint64_t time,
+	     double x,
+	     double y)
+{
+	struct sample *s;
+
+	if (trace->nsamples == trace->size) {
+		trace->size = trace->size ? trace->size * 2 : 1024;
+		trace->samples = realloc(trace->samples,
+					 trace->size * sizeof(*s));
+		if (!trace->samples) {
+			fprintf(stderr, "Out of memory\n");
+			exit(1);
+		}
+	}
+
+	s = &trace->samples[trace->nsamples++];
+	s->time = time;
+	s->x = x;
+	s->y = y;
+	s->sequence = trace->nsequences;
+}
+
+/* Fills the trace with slot 0 of an evemu recording, or ABS_X/ABS_Y if
+ * the device is not multitouch. Returns 0 on success or a negative errno */
+static int
+trace_load_evemu(struct trace *trace, const char *path)
+{
+	FILE *fp;
+	char line[512];
+	unsigned long sec, usec;
+	unsigned int type, code, fuzz, flat;
+	int value, min, max, resolution;
+	double res[2] = { 1.0, 1.0 }; /* units/mm */
+	int x = 0, y = 0, slot = 0;
+	bool is_mt = false, down = false, changed = false;
+
+	fp = fopen(path, "r");
+	if (!fp)
+		return -errno;
+
+	while (fgets(line, sizeof(line), fp)) {
+		/* A: <code> <min> <max> <fuzz> <flat> <resolution> */
+		if (sscanf(line, "A: %x %d %d %u %u %d",
+			   &code, &min, &max, &fuzz, &flat, &resolution) == 6) {
+			if (code == ABS_MT_POSITION_X ||
+			    code == ABS_MT_POSITION_Y)
+				is_mt = true;
+			if (resolution <= 0)
+				continue;
+			if (code == ABS_MT_POSITION_X || code == ABS_X)
+				res[0] = resolution;
+			else if (code == ABS_MT_POSITION_Y || code == ABS_Y)
+				res[1] = resolution;
+			continue;
+		}
+
+		/* E: <sec>.<usec> <type> <code> <value> */
+		if (sscanf(line, "E: %lu.%lu %x %x %d",
+			   &sec, &usec, &type, &code, &value) != 5)
+			continue;
+
+		if (type == EV_SYN && code == SYN_REPORT) {
+			if (down && changed)
+				trace_append(trace,
+					     s2us(sec) + usec,
+					     x / res[0],
+					     y / res[1]);
+			changed = false;
+			continue;
+		}
+
+		if (is_mt && type == EV_ABS) {
+			switch (code) {
+			case ABS_MT_SLOT:
+				slot = value;
+				break;
+			case ABS_MT_TRACKING_ID:
+				if (slot != 0)
+					break;
+				if (value == -1 && down)
+					trace->nsequences++;
+				down = value != -1;
+				break;
+			case ABS_MT_POSITION_X:
+				if (slot == 0) {
+					x = value;
+					changed = true;
+				}
+				break;
+			case ABS_MT_POSITION_Y:
+				if (slot == 0) {
+					y = value;
+					changed = true;
+				}
+				break;
+			}
+		} else if (!is_mt && type == EV_ABS) {
+			if (code == ABS_X) {
+				x = value;
+				changed = true;
+			} else if (code == ABS_Y) {
+				y = value;
+				changed = true;
+			}
+		} else if (!is_mt && type == EV_KEY && code == BTN_TOUCH) {
+			if (value == 0 && down)
+				trace->nsequences++;
+			down = value != 0;
+		}
+	}
+
+	if (down)
+		trace->nsequences++;
+
+	fclose(fp);
+
+	return 0;
+}
+
+/* A finger drawing circles of 20mm radius once per second, then flicking
+ * to the side and stopping, reported every 8ms with up to 0.1mm of noise */
+static void
+trace_load_synthetic(struct trace *trace)
+{
+	uint64_t time = 0;
+	double x, y, noise;
+	int i;
+
+	srand(0);
+
+	for (i = 0; i < 250; i++) {
+		time += ms2us(8);
+		noise = 0.1 * (2.0 * rand() / RAND_MAX - 1.0);
+		x = 50 + 20 * cos(2 * M_PI * time / 1e6) + noise;
+		y = 50 + 20 * sin(2 * M_PI * time / 1e6) + noise;
+		trace_append(trace, time, x, y);
+	}
+	trace->nsequences++;
+
+	time += ms2us(200);
+	for (i = 0; i < 40; i++) {
+		time += ms2us(8);
+		/* decelerating from 500mm/s */
+		x = 20 + 60 * (1 - exp(-i / 15.0));
+		y = 50;
+		trace_append(trace, time, x, y);
+	}
+	trace->nsequences++;
+}
+
+/* Where the touch was at the given time, linearly interpolated between the
+ * samples of its sequence. Returns false if the sequence ended before */
+static bool
+trace_position_at(const struct trace *trace,
+		  size_t idx,
+		  uint64_t time,
+		  double *x,
+		  double *y)
+{
+	const struct sample *a, *b;
+	double f;
+
+	for (; idx + 1 < trace->nsamples; idx++) {
+		a = &trace->samples[idx];
+		b = &trace->samples[idx + 1];
+
+		if (b->sequence != a->sequence)
+			return false;
+
+		if (b->time >= time && b->time > a->time) {
+			f = (double)(time - a->time)/(b->time - a->time);
+			*x = a->x + (b->x - a->x) * f;
+			*y = a->y + (b->y - a->y) * f;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void
+score_trace(const struct trace *trace,
+	    unsigned int lookahead,
+	    struct score *score)
+{
+	struct motion_predictor predictor;
+	const struct sample *s;
+	double px, py, tx, ty, err;
+	size_t i;
+
+	memset(score, 0, sizeof(*score));
+
+	for (i = 0; i < trace->nsamples; i++) {
+		s = &trace->samples[i];
+
+		if (i == 0 || s->sequence != trace->samples[i - 1].sequence)
+			motion_predictor_reset(&predictor);
+
+		motion_predictor_update(&predictor, s->time, s->x, s->y);
+		motion_predictor_predict(&predictor,
+					 ms2us(lookahead),
+					 &px, &py);
+
+		if (!trace_position_at(trace,
+				       i,
+				       s->time + ms2us(lookahead),
+				       &tx, &ty))
+			continue;
+
+		err = hypot(px - tx, py - ty);
+		score->count++;
+		score->sum_sq += err * err;
+		score->max = max(score->max, err);
+
+		err = hypot(s->x - tx, s->y - ty);
+		score->sum_sq_unpredicted += err * err;
+	}
+}
+
+static void
+usage(void)
+{
+	printf("Usage: %s [--lookahead=ms[,ms...]] [recording.evemu ...]\n"
+	       "\n"
+	       "Replays the first touch of each evemu recording through the\n"
+	       "motion predictor and prints the rms and maximum distance\n"
+	       "between the predicted position and where the touch was one\n"
+	       "look-ahead later. The rms distance without prediction is the\n"
+	       "error the prediction has to beat.\n"
+	       "Without a recording, a synthetic trace is used.\n",
+	       program_invocation_short_name);
+}
+
+static int
+parse_lookaheads(const char *arg,
+		 unsigned int *lookaheads,
+		 size_t *nlookaheads)
+{
+	char **strv, **s;
+	int ms;
+
+	strv = strv_from_string(arg, ",");
+	if (!strv)
+		return -EINVAL;
+
+	*nlookaheads = 0;
+	for (s = strv; *s && *nlookaheads < MAX_LOOKAHEADS; s++) {
+		if (!safe_atoi(*s, &ms) || ms < 0) {
+			strv_free(strv);
+			return -EINVAL;
+		}
+		lookaheads[(*nlookaheads)++] = ms;
+	}
+	strv_free(strv);
+
+	return *nlookaheads > 0 ? 0 : -EINVAL;
+}
+
+static void
+print_scores(const char *name,
+	     const struct trace *trace,
+	     const unsigned int *lookaheads,
+	     size_t nlookaheads)
+{
+	struct score score;
+	size_t i;
+
+	printf("%s: %u touch sequences, %zd samples\n",
+	       name,
+	       trace->nsequences,
+	       trace->nsamples);
+	printf("  lookahead  rms error  max error  rms unpredicted\n");
+
+	for (i = 0; i < nlookaheads; i++) {
+		score_trace(trace, lookaheads[i], &score);
+		if (score.count == 0) {
+			printf("  %7ums  (trace too short)\n", lookaheads[i]);
+			continue;
+		}
+
+		printf("  %7ums  %7.2fmm  %7.2fmm  %13.2fmm\n",
+		       lookaheads[i],
+		       sqrt(score.sum_sq/score.count),
+		       score.max,
+		       sqrt(score.sum_sq_unpredicted/score.count));
+	}
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned int lookaheads[MAX_LOOKAHEADS];
+	size_t nlookaheads = ARRAY_LENGTH(default_lookaheads);
+	struct trace trace;
+	int i, rc;
+
+	memcpy(lookaheads, default_lookaheads, sizeof(default_lookaheads));
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		enum {
+			OPT_LOOKAHEAD = 1,
+		};
+		static struct option opts[] = {
+			{ "lookahead", 1, 0, OPT_LOOKAHEAD },
+			{ "help", 0, 0, 'h' },
+			{ 0, 0, 0, 0 },
+		};
+
+		c = getopt_long(argc, argv, "h", opts, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'h':
+			usage();
+			return 0;
+		case OPT_LOOKAHEAD:
+			if (parse_lookaheads(optarg,
+					     lookaheads,
+					     &nlookaheads) != 0) {
+				fprintf(stderr,
+					"Invalid look-ahead list '%s'\n",
+					optarg);
+				return 1;
+			}
+			break;
+		default:
+			usage();
+			return 1;
+		}
+	}
+
+	if (optind >= argc) {
+		memset(&trace, 0, sizeof(trace));
+		trace_load_synthetic(&trace);
+		print_scores("synthetic", &trace, lookaheads, nlookaheads);
+		free(trace.samples);
+		return 0;
+	}
+
+	for (i = optind; i < argc; i++) {
+		memset(&trace, 0, sizeof(trace));
+		rc = trace_load_evemu(&trace, argv[i]);
+		if (rc != 0) {
+			fprintf(stderr,
+				"Failed to read %s: %s\n",
+				argv[i],
+				strerror(-rc));
+			return 1;
+		}
+		print_scores(argv[i], &trace, lookaheads, nlookaheads);
+		free(trace.samples);
+	}
+
+	return 0;
+}
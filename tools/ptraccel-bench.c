@@ -0,0 +1,645 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <assert.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "filter.h"
+#include "libinput-util.h"
+#include "libinput-private.h"
+
+struct motion {
+	struct device_float_coords delta;
+	uint64_t interval; /* us since the previous event */
+};
+
+struct stream {
+	struct motion *motions;
+	size_t nmotions;
+};
+
+/* The number of allocations is counted by wrapping the allocator, this
+ * only works with glibc */
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static bool count_allocations = false;
+static uint64_t nallocations = 0;
+
+void *
+malloc(size_t size)
+{
+	if (count_allocations)
+		nallocations++;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(size_t nmemb, size_t size)
+{
+	if (count_allocations)
+		nallocations++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *
+realloc(void *ptr, size_t size)
+{
+	if (count_allocations)
+		nallocations++;
+	return __libc_realloc(ptr, size);
+}
+#define HAVE_ALLOCATION_COUNT 1
+#else
+static bool count_allocations = false;
+static uint64_t nallocations = 0;
+#define HAVE_ALLOCATION_COUNT 0
+#endif
+
+static void
+stream_add(struct stream *stream,
+	   double dx,
+	   double dy,
+	   uint64_t interval,
+	   size_t *size)
+{
+	struct motion *m;
+
+	if (stream->nmotions == *size) {
+		*size = *size ? *size * 2 : 1024;
+		stream->motions = realloc(stream->motions,
+					  *size * sizeof *stream->motions);
+		if (!stream->motions)
+			abort();
+	}
+
+	m = &stream->motions[stream->nmotions++];
+	m->delta.x = dx;
+	m->delta.y = dy;
+	m->interval = interval;
+}
+
+/* deterministic so the output is comparable across runs */
+static double
+next_random(uint32_t *seed)
+{
+	*seed = *seed * 1103515245 + 12345;
+	return ((*seed >> 16) & 0x7fff) / 32768.0;
+}
+
+static bool
+stream_create_synthetic(struct stream *stream,
+			const char *pattern,
+			size_t nmotions,
+			uint64_t interval)
+{
+	uint32_t seed = 1;
+	size_t size = 0;
+	size_t i;
+	double dx, dy;
+
+	for (i = 0; i < nmotions; i++) {
+		if (streq(pattern, "sweep")) {
+			/* slow to fast and back again */
+			dx = (i % 200) < 100 ? (i % 100) * 0.5 :
+					       (100 - i % 100) * 0.5;
+			dy = dx / 2;
+		} else if (streq(pattern, "random")) {
+			dx = next_random(&seed) * 40 - 20;
+			dy = next_random(&seed) * 40 - 20;
+		} else if (streq(pattern, "constant")) {
+			dx = 5;
+			dy = 0;
+		} else {
+			return false;
+		}
+
+		stream_add(stream, dx, dy, interval, &size);
+	}
+
+	return true;
+}
+
+/* Reads lines of "dx [dy [interval-in-us]]" */
+static bool
+stream_read(struct stream *stream, FILE *fp, uint64_t interval)
+{
+	char line[256];
+	size_t size = 0;
+
+	while (fgets(line, sizeof(line), fp)) {
+		double dx = 0, dy = 0;
+		unsigned long long dt = interval;
+		int n;
+
+		if (line[0] == '#')
+			continue;
+
+		n = sscanf(line, "%lf %lf %llu", &dx, &dy, &dt);
+		if (n < 1)
+			continue;
+
+		stream_add(stream, dx, dy, dt, &size);
+	}
+
+	return stream->nmotions > 0;
+}
+
+/* Compares the output against the lines for this filter in a file written
+ * with --save, returns the largest error relative to the reference value,
+ * or absolute for reference values below 1. */
+static bool
+compare_output(FILE *fp,
+	       const char *name,
+	       const struct normalized_coords *output,
+	       size_t noutput,
+	       double *max_error)
+{
+	char line[256];
+	char filter[64];
+	double error;
+	size_t i = 0;
+
+	*max_error = 0.0;
+	rewind(fp);
+
+	while (fgets(line, sizeof(line), fp)) {
+		struct normalized_coords ref;
+
+		if (sscanf(line, "%63s %lf %lf", filter, &ref.x, &ref.y) != 3 ||
+		    !streq(filter, name))
+			continue;
+
+		if (i == noutput)
+			return false;
+
+		error = fabs(output[i].x - ref.x)/max(1.0, fabs(ref.x));
+		*max_error = max(*max_error, error);
+		error = fabs(output[i].y - ref.y)/max(1.0, fabs(ref.y));
+		*max_error = max(*max_error, error);
+		i++;
+	}
+
+	return i == noutput;
+}
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static struct motion_filter *
+create_filter(const char *name, int dpi)
+{
+	if (streq(name, "linear"))
+		return create_pointer_accelerator_filter_linear(dpi);
+	else if (streq(name, "low-dpi"))
+		return create_pointer_accelerator_filter_linear_low_dpi(dpi);
+	else if (streq(name, "touchpad"))
+		return create_pointer_accelerator_filter_touchpad(dpi);
+	else if (streq(name, "x230"))
+		return create_pointer_accelerator_filter_lenovo_x230(dpi);
+	else if (streq(name, "trackpoint"))
+		return create_pointer_accelerator_filter_trackpoint(dpi);
+	else if (streq(name, "flat"))
+		return create_pointer_accelerator_filter_flat(dpi);
+	else if (streq(name, "tablet"))
+		return create_pointer_accelerator_filter_tablet(dpi, dpi);
+
+	return NULL;
+}
+
+static bool
+run_benchmark(const char *name,
+	      const struct stream *stream,
+	      size_t nevents,
+	      size_t batch,
+	      int dpi,
+	      double speed,
+	      FILE *save,
+	      FILE *compare,
+	      double tolerance)
+{
+	struct motion_filter *filter;
+	struct normalized_coords accel;
+	struct device_float_coords *deltas = NULL;
+	struct normalized_coords *accelerated = NULL;
+	struct normalized_coords *output = NULL;
+	uint64_t *times = NULL;
+	size_t n, j;
+	/* the tablet filter looks at the tool type */
+	struct libinput_tablet_tool tool = {
+		.type = LIBINPUT_TABLET_TOOL_TYPE_PEN,
+	};
+	uint64_t time = 0;
+	uint64_t start, duration;
+	double max_error;
+	bool rc = true;
+	size_t i;
+
+	filter = create_filter(name, dpi);
+	if (!filter) {
+		fprintf(stderr, "Invalid filter type %s\n", name);
+		return false;
+	}
+
+	filter_set_speed(filter, speed);
+
+	if (batch > 0) {
+		deltas = zalloc(batch * sizeof *deltas);
+		accelerated = zalloc(batch * sizeof *accelerated);
+		times = zalloc(batch * sizeof *times);
+		if (!deltas || !accelerated || !times) {
+			fprintf(stderr, "Failed to allocate batch buffers\n");
+			filter_destroy(filter);
+			free(deltas);
+			free(accelerated);
+			free(times);
+			return false;
+		}
+	}
+
+	if (save || compare) {
+		output = zalloc(nevents * sizeof *output);
+		if (!output) {
+			fprintf(stderr, "Failed to allocate output buffer\n");
+			filter_destroy(filter);
+			free(deltas);
+			free(accelerated);
+			free(times);
+			return false;
+		}
+	}
+
+	nallocations = 0;
+	count_allocations = true;
+	start = now_ns();
+
+	for (i = 0; batch == 0 && i < nevents; i++) {
+		const struct motion *m = &stream->motions[i % stream->nmotions];
+
+		time += m->interval;
+		accel = filter_dispatch(filter, &m->delta, &tool, time);
+		if (output)
+			output[i] = accel;
+	}
+
+	for (i = 0; batch > 0 && i < nevents; i += n) {
+		n = min(batch, nevents - i);
+
+		for (j = 0; j < n; j++) {
+			const struct motion *m =
+				&stream->motions[(i + j) % stream->nmotions];
+
+			time += m->interval;
+			deltas[j] = m->delta;
+			times[j] = time;
+		}
+
+		filter_dispatch_batch(filter,
+				      deltas,
+				      times,
+				      accelerated,
+				      n,
+				      &tool);
+
+		if (output)
+			memcpy(&output[i], accelerated, n * sizeof *output);
+	}
+
+	duration = now_ns() - start;
+	count_allocations = false;
+
+	printf("%-12s %10zu %10.2f ",
+	       name,
+	       nevents,
+	       (double)duration/nevents);
+	if (HAVE_ALLOCATION_COUNT)
+		printf("%8" PRIu64 " ", nallocations);
+	else
+		printf("%8s ", "n/a");
+
+	if (compare) {
+		if (!compare_output(compare, name, output, nevents,
+				    &max_error)) {
+			printf("no reference\n");
+			rc = false;
+		} else {
+			printf("%.3g%s\n",
+			       max_error,
+			       max_error > tolerance ? " FAIL" : "");
+			rc = max_error <= tolerance;
+		}
+	} else {
+		printf("-\n");
+	}
+
+	for (i = 0; save && i < nevents; i++)
+		fprintf(save,
+			"%s %.17g %.17g\n",
+			name,
+			output[i].x,
+			output[i].y);
+
+	filter_destroy(filter);
+	free(deltas);
+	free(accelerated);
+	free(times);
+	free(output);
+
+	return rc;
+}
+
+static void
+usage(void)
+{
+	printf("Usage: %s [options]\n", program_invocation_short_name);
+	printf("\n"
+	       "Replays a motion stream through the pointer acceleration filters and\n"
+	       "prints the time per event and the number of allocations during the\n"
+	       "replay.\n"
+	       "\n"
+	       "Options:\n"
+	       "--filter=<all|linear|low-dpi|touchpad|x230|trackpoint|flat|tablet>\n"
+	       "	filter to benchmark, may be given multiple times (default: all)\n"
+	       "--pattern=<sweep|random|constant>\n"
+	       "	synthetic motion stream to replay (default: sweep)\n"
+	       "--file=<path>	... read the motion stream from a file instead,\n"
+	       "		    - for stdin\n"
+	       "--nevents=<int>	... number of events to replay (default: 1000000)\n"
+	       "--rate=<int>	... event rate in Hz (default: 125)\n"
+	       "--speed=<double>  ... accel speed [-1, 1], default 0\n"
+	       "--dpi=<int>	... device resolution in DPI (default: 1000)\n"
+	       "--batch=<int>	... pass this many events at a time to\n"
+	       "		    filter_dispatch_batch() (default: 0, one\n"
+	       "		    filter_dispatch() call per event)\n"
+	       "--save=<path>	... write the accelerated deltas to a file\n"
+	       "--compare=<path>  ... compare the accelerated deltas to a file\n"
+	       "		    written with --save and print the largest\n"
+	       "		    relative error\n"
+	       "--tolerance=<double> ... largest relative error --compare\n"
+	       "		    accepts (default: 1e-9)\n"
+	       "\n"
+	       "In a motion stream file, each line is \"dx [dy [interval]]\"\n"
+	       "with the deltas in device units and the interval to the previous\n"
+	       "event in microseconds.\n"
+	       "The stream is repeated until nevents events have been replayed.\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	static const char *all_filters[] = {
+		"linear",
+		"low-dpi",
+		"touchpad",
+		"x230",
+		"trackpoint",
+		"flat",
+		"tablet",
+	};
+	const char *filters[ARRAY_LENGTH(all_filters)];
+	size_t nfilters = 0;
+	const char *pattern = NULL;
+	const char *file = NULL;
+	struct stream stream = { NULL, 0 };
+	size_t nevents = 1000000;
+	unsigned int rate = 125;
+	double speed = 0.0;
+	int dpi = 1000;
+	size_t batch = 0;
+	const char *save_path = NULL;
+	const char *compare_path = NULL;
+	FILE *save = NULL;
+	FILE *compare = NULL;
+	double tolerance = 1e-9;
+	size_t i;
+	int rc = 0;
+
+	enum {
+		OPT_HELP = 1,
+		OPT_FILTER,
+		OPT_PATTERN,
+		OPT_FILE,
+		OPT_NEVENTS,
+		OPT_RATE,
+		OPT_SPEED,
+		OPT_DPI,
+		OPT_BATCH,
+		OPT_SAVE,
+		OPT_COMPARE,
+		OPT_TOLERANCE,
+	};
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		static struct option long_options[] = {
+			{"help", 0, 0, OPT_HELP },
+			{"filter", 1, 0, OPT_FILTER },
+			{"pattern", 1, 0, OPT_PATTERN },
+			{"file", 1, 0, OPT_FILE },
+			{"nevents", 1, 0, OPT_NEVENTS },
+			{"rate", 1, 0, OPT_RATE },
+			{"speed", 1, 0, OPT_SPEED },
+			{"dpi", 1, 0, OPT_DPI },
+			{"batch", 1, 0, OPT_BATCH },
+			{"save", 1, 0, OPT_SAVE },
+			{"compare", 1, 0, OPT_COMPARE },
+			{"tolerance", 1, 0, OPT_TOLERANCE },
+			{0, 0, 0, 0}
+		};
+
+		c = getopt_long(argc, argv, "",
+				long_options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case OPT_HELP:
+			usage();
+			exit(0);
+			break;
+		case OPT_FILTER:
+			if (streq(optarg, "all")) {
+				nfilters = 0;
+				break;
+			}
+			if (nfilters == ARRAY_LENGTH(filters)) {
+				usage();
+				return 1;
+			}
+			filters[nfilters++] = optarg;
+			break;
+		case OPT_PATTERN:
+			pattern = optarg;
+			break;
+		case OPT_FILE:
+			file = optarg;
+			break;
+		case OPT_NEVENTS:
+			nevents = strtoul(optarg, NULL, 10);
+			if (nevents == 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case OPT_RATE:
+			rate = strtoul(optarg, NULL, 10);
+			if (rate == 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case OPT_SPEED:
+			speed = strtod(optarg, NULL);
+			break;
+		case OPT_DPI:
+			dpi = strtod(optarg, NULL);
+			break;
+		case OPT_BATCH:
+			batch = strtoul(optarg, NULL, 10);
+			break;
+		case OPT_SAVE:
+			save_path = optarg;
+			break;
+		case OPT_COMPARE:
+			compare_path = optarg;
+			break;
+		case OPT_TOLERANCE:
+			tolerance = strtod(optarg, NULL);
+			break;
+		default:
+			usage();
+			exit(1);
+			break;
+		}
+	}
+
+	if (nfilters == 0) {
+		memcpy(filters, all_filters, sizeof(all_filters));
+		nfilters = ARRAY_LENGTH(all_filters);
+	}
+
+	if (file && pattern) {
+		usage();
+		return 1;
+	}
+
+	if (file) {
+		FILE *fp = streq(file, "-") ? stdin : fopen(file, "r");
+		bool have_events;
+
+		if (!fp) {
+			fprintf(stderr,
+				"Failed to open %s: %s\n",
+				file,
+				strerror(errno));
+			return 1;
+		}
+
+		have_events = stream_read(&stream, fp, us(1000000/rate));
+		if (fp != stdin)
+			fclose(fp);
+
+		if (!have_events) {
+			fprintf(stderr, "No motion events in %s\n", file);
+			return 1;
+		}
+	} else if (!stream_create_synthetic(&stream,
+					    pattern ? pattern : "sweep",
+					    min(nevents, 100000),
+					    us(1000000/rate))) {
+		fprintf(stderr, "Invalid pattern %s\n", pattern);
+		return 1;
+	}
+
+	if (save_path) {
+		save = fopen(save_path, "w");
+		if (!save) {
+			fprintf(stderr,
+				"Failed to open %s: %s\n",
+				save_path,
+				strerror(errno));
+			free(stream.motions);
+			return 1;
+		}
+	}
+
+	if (compare_path) {
+		compare = fopen(compare_path, "r");
+		if (!compare) {
+			fprintf(stderr,
+				"Failed to open %s: %s\n",
+				compare_path,
+				strerror(errno));
+			if (save)
+				fclose(save);
+			free(stream.motions);
+			return 1;
+		}
+	}
+
+	printf("# %zu events at %uHz, %d dpi, speed %.2f, batch %zu\n",
+	       nevents, rate, dpi, speed, batch);
+	printf("%-12s %10s %10s %8s %s\n",
+	       "# filter", "events", "ns/event", "allocs", "max-error");
+
+	for (i = 0; i < nfilters; i++) {
+		if (!run_benchmark(filters[i],
+				   &stream,
+				   nevents,
+				   batch,
+				   dpi,
+				   speed,
+				   save,
+				   compare,
+				   tolerance))
+			rc = 1;
+	}
+
+	if (save)
+		fclose(save);
+	if (compare)
+		fclose(compare);
+	free(stream.motions);
+
+	return rc;
+}
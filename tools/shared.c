@@ -42,6 +42,7 @@ enum options {
 	OPT_GRAB,
 	OPT_HELP,
 	OPT_VERBOSE,
+	OPT_SHOW_LATENCY,
 	OPT_TAP_ENABLE,
 	OPT_TAP_DISABLE,
 	OPT_TAP_MAP,
@@ -57,11 +58,14 @@ enum options {
 	OPT_MIDDLEBUTTON_DISABLE,
 	OPT_DWT_ENABLE,
 	OPT_DWT_DISABLE,
+	OPT_MOTION_SMOOTHING_ENABLE,
+	OPT_MOTION_SMOOTHING_DISABLE,
 	OPT_CLICK_METHOD,
 	OPT_SCROLL_METHOD,
 	OPT_SCROLL_BUTTON,
 	OPT_SPEED,
 	OPT_PROFILE,
+	OPT_PREDICTION,
 };
 
 LIBINPUT_ATTRIBUTE_PRINTF(3, 0)
@@ -97,12 +101,15 @@ tools_usage(void)
 	       "--disable-middlebutton.... enable/disable middle button emulation\n"
 	       "--enable-dwt\n"
 	       "--disable-dwt..... enable/disable disable-while-typing\n"
+	       "--enable-motion-smoothing\n"
+	       "--disable-motion-smoothing..... enable/disable velocity-adaptive motion smoothing\n"
 	       "--set-click-method=[none|clickfinger|buttonareas] .... set the desired click method\n"
 	       "--set-scroll-method=[none|twofinger|edge|button] ... set the desired scroll method\n"
 	       "--set-scroll-button=BTN_MIDDLE ... set the button to the given button code\n"
 	       "--set-profile=[adaptive|flat].... set pointer acceleration profile\n"
 	       "--set-speed=<value>.... set pointer acceleration speed (allowed range [-1, 1]) \n"
 	       "--set-tap-map=[lrm|lmr] ... set button mapping for tapping\n"
+	       "--set-prediction=<ms>.... set the motion prediction look-ahead (allowed range [0, 50])\n"
 	       "\n"
 	       "These options apply to all applicable devices, if a feature\n"
 	       "is not explicitly specified it is left at each device's default.\n"
@@ -110,6 +117,8 @@ tools_usage(void)
 	       "Other options:\n"
 	       "--grab .......... Exclusively grab all openend devices\n"
 	       "--verbose ....... Print debugging output.\n"
+	       "--show-latency .. Print per-device latency histograms when\n"
+	       "                  a device is removed or on exit.\n"
 	       "--help .......... Print this help.\n",
 		program_invocation_short_name);
 }
@@ -130,6 +139,8 @@ tools_init_context(struct tools_context *context)
 	options->left_handed = -1;
 	options->middlebutton = -1;
 	options->dwt = -1;
+	options->motion_smoothing = -1;
+	options->prediction = -1;
 	options->click_method = -1;
 	options->scroll_method = -1;
 	options->scroll_button = -1;
@@ -153,6 +164,7 @@ tools_parse_args(int argc, char **argv, struct tools_context *context)
 			{ "grab", 0, 0, OPT_GRAB },
 			{ "help", 0, 0, OPT_HELP },
 			{ "verbose", 0, 0, OPT_VERBOSE },
+			{ "show-latency", 0, 0, OPT_SHOW_LATENCY },
 			{ "enable-tap", 0, 0, OPT_TAP_ENABLE },
 			{ "disable-tap", 0, 0, OPT_TAP_DISABLE },
 			{ "enable-drag", 0, 0, OPT_DRAG_ENABLE },
@@ -167,12 +179,15 @@ tools_parse_args(int argc, char **argv, struct tools_context *context)
 			{ "disable-middlebutton", 0, 0, OPT_MIDDLEBUTTON_DISABLE },
 			{ "enable-dwt", 0, 0, OPT_DWT_ENABLE },
 			{ "disable-dwt", 0, 0, OPT_DWT_DISABLE },
+			{ "enable-motion-smoothing", 0, 0, OPT_MOTION_SMOOTHING_ENABLE },
+			{ "disable-motion-smoothing", 0, 0, OPT_MOTION_SMOOTHING_DISABLE },
 			{ "set-click-method", 1, 0, OPT_CLICK_METHOD },
 			{ "set-scroll-method", 1, 0, OPT_SCROLL_METHOD },
 			{ "set-scroll-button", 1, 0, OPT_SCROLL_BUTTON },
 			{ "set-profile", 1, 0, OPT_PROFILE },
 			{ "set-tap-map", 1, 0, OPT_TAP_MAP },
 			{ "set-speed", 1, 0, OPT_SPEED },
+			{ "set-prediction", 1, 0, OPT_PREDICTION },
 			{ 0, 0, 0, 0}
 		};
 
@@ -204,6 +219,9 @@ tools_parse_args(int argc, char **argv, struct tools_context *context)
 		case OPT_VERBOSE:
 			options->verbose = 1;
 			break;
+		case OPT_SHOW_LATENCY:
+			options->show_latency = 1;
+			break;
 		case OPT_TAP_ENABLE:
 			options->tapping = 1;
 			break;
@@ -260,6 +278,12 @@ tools_parse_args(int argc, char **argv, struct tools_context *context)
 		case OPT_DWT_DISABLE:
 			options->dwt = LIBINPUT_CONFIG_DWT_DISABLED;
 			break;
+		case OPT_MOTION_SMOOTHING_ENABLE:
+			options->motion_smoothing = LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED;
+			break;
+		case OPT_MOTION_SMOOTHING_DISABLE:
+			options->motion_smoothing = LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED;
+			break;
 		case OPT_CLICK_METHOD:
 			if (!optarg) {
 				tools_usage();
@@ -323,6 +347,19 @@ tools_parse_args(int argc, char **argv, struct tools_context *context)
 			}
 			options->speed = atof(optarg);
 			break;
+		case OPT_PREDICTION:
+			if (!optarg) {
+				tools_usage();
+				return 1;
+			}
+			options->prediction = atoi(optarg);
+			if (options->prediction < 0) {
+				fprintf(stderr,
+					"Invalid prediction look-ahead %s\n",
+					optarg);
+				return 1;
+			}
+			break;
 		case OPT_PROFILE:
 			if (!optarg) {
 				tools_usage();
@@ -490,6 +527,14 @@ tools_device_apply_config(struct libinput_device *device,
 	if (options->dwt != -1)
 		libinput_device_config_dwt_set_enabled(device, options->dwt);
 
+	if (options->motion_smoothing != -1)
+		libinput_device_config_motion_smoothing_set_enabled(device,
+								    options->motion_smoothing);
+
+	if (options->prediction != -1)
+		libinput_device_config_prediction_set_lookahead(device,
+								options->prediction);
+
 	if (options->click_method != (enum libinput_config_click_method)-1)
 		libinput_device_config_click_set_method(device, options->click_method);
 
@@ -38,6 +38,7 @@ struct tools_options {
 	int grab; /* EVIOCGRAB */
 
 	int verbose;
+	int show_latency;
 	int tapping;
 	int drag;
 	int drag_lock;
@@ -50,6 +51,8 @@ struct tools_options {
 	int scroll_button;
 	double speed;
 	int dwt;
+	int motion_smoothing;
+	int prediction;
 	enum libinput_config_accel_profile profile;
 };
 
@@ -0,0 +1,353 @@
+/*
+ * Copyright © 2017 Red Hat, Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <libevdev/libevdev.h>
+#include <libevdev/libevdev-uinput.h>
+#include <libinput.h>
+
+#include "libinput-util.h"
+#include "bench.h"
+
+/* device units per mm */
+#define RESOLUTION 40
+/* unaccelerated deltas are normalized to 1000dpi */
+#define NORMALIZED_TO_MM (25.4/1000)
+
+/* A trace is a finger moving along the x axis at constant speed, with
+ * sensor noise on both axes */
+struct trace {
+	const char *name;
+	double speed; /* mm/s */
+	double noise; /* mm, peak */
+};
+
+static const struct trace traces[] = {
+	{ "swipe", 300.0, 0.1 },
+	{ "precise", 10.0, 0.2 },
+};
+
+struct result {
+	double lag; /* mm, mean distance behind the finger */
+	double jitter; /* mm, rms error of the per-frame deltas */
+};
+
+static struct libinput *
+create_context(struct libevdev_uinput *uinput, bool smoothing)
+{
+	struct libinput *li;
+	struct libinput_device *device;
+
+	li = bench_create_context(uinput, &device);
+	if (!li)
+		return NULL;
+
+	if (!libinput_device_config_motion_smoothing_is_available(device)) {
+		fprintf(stderr, "Motion smoothing is not available\n");
+		libinput_unref(li);
+		return NULL;
+	}
+
+	libinput_device_config_tap_set_enabled(device,
+					       LIBINPUT_CONFIG_TAP_DISABLED);
+	libinput_device_config_motion_smoothing_set_enabled(device,
+		smoothing ? LIBINPUT_CONFIG_MOTION_SMOOTHING_ENABLED :
+			    LIBINPUT_CONFIG_MOTION_SMOOTHING_DISABLED);
+
+	bench_drain_events(li);
+
+	return li;
+}
+
+/* deterministic noise in [-1, 1] so both runs replay the same trace */
+static double
+noise(unsigned int *state)
+{
+	*state = *state * 1103515245 + 12345;
+
+	return ((*state >> 16) & 0x7fff) / (double)0x3fff - 1.0;
+}
+
+static void
+write_touch(struct libevdev_uinput *uinput,
+	    double x_mm,
+	    double y_mm,
+	    bool down)
+{
+	int x = x_mm * RESOLUTION,
+	    y = y_mm * RESOLUTION;
+
+	if (down) {
+		libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_SLOT, 0);
+		libevdev_uinput_write_event(uinput,
+					    EV_ABS,
+					    ABS_MT_TRACKING_ID,
+					    1);
+	}
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_POSITION_X, x);
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_POSITION_Y, y);
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_X, x);
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_Y, y);
+	if (down) {
+		libevdev_uinput_write_event(uinput, EV_KEY, BTN_TOUCH, 1);
+		libevdev_uinput_write_event(uinput, EV_KEY, BTN_TOOL_FINGER, 1);
+	}
+	libevdev_uinput_write_event(uinput, EV_SYN, SYN_REPORT, 0);
+}
+
+static void
+write_touch_up(struct libevdev_uinput *uinput)
+{
+	libevdev_uinput_write_event(uinput, EV_ABS, ABS_MT_TRACKING_ID, -1);
+	libevdev_uinput_write_event(uinput, EV_KEY, BTN_TOUCH, 0);
+	libevdev_uinput_write_event(uinput, EV_KEY, BTN_TOOL_FINGER, 0);
+	libevdev_uinput_write_event(uinput, EV_SYN, SYN_REPORT, 0);
+}
+
+static void
+wait_for_frame(struct timespec *next, unsigned int interval_ms)
+{
+	next->tv_nsec += interval_ms * 1000000;
+	if (next->tv_nsec >= 1000000000) {
+		next->tv_sec++;
+		next->tv_nsec -= 1000000000;
+	}
+
+	while (clock_nanosleep(CLOCK_MONOTONIC,
+			       TIMER_ABSTIME,
+			       next,
+			       NULL) == EINTR)
+		;
+}
+
+/* @return the unaccelerated x/y motion in mm since the last call */
+static void
+collect_motion(struct libinput *li, double *dx, double *dy)
+{
+	struct libinput_event *event;
+	struct libinput_event_pointer *p;
+
+	*dx = 0.0;
+	*dy = 0.0;
+
+	libinput_dispatch(li);
+	while ((event = libinput_get_event(li))) {
+		if (libinput_event_get_type(event) ==
+		    LIBINPUT_EVENT_POINTER_MOTION) {
+			p = libinput_event_get_pointer_event(event);
+			*dx += libinput_event_pointer_get_dx_unaccelerated(p) *
+				NORMALIZED_TO_MM;
+			*dy += libinput_event_pointer_get_dy_unaccelerated(p) *
+				NORMALIZED_TO_MM;
+		}
+		libinput_event_destroy(event);
+	}
+}
+
+static bool
+run_trace(struct libevdev_uinput *uinput,
+	  const struct trace *trace,
+	  bool smoothing,
+	  unsigned int nframes,
+	  unsigned int interval_ms,
+	  struct result *result)
+{
+	struct libinput *li;
+	struct timespec next;
+	unsigned int seed = 1;
+	unsigned int i;
+	double step = trace->speed * interval_ms / 1000.0;
+	double start_x = 10.0, start_y = 35.0;
+	double x, y, dx, dy;
+	double out_x = 0.0, out_y = 0.0;
+	double lag = 0.0, error = 0.0;
+
+	/* keep the finger on the touchpad and away from the edges, fast
+	 * traces are cut short */
+	nframes = min(nframes, (unsigned int)(80.0 / step));
+
+	li = create_context(uinput, smoothing);
+	if (!li)
+		return false;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+
+	write_touch(uinput, start_x, start_y, true);
+	wait_for_frame(&next, interval_ms);
+	collect_motion(li, &dx, &dy);
+
+	for (i = 1; i <= nframes; i++) {
+		x = start_x + step * i + noise(&seed) * trace->noise;
+		y = start_y + noise(&seed) * trace->noise;
+		write_touch(uinput, x, y, false);
+
+		/* the events carry the kernel timestamps, replaying in real
+		 * time gives libinput the speed of the trace */
+		wait_for_frame(&next, interval_ms);
+		collect_motion(li, &dx, &dy);
+
+		out_x += dx;
+		out_y += dy;
+		lag += step * i - out_x;
+		error += (dx - step) * (dx - step) + dy * dy;
+	}
+
+	write_touch_up(uinput);
+	collect_motion(li, &dx, &dy);
+
+	result->lag = lag / nframes;
+	result->jitter = sqrt(error / nframes);
+
+	libinput_unref(li);
+
+	return true;
+}
+
+static void
+print_result(const char *name,
+	     const struct trace *trace,
+	     const struct result *r)
+{
+	printf("%-10s %-10s %10.2f %10.2f %10.3f\n",
+	       trace->name,
+	       name,
+	       r->lag,
+	       r->lag / trace->speed * 1000.0,
+	       r->jitter);
+}
+
+static void
+usage(void)
+{
+	printf("Usage: %s [options]\n", program_invocation_short_name);
+	printf("\n"
+	       "Replays a fast swipe and a slow, precise movement through a\n"
+	       "uinput touchpad, once with the fixed motion history and once\n"
+	       "with velocity-adaptive motion smoothing, and prints how far\n"
+	       "the unaccelerated motion lags behind the finger and how much\n"
+	       "the per-frame motion deviates from the finger's (jitter).\n"
+	       "The traces are replayed in real time.\n"
+	       "This tool needs permission to create uinput devices.\n"
+	       "\n"
+	       "Options:\n"
+	       "--nframes=<int>	... max frames per trace (default: 100)\n"
+	       "--interval=<int>	... ms between frames (default: 12)\n");
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned int nframes = 100;
+	unsigned int interval = 12;
+	struct libevdev_uinput *uinput;
+	struct result fixed, smoothed;
+	size_t i;
+	int rc = 1;
+
+	enum {
+		OPT_HELP = 1,
+		OPT_NFRAMES,
+		OPT_INTERVAL,
+	};
+
+	while (1) {
+		int c;
+		int option_index = 0;
+		static struct option long_options[] = {
+			{"help", 0, 0, OPT_HELP },
+			{"nframes", 1, 0, OPT_NFRAMES },
+			{"interval", 1, 0, OPT_INTERVAL },
+			{0, 0, 0, 0}
+		};
+
+		c = getopt_long(argc, argv, "",
+				long_options, &option_index);
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case OPT_HELP:
+			usage();
+			exit(0);
+			break;
+		case OPT_NFRAMES:
+			nframes = strtoul(optarg, NULL, 10);
+			if (nframes == 0) {
+				usage();
+				return 1;
+			}
+			break;
+		case OPT_INTERVAL:
+			interval = strtoul(optarg, NULL, 10);
+			if (interval == 0 || interval > 100) {
+				usage();
+				return 1;
+			}
+			break;
+		default:
+			usage();
+			exit(1);
+			break;
+		}
+	}
+
+	uinput = bench_create_touchpad("libinput smoothing-bench touchpad",
+				       2, 100, 70, RESOLUTION);
+	if (!uinput)
+		return 1;
+
+	/* let udev pick up the device before libinput opens it */
+	usleep(100000);
+
+	printf("# %u frames, %u ms per frame\n", nframes, interval);
+	printf("%-10s %-10s %10s %10s %10s\n",
+	       "# trace", "history", "lag (mm)", "lag (ms)", "jitter (mm)");
+
+	for (i = 0; i < ARRAY_LENGTH(traces); i++) {
+		if (!run_trace(uinput, &traces[i], false,
+			       nframes, interval, &fixed) ||
+		    !run_trace(uinput, &traces[i], true,
+			       nframes, interval, &smoothed))
+			goto out;
+
+		print_result("fixed", &traces[i], &fixed);
+		print_result("adaptive", &traces[i], &smoothed);
+	}
+
+	rc = 0;
+out:
+	libevdev_uinput_destroy(uinput);
+
+	return rc;
+}